@@ -8,7 +8,9 @@ C_SRCS += \
 ../control_ecu.c \
 ../dcmotor.c \
 ../external_eeprom.c \
+../frame.c \
 ../gpio.c \
+../scheduler.c \
 ../timer.c \
 ../twi.c \
 ../uart.c 
@@ -18,7 +20,9 @@ OBJS += \
 ./control_ecu.o \
 ./dcmotor.o \
 ./external_eeprom.o \
+./frame.o \
 ./gpio.o \
+./scheduler.o \
 ./timer.o \
 ./twi.o \
 ./uart.o 
@@ -28,7 +32,9 @@ C_DEPS += \
 ./control_ecu.d \
 ./dcmotor.d \
 ./external_eeprom.d \
+./frame.d \
 ./gpio.d \
+./scheduler.d \
 ./timer.d \
 ./twi.d \
 ./uart.d 
@@ -30,8 +30,8 @@
  ********************************************************************************************/
 void BUZZER_init(void)
 {
-	GPIO_setupPinDirection(BUZZER_PORT_ID, BUZZER_PIN_ID, PIN_OUTPUT);
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
+	GPIO_WRITE_PORT_MASKED(BUZZER_PORT_ID, BUZZER_PIN_MASK, LOGIC_LOW);
+	GPIO_SETUP_PORT_DIRECTION_MASKED(BUZZER_PORT_ID, BUZZER_PIN_MASK, PORT_OUTPUT);
 }
 
 
@@ -49,7 +49,7 @@ void BUZZER_init(void)
  ********************************************************************************************/
 void BUZZER_on(void)
 {
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_HIGH);
+	GPIO_WRITE_PORT_MASKED(BUZZER_PORT_ID, BUZZER_PIN_MASK, BUZZER_PIN_MASK);
 }
 
 
@@ -68,5 +68,5 @@ void BUZZER_on(void)
  ********************************************************************************************/
 void BUZZER_off(void)
 {
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
+	GPIO_WRITE_PORT_MASKED(BUZZER_PORT_ID, BUZZER_PIN_MASK, LOGIC_LOW);	/* Called by the timer ISR too */
 }
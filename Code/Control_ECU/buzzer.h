@@ -23,6 +23,7 @@
 
 #define BUZZER_PORT_ID				PORTA_ID
 #define BUZZER_PIN_ID				PIN0_ID
+#define BUZZER_PIN_MASK				(1<<BUZZER_PIN_ID)
 
 
 /*******************************************************************************
@@ -19,25 +19,30 @@
 #include "external_eeprom.h"
 #include "twi.h"
 #include "uart.h"
+#include "frame.h"
+#include "scheduler.h"
 #include "control_ecu.h"
 #include <avr/io.h>
-#include <avr/delay.h>
 
 
 int main(void)
 {
-	uint8 receivedByte = 0;
+	/* Tasks of the scheduler, in the order of their IDs (priority) */
+	static const SCHEDULER_TaskType tasks[CTRL_NUM_OF_TASKS] = {CTRL_commandTask, CTRL_timersTask};
 
 	SREG |= (1<<7); /* Enable I-Bit for Interrupts*/
 
+	/* Create configuration structure for Timer driver (before UART, it is the time base of
+	 * the UART timeouts) */
+	Timer_ConfigType TIMER_Config = {TIMER1, COMPARE,0,TIMER_TICK_COMPARE_VALUE,CLK_64};
+	Timer_init(&TIMER_Config);		/* Initialize Timer driver */
+	Timer_subscribe(TIMER1, UART_tick);	/* The UART time of the receive timeouts */
+	Timer_subscribe(TIMER1, Timer_CallBackFunction);
+
 	/* Create configuration structure for UART driver */
-	UART_ConfigType UART_Config = {EIGHT_BIT,DISABLED,ONT_BIT,9600};
+	UART_ConfigType UART_Config = {EIGHT_BIT,DISABLED,ONT_BIT,UART_DEFAULT_BAUD_RATE};
 	UART_init(&UART_Config);		/* Initialize UART driver */
-
-	/* Create configuration structure for Timer driver */
-	Timer_ConfigType TIMER_Config = {TIMER1, COMPARE,0,7812,CLK_1024};
-	Timer_init(&TIMER_Config);		/* Initialize Timer driver */
-	Timer_setCallBack(Timer_CallBackFunction,TIMER1);
+	FRAME_acceptBaudRate();			/* Agree with the HMI ECU on the fastest baud rate */
 
 	/* Create configuration structure for I2C driver */
 	TWI_ConfigType TWI_Config = {0x02,FAST_MODE};
@@ -47,120 +52,354 @@ int main(void)
 
 	DcMotor_Init();					/*Initialize the DcMotor */
 
-	CTRL_takeFirstPassword();		/* Receive the password and confirmation password from the
-	 	 	 	 	 	 	 	 	   the HMI ECU */
+	/* The commands and the expiries of the software timers (door and buzzer alarm) are served
+	 * by the tasks, without waiting: the commands are served during the door cycle too. The
+	 * CPU sleeps between them */
+	SCHEDULER_init(tasks, CTRL_NUM_OF_TASKS, CTRL_idle);
+#if (UART_MULTIDROP_ENABLE == FALSE)
+	UART_setLineErrorCallBack(CTRL_lineErrorCallBack);	/* The HMI ECU may be reset alone */
+#endif
+	SCHEDULER_setReady(CTRL_TASK_COMMAND);	/* Request the first command frame */
+	SCHEDULER_run();
+}
+
 
-	while(1)
+/********************************************************************************************
+ * 									Function Definitions									*
+ ********************************************************************************************/
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_commandTask
+ *
+ * [Description]: This function is the task of the commands, it is made ready by the frame
+ * 				  receive (CTRL_frameCallBack), by the line errors (CTRL_lineErrorCallBack), at
+ * 				  the end of a baud rate exchange (CTRL_linkTimerCallBack) and, on the bus, by
+ * 				  every timer tick for the poll timeout. It executes the received commands and
+ * 				  requests the next frame (see CTRL_pollCommand).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_commandTask(void)
+{
+	uint8 receivedOption;
+
+	/* Until the next frame is requested: a frame already received (or not a command) gives
+	 * back the request at once */
+	do
 	{
-		while(UART_recieveByte() != READY_TO_SEND); /* Receive from HMI to be ready to receive */
-		UART_sendByte(READY_TO_RECEIVE); /* Inform HMI to start sending */
-		CTRL_receivePasswordByUART(g_receivedPassword); /* Receive the password from HMI ECU */
+		receivedOption = CTRL_pollCommand();
+		if(receivedOption != NO_COMMAND)
+		{
+			CTRL_executeCommand(receivedOption);
+		}
+	}while((g_commandRequested == FALSE) && (Timer_isSoftTimerActive(&g_linkTimer) == FALSE));
+}
+
+
 
-		receivedByte = UART_recieveByte(); /* Receive the selected option (select to open the door
-											  or to change the password) */
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_executeCommand
+ *
+ * [Description]: This function is responsible for executing one command of the HMI micro-
+ * 				  controller (g_command) and sending its reply. Until the first password is
+ * 				  saved, the other commands are answered with NO_PASSWORD.
+ *
+ * [Arguments]: uint8 a_option
+ *
+ * [in]: a_option: The selected option
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_executeCommand(uint8 a_option)
+{
+	/* Only the first password is accepted after the reset, the HMI ECU (not reset with this
+	 * ECU) is told to take it again */
+	if((g_passwordSaved == FALSE) && (a_option != NEW_PASSWORD_OPTION)
+			&& (a_option != TRACE_DUMP_OPTION))
+	{
+		CTRL_sendReply(NO_PASSWORD);
+		return;
+	}
+
+	/* The new password is allowed only just after the change password command */
+	if(a_option != NEW_PASSWORD_OPTION)
+	{
+		g_panels[g_panel].passwordChangeAllowed = FALSE;
+	}
 
-		switch(receivedByte)
+	switch(a_option)
+	{
+	case DOOR_OPEN_OPTION:
+		if(Timer_isSoftTimerActive(&g_alarmTimer) == TRUE)
 		{
-		case DOOR_OPEN_OPTION:
-			/* Checking if the received password and stored password in EEPROM identical or not */
-			if(CTRL_verifyPassword(g_storedPassword, g_receivedPassword) == SUCCESS)
-			{
-				UART_sendByte(READY_TO_RECEIVE); /* Inform HMI ECU to be ready to receive */
-				UART_sendByte(OPEN_DOOR);		/* Sending to HMI ECU to open the door */
-				CTRL_openingDoor();	/* Start opening the door */
-			}
-			else
+			CTRL_sendReply(THIEF_IS_DETECTED);	/* The system is closed during the alarm */
+		}
+		/* Checking if the received password and stored password in EEPROM identical or not */
+		else if(CTRL_verifyPassword(g_storedPassword, g_command.password) == SUCCESS)
+		{
+			CTRL_sendReply(OPEN_DOOR);		/* Sending to HMI ECU to open the door */
+			CTRL_doorOpen();	/* Start opening the door */
+		}
+		else
+		{
+			CTRL_sendReply(WRONG_PASSWORD);	/* Sending to HMI ECU that the password wrong */
+			g_wrongTrial++;		/* Increment the counter for wrong attempts */
+			if(g_wrongTrial == MAX_ALLOWED_TRIALS)
 			{
-				UART_sendByte(READY_TO_RECEIVE); /* Inform HMI ECU to be ready to receive */
-				UART_sendByte(WRONG_PASSWORD);	/* Sending to HMI ECU that the password wrong */
-				g_wrongTrial++;		/* Increment the counter for wrong attempts */
-				if(g_wrongTrial == MAX_ALLOWED_TRIALS)
-				{
-					BUZZER_on(); /* Turn on the Buzzer */
-					g_seconds = 0;
-					while(g_seconds != BUZZER_ACTIVE_PERIOD);
-					BUZZER_off();
-					g_wrongTrial = 0;		/* reset the number of trials */
-				}
+				BUZZER_on(); /* Turn on the Buzzer, the alarm timer turns it off */
+				Timer_startSoftTimer(&g_alarmTimer, BUZZER_ACTIVE_PERIOD * TICKS_PER_SECOND,
+						0, CTRL_alarmEnd);
+				g_wrongTrial = 0;		/* reset the number of trials */
 			}
-			break;
+		}
+		break;
 
-		case CHANGE_PASSWORD_OPTION:
-			/* Checking if the received password and stored password in EEPROM identical or not */
-			if(CTRL_verifyPassword(g_storedPassword, g_receivedPassword) == SUCCESS)
-			{
-				UART_sendByte(READY_TO_RECEIVE); /* Inform the HMI ECU to be ready to receive */
+	case CHANGE_PASSWORD_OPTION:
+		if(Timer_isSoftTimerActive(&g_alarmTimer) == TRUE)
+		{
+			CTRL_sendReply(THIEF_IS_DETECTED);	/* The system is closed during the alarm */
+		}
+		/* Checking if the received password and stored password in EEPROM identical or not */
+		else if(CTRL_verifyPassword(g_storedPassword, g_command.password) == SUCCESS)
+		{
+			CTRL_sendReply(CHANGING_PASSWORD); /* Send to HMI that password correct and allow the
+			 	 	 	 	 	 	 	 	     the user to change the password */
+			g_panels[g_panel].passwordChangeAllowed = TRUE;	/* Wait the new password */
+		}
+		else
+		{
+			CTRL_sendReply(WRONG_PASSWORD); /* Send to HMI that password incorrect */
+		}
+		break;
 
-				UART_sendByte(CHANGING_PASSWORD); /* Send to HMI that password correct and allow the
-				 	 	 	 	 	 	 	 	     the user to change the password */
-				CTRL_takeFirstPassword(); /* Receive the new password from the user */
+	case NEW_PASSWORD_OPTION:
+		if(g_passwordSaved == FALSE)
+		{
+			/* Keep taking the first password until the two passwords are identical */
+			if(CTRL_setNewPassword() == SUCCESS)
+			{
+				g_passwordSaved = TRUE;
 			}
-			else
+		}
+		else if(g_panels[g_panel].passwordChangeAllowed == TRUE)
+		{
+			/* Keep allowing the new password until the two passwords are identical */
+			if(CTRL_setNewPassword() == SUCCESS)
 			{
-				UART_sendByte(READY_TO_RECEIVE); /* Inform the HMI ECU to be ready to receive */
-
-				UART_sendByte(WRONG_PASSWORD); /* Send to HMI that password incorrect */
+				g_panels[g_panel].passwordChangeAllowed = FALSE;
 			}
-			break;
 		}
+		else
+		{
+			CTRL_sendReply(WRONG_PASSWORD); /* The old password is not checked */
+		}
+		break;
+
+	case DOOR_STATUS_OPTION:
+		CTRL_sendReply(g_doorState);
+		break;
+
+	case DOOR_CLOSE_OPTION:
+		CTRL_doorClose();
+		CTRL_sendReply(g_doorState);	/* A closed door stays closed */
+		break;
+
+	case TRACE_DUMP_OPTION:
+		UART_sendAddress(CTRL_PANEL_ADDRESS(g_panel));	/* Bus: to the asking panel */
+		UART_traceDump();
+		CTRL_sendReply(SUCCESS);	/* End of the dump */
+		break;
 	}
 
 }
 
 
+
 /********************************************************************************************
- * 									Function Definitions									*
+ *
+ * [Function Name]: CTRL_timersTask
+ *
+ * [Description]: This function is the task of the software timers, it is made ready by the
+ * 				  timer tick when timers expired and calls their call backs (door phases and
+ * 				  buzzer alarm).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
  ********************************************************************************************/
+void CTRL_timersTask(void)
+{
+	Timer_dispatchSoftTimers();
+}
+
+
 
 /********************************************************************************************
  *
- * [Function Name]: CTRL_takeFirstPassword
+ * [Function Name]: CTRL_idle
  *
- * [Description]:- This function is responsible for receiving the passwords form the HMI micro-
- * 				   controller and store it in global array (g_receivedPassword).
- * 				 - Also This function check the passwords received from the HMI micro-controller
- * 				   if both password identical it send Password match to HMI micro-controller to
- * 				   inform that the password saved.
+ * [Description]: This function is the idle hook of the scheduler (interrupts disabled), the
+ * 				  CPU sleeps until the next interrupt (UART RX, Timer1 compare or TWI). While
+ * 				  the link is idle the timer ticks are skipped up to the next door phase or
+ * 				  alarm end (tickless idle), the wake up ends the skip at the next tick.
  *
  * [Arguments]: None
  *
  * [in]: void
  *
+ * [out]: void
+ *
  * [Returns]: void
  *
  ********************************************************************************************/
-void CTRL_takeFirstPassword(void)
+void CTRL_idle(void)
 {
-	uint8 verify;
+#if (UART_MULTIDROP_ENABLE == FALSE)
+	/* The gap between the bytes of a frame needs the ticks (on the bus, the poll timeout of
+	 * the command task needs them all the time) */
+	if(UART_isFrameInProgress() == FALSE)
+	{
+		Timer_startTickless();
+	}
+#endif
+	SCHEDULER_sleep();
+	Timer_stopTickless();
+}
+
 
-	uint8 confirmationPassword[PASSWORD_LENGTH]; /* To store second received password */
-	while(1)
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_frameCallBack
+ *
+ * [Description]: This function is called by the RX ISR when a frame is received in g_command,
+ * 				  it makes the task of the commands ready.
+ *
+ * [Arguments]: uint8 a_type, uint8 a_length
+ *
+ * [in]: - a_type: The type of the received frame
+ * 		 - a_length: The payload length of the received frame
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_frameCallBack(uint8 a_type, uint8 a_length)
+{
+	(void)a_type;
+	(void)a_length;
+	SCHEDULER_setReady(CTRL_TASK_COMMAND);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_lineErrorCallBack
+ *
+ * [Description]: This function is called by the RX ISR for each line error, it makes the task
+ * 				  of the commands ready when the line errors in a row are enough to go back to
+ * 				  the default baud rate (see FRAME_recoverBaudRate).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_lineErrorCallBack(void)
+{
+	if(UART_getLineErrors() == FRAME_RESYNC_LINE_ERRORS)
 	{
-		while (UART_recieveByte() != READY_TO_SEND);
-		UART_sendByte(READY_TO_RECEIVE);		/* Tell the other HMI controller than control micro-controller
-													ready to receive the password */
-		CTRL_receivePasswordByUART(g_receivedPassword);		/*Receive the first password from HMI micro-controller*/
+		SCHEDULER_setReady(CTRL_TASK_COMMAND);
+	}
+}
 
-		while (UART_recieveByte() != READY_TO_SEND);
-		UART_sendByte(READY_TO_RECEIVE);		/* Tell the other HMI controller than control micro-controller
-															ready to receive the password */
-		CTRL_receivePasswordByUART(confirmationPassword);		/*Receive the second password (confirmation password) from HMI ECU*/
 
-		verify = CTRL_verifyPassword(g_receivedPassword,confirmationPassword); /* check if the received passwords are identical */
 
-		if(verify == SUCCESS)
-		{
-			UART_sendByte(READY_TO_SEND);
-			UART_sendByte(PASSWORD_MATCHED); /* Send password matched to HMI ECU */
-			CTRL_storePassword(); /* Store the password in EEPROM */
-			break; /* Exit from while loop */
-		}
-		else
-		{
-			UART_sendByte(READY_TO_SEND);
-			UART_sendByte(PASSWORD_UNMATCHED);	/* Send password unmatched to HMI ECU */
-		}
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_linkTimerCallBack
+ *
+ * [Description]: This function is the call back of the periodic software timer of a baud rate
+ * 				  exchange requested by the HMI ECU after the startup, it runs the next step of
+ * 				  the exchange every tick. At the end the timer is stopped and the task of the
+ * 				  commands requests the next command frame.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_linkTimerCallBack(void)
+{
+	if(FRAME_serviceBaudRate() == FALSE)
+	{
+		Timer_cancelSoftTimer(&g_linkTimer);
+		SCHEDULER_setReady(CTRL_TASK_COMMAND);
+	}
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_setNewPassword
+ *
+ * [Description]: This function is responsible for checking the received password and its
+ * 				  confirmation (g_command), if both are identical it stores the password in
+ * 				  EEPROM. The result is sent to the HMI micro-controller.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: Unsigned Character
+ *
+ * [Returns]: SUCCESS if the password is saved, FAILED otherwise
+ *
+ ********************************************************************************************/
+uint8 CTRL_setNewPassword(void)
+{
+	uint8 verify;
+
+	verify = CTRL_verifyPassword(g_command.password,g_command.confirmation); /* check if the received passwords are identical */
+
+	if(verify == SUCCESS)
+	{
+		CTRL_sendReply(PASSWORD_MATCHED); /* Send password matched to HMI ECU */
+		CTRL_storePassword(); /* Store the password in EEPROM */
 	}
+	else
+	{
+		CTRL_sendReply(PASSWORD_UNMATCHED);	/* Send password unmatched to HMI ECU */
+	}
+	return verify;
 }
 
 
@@ -187,7 +426,12 @@ uint8 CTRL_verifyPassword(uint8 *a_firstPassword_Ptr, uint8 *a_secondPassword_Pt
 	uint8 correctPassword = SUCCESS;
 	uint8 i=0; /* Counter for for-loop */
 
-	CTRL_readStoredPassword(); /* To update the password with last stored password in EEPROM */
+	/* To update the password with last stored password in EEPROM, while the EEPROM is
+	 * written in background g_storedPassword is already the new password */
+	if(Timer_isSoftTimerActive(&g_eepromTimer) == FALSE)
+	{
+		CTRL_readStoredPassword();
+	}
 
 	for(i = 0; i<PASSWORD_LENGTH; i++)
 	{
@@ -204,28 +448,184 @@ uint8 CTRL_verifyPassword(uint8 *a_firstPassword_Ptr, uint8 *a_secondPassword_Pt
 
 /********************************************************************************************
  *
- * [Function Name]: CTRL_receivePasswordByUART
+ * [Function Name]: CTRL_pollCommand
+ *
+ * [Description]: This function is responsible for checking (without waiting) if one command
+ * 				  frame is received form the HMI micro-controller. The RX ISR receives the
+ * 				  frame directly in the global structure (g_command), the frame carries the
+ * 				  selected option and the password (and the confirmation password in case of
+ * 				  new password). The next frame is not required until the next call, so the
+ * 				  command must be executed before calling this function again.
+ * 				  Corrupted or incomplete frames are dropped. A retransmission of the last
+ * 				  command (its reply is lost) is answered again from the last reply without
+ * 				  returning it. A baud rate request of the HMI ECU (new negotiation) is
+ * 				  answered in background (CTRL_linkTimerCallBack), no frame is required until
+ * 				  the end of the exchange. After line errors in a row the default baud rate is
+ * 				  taken again.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: The selected option, NO_COMMAND if no new command is received
+ *
+ ********************************************************************************************/
+uint8 CTRL_pollCommand(void)
+{
+	CTRL_PanelType *panel_Ptr;
+	uint8 type;
+	uint8 length;
+
+	if(Timer_isSoftTimerActive(&g_linkTimer) == TRUE)
+	{
+		return NO_COMMAND;	/* The baud rate exchange takes the frames */
+	}
+
+	if(g_commandRequested == FALSE)
+	{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+		CTRL_pollNextPanel();
+#else
+		/* Let the RX ISR receive the next frame directly in g_command */
+		UART_receiveFrameInto((uint8 *)&g_command, sizeof(g_command), CTRL_frameCallBack);
+#endif
+		g_commandRequested = TRUE;
+	}
+
+	if(UART_isFrameReceived(&type, &length) == FALSE)
+	{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+		if(UART_TIME_ELAPSED(g_pollTime, BUS_POLL_TIMEOUT_MS))
+		{
+			/* No answer from the polled panel, poll the next one */
+			UART_cancelFrameReceive();
+			if(g_panels[g_panel].missedPolls < BUS_OFFLINE_POLLS)
+			{
+				g_panels[g_panel].missedPolls++;
+			}
+			g_commandRequested = FALSE;
+		}
+#else
+		/* The HMI ECU is talking at another baud rate after its reset alone */
+		FRAME_recoverBaudRate();
+#endif
+		return NO_COMMAND;
+	}
+	g_commandRequested = FALSE;
+
+	panel_Ptr = &g_panels[g_panel];
+	panel_Ptr->missedPolls = 0;
+
+#if (UART_MULTIDROP_ENABLE == FALSE)
+	/* The HMI ECU negotiates the baud rate again (reset or link lost), the payload byte is the
+	 * mask of the offered baud rates */
+	if((type == FRAME_TYPE_BAUD_REQUEST) && (length == 1))
+	{
+		FRAME_startBaudAnswer(((uint8 *)&g_command)[0]);
+		Timer_startSoftTimer(&g_linkTimer, 1, 1, CTRL_linkTimerCallBack);
+		return NO_COMMAND;
+	}
+#endif
+
+	/* Accept the command frames that carry at least the option and the password, and the
+	 * confirmation password in case of new password */
+	if((type != FRAME_TYPE_COMMAND) || (length < COMMAND_CONFIRMATION_INDEX)
+			|| ((g_command.option == NEW_PASSWORD_OPTION) && (length != COMMAND_MAX_LENGTH)))
+	{
+		return NO_COMMAND;
+	}
+
+	/* The HMI ECU didn't get the reply of the last command and sent it again, the command
+	 * must not be executed twice (e.g. counting a wrong trial two times) */
+	if((panel_Ptr->replyCached == TRUE) && (g_command.sequence == panel_Ptr->lastSequence)
+			&& (g_command.option == panel_Ptr->lastOption))
+	{
+		CTRL_sendReply(panel_Ptr->lastReply);
+		return NO_COMMAND;
+	}
+
+	panel_Ptr->lastSequence = g_command.sequence;
+	panel_Ptr->lastOption = g_command.option;
+	panel_Ptr->replyCached = FALSE;
+	return g_command.option;
+}
+
+
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_pollNextPanel
  *
- * [Description]: This function is responsible for receiving the password form the HMI micro-
- * 				  controller through UART serial communication.
+ * [Description]: This function is responsible for selecting the next HMI panel (round-robin)
+ * 				  and sending it a poll frame, the answer is received in g_command. The offline
+ * 				  panels (BUS_OFFLINE_POLLS polls without answer) are polled once every
+ * 				  BUS_OFFLINE_POLL_ROUNDS rounds only, so they don't slow down the others.
  *
- * [Arguments]: uint8 *password_Ptr
+ * [Arguments]: None
  *
- * [in]: *password_Ptr: pointer to character
+ * [in]: void
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void CTRL_receivePasswordByUART(uint8 *password_Ptr)
+void CTRL_pollNextPanel(void)
 {
-	uint8 counter; /* Counter to used in for loop */
-	for(counter = 0; counter<PASSWORD_LENGTH; counter++)
+	/* Ends in BUS_OFFLINE_POLL_ROUNDS rounds at most, even if all the panels are offline */
+	do
 	{
-		UART_sendByte(READY_TO_RECEIVE);	/* Tell HMI ECU that control ECU ready to receive data */
-		password_Ptr[counter] = UART_recieveByte(); 	/* Receive 1 Byte of the password from the HMI */
-	}
+		g_panel++;
+		if(g_panel == CTRL_NUM_OF_PANELS)
+		{
+			g_panel = 0;
+			g_pollRound++;
+		}
+	}while((g_panels[g_panel].missedPolls == BUS_OFFLINE_POLLS)
+			&& ((g_pollRound % BUS_OFFLINE_POLL_ROUNDS) != 0));
+
+	/* Receive the answer of this panel only: a late answer of the last panel is dropped by
+	 * the hardware, its address byte doesn't match */
+	UART_setAddress(CTRL_PANEL_ADDRESS(g_panel));
+	UART_receiveFrameInto((uint8 *)&g_command, sizeof(g_command), CTRL_frameCallBack);
+	FRAME_sendTo(CTRL_PANEL_ADDRESS(g_panel), FRAME_TYPE_POLL, NULL_PTR, 0);
+	g_pollTime = UART_getTime();
+}
+#endif
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_sendReply
+ *
+ * [Description]: This function is responsible for sending the result of the command to the
+ * 				  HMI micro-controller in one reply frame with the sequence of the command,
+ * 				  the reply is kept to answer a retransmission of the same command.
+ *
+ * [Arguments]: uint8 a_reply
+ *
+ * [in]: a_reply: The result (OPEN_DOOR, WRONG_PASSWORD, PASSWORD_MATCHED, ...)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_sendReply(uint8 a_reply)
+{
+	uint8 payload[REPLY_LENGTH];
+
+	payload[REPLY_SEQUENCE_INDEX] = g_command.sequence;
+	payload[REPLY_RESULT_INDEX] = a_reply;
+
+	g_panels[g_panel].lastReply = a_reply;
+	g_panels[g_panel].replyCached = TRUE;
+
+	FRAME_sendTo(CTRL_PANEL_ADDRESS(g_panel), FRAME_TYPE_REPLY, payload, REPLY_LENGTH);
 }
 
 
@@ -234,7 +634,9 @@ void CTRL_receivePasswordByUART(uint8 *password_Ptr)
  *
  * [Function Name]: CTRL_storePassword
  *
- * [Description]: This function is responsible for storing the password in EEPROM
+ * [Description]: This function is responsible for storing the password in EEPROM, the
+ * 				  password is copied in g_storedPassword and written one byte every
+ * 				  EEPROM_WRITE_TICKS in background (no busy wait for the write time)
  *
  * [Arguments]: None
  *
@@ -248,23 +650,53 @@ void CTRL_receivePasswordByUART(uint8 *password_Ptr)
 void CTRL_storePassword(void)
 {
 	uint8 counter;
-	uint16 address = 0x0311;
 	for(counter = 0; counter<PASSWORD_LENGTH; counter++)
 	{
-		/*
-		 * Store 1 byte from g_receivedPassword array in EEPROM
-		 * In order to store array in EEPROM the address must be increment
-		 * each time.
-		 * In order to increment the address, making the address + counter
-		 * to increment it each time by one location.
-		 */
-		EEPROM_writeByte(address + counter, g_receivedPassword[counter]);
-		/* delay time as the EEPROM take 10ms to make a write*/
-		_delay_ms(100);		/* Give the EEPROM some time to store 1 Byte */
+		/* The new password is used at once, the EEPROM is written from this copy */
+		g_storedPassword[counter] = g_command.password[counter];
+	}
+	/* Write the first byte now, the next ones are written by CTRL_storeNextByte */
+	g_eepromIndex = 0;
+	CTRL_storeNextByte();
+	Timer_startSoftTimer(&g_eepromTimer, EEPROM_WRITE_TICKS, EEPROM_WRITE_TICKS, CTRL_storeNextByte);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_storeNextByte
+ *
+ * [Description]: This function is responsible for writing the next byte of g_storedPassword
+ * 				  in EEPROM, it is the call back of g_eepromTimer that gives the EEPROM its
+ * 				  write time between two bytes. The timer is stopped after the last byte.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_storeNextByte(void)
+{
+	uint16 address = 0x0311;
+	/*
+	 * In order to store array in EEPROM the address must be increment
+	 * each time, making the address + index of the byte.
+	 */
+	EEPROM_writeByte(address + g_eepromIndex, g_storedPassword[g_eepromIndex]);
+	g_eepromIndex++;
+	if(g_eepromIndex == PASSWORD_LENGTH)
+	{
+		Timer_cancelSoftTimer(&g_eepromTimer);
 	}
 }
 
 
+
 /********************************************************************************************
  *
  * [Function Name]: CTRL_readStoredPassword
@@ -299,12 +731,86 @@ void CTRL_readStoredPassword(void)
 
 /********************************************************************************************
  *
- * [Function Name]: CTRL_openingDoor
+ * [Function Name]: CTRL_doorOpen
+ *
+ * [Description]: This function is responsible for starting to open the Door in background
+ * 				  (no busy wait): a closed door is opened, a holding door is held again from
+ * 				  the start and a closing door opens again the part that is closed.
  *
- * [Description]: - This function is responsible for opening and closing the Door.
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorOpen(void)
+{
+	switch(g_doorState)
+	{
+	case DOOR_CLOSED:
+		/* Opening the Door: Rotate the motor Clockwise for 15 seconds */
+		CTRL_doorStartPhase(DOOR_OPENING, CW, DOOR_TRAVEL_TICKS);
+		break;
+	case DOOR_HOLDING:
+		/* Hold the Door again from the start */
+		CTRL_doorStartPhase(DOOR_HOLDING, STOP, DOOR_LEFT_OPEN_PERIOD * TICKS_PER_SECOND);
+		break;
+	case DOOR_CLOSING:
+		/* Open again the part that is closed, up to the open end stop */
+		CTRL_doorUpdatePosition();
+		CTRL_doorStartPhase(DOOR_OPENING, CW, DOOR_TRAVEL_TICKS - g_doorPosition);
+		break;
+	}
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorClose
+ *
+ * [Description]: This function is responsible for closing the Door now: a holding door is
+ * 				  closed and an opening door closes the opened part only (door position).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorClose(void)
+{
+	switch(g_doorState)
+	{
+	case DOOR_OPENING:
+		/* Close the part that is opened, down to the closed end stop */
+		CTRL_doorUpdatePosition();
+		CTRL_doorStartPhase(DOOR_CLOSING, ACW, g_doorPosition);
+		break;
+	case DOOR_HOLDING:
+		CTRL_doorStartPhase(DOOR_CLOSING, ACW, DOOR_TRAVEL_TICKS);
+		break;
+	}
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorPhaseEnd
+ *
+ * [Description]: - This function is the call back of the door software timer (dispatched in
+ * 				    the timers task), it starts the next phase of the door.
  * 				  - Make the motor that responsible for opening and closing the door,
  * 				    rotates clockwise (in opening the door) and rotates anti-clockwise
- * 				    (in closing the door).
+ * 				    (in closing the door):
+ * 				    DOOR_CLOSED -> DOOR_OPENING -> DOOR_HOLDING -> DOOR_CLOSING -> DOOR_CLOSED
  *
  * [Arguments]: None
  *
@@ -315,31 +821,96 @@ void CTRL_readStoredPassword(void)
  * [Returns]: void
  *
  ********************************************************************************************/
-void CTRL_openingDoor(void)
+void CTRL_doorPhaseEnd(void)
 {
-	/* Opening the Door:
-	 * Rotate the motor Clockwise for 15 seconds
-	 */
-	g_seconds = 0;
-	DcMotor_Rotate(CW);
-	while(g_seconds != DOOR_UNLOCKED_PERIOD);
+	switch(g_doorState)
+	{
+	case DOOR_OPENING:
+		/* Hold the Door: Stop the motor for 5 seconds */
+		CTRL_doorStartPhase(DOOR_HOLDING, STOP, DOOR_LEFT_OPEN_PERIOD * TICKS_PER_SECOND);
+		break;
+	case DOOR_HOLDING:
+		/* Closing the Door: Rotate the motor Anti-Clockwise for 15 seconds */
+		CTRL_doorStartPhase(DOOR_CLOSING, ACW, DOOR_TRAVEL_TICKS);
+		break;
+	default:
+		CTRL_doorStartPhase(DOOR_CLOSED, STOP, 0);
+		break;
+	}
+}
 
 
-	/* Hold the Door:
-	 * Holding the motor clockwise for 3 seconds
-	 */
-	g_seconds = 0;
-	DcMotor_Rotate(STOP);
-	while(g_seconds != DOOR_LEFT_OPEN_PERIOD);
 
-	/* Closing the Door:
-	 * Rotate the motor Anti-Clockwise for 15 seconds
-	 */
-	g_seconds = 0;
-	DcMotor_Rotate(ACW);
-	while(g_seconds != DOOR_UNLOCKED_PERIOD);
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorStartPhase
+ *
+ * [Description]: This function is responsible for starting one phase of the door and its
+ * 				  software timer (no timer for the closed door).
+ *
+ * [Arguments]: uint8 a_state, DcMotor_State a_motorState, uint16 a_ticks
+ *
+ * [in]: - a_state: The new door state
+ * 		 - a_motorState: The motor direction in this phase
+ * 		 - a_ticks: The phase period in timer ticks
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorStartPhase(uint8 a_state, DcMotor_State a_motorState, uint16 a_ticks)
+{
+	CTRL_doorUpdatePosition();	/* The last phase ends here */
+	DcMotor_Rotate(a_motorState);
+	g_doorState = a_state;
+	g_doorPhaseTicks = a_ticks;
+	if(a_state != DOOR_CLOSED)
+	{
+		/* An empty phase (reversed just after its start) ends in the next tick */
+		Timer_startSoftTimer(&g_doorTimer, a_ticks, 0, CTRL_doorPhaseEnd);
+	}
+	else
+	{
+		Timer_cancelSoftTimer(&g_doorTimer);
+	}
+}
+
 
-	DcMotor_Rotate(STOP);
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorUpdatePosition
+ *
+ * [Description]: This function is responsible for adding the motor ticks of the current phase
+ * 				  since its start (or the last update) to the door position: the opening adds
+ * 				  them and the closing subtracts them, between the two end stops.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorUpdatePosition(void)
+{
+	/* The expired timer has no remaining ticks: the whole phase is counted */
+	uint16 remaining = Timer_getSoftTimerRemaining(&g_doorTimer);
+	uint16 elapsed = g_doorPhaseTicks - remaining;
+
+	if(g_doorState == DOOR_OPENING)
+	{
+		g_doorPosition = (elapsed < (DOOR_TRAVEL_TICKS - g_doorPosition)) ?
+				(g_doorPosition + elapsed) : DOOR_TRAVEL_TICKS;
+	}
+	else if(g_doorState == DOOR_CLOSING)
+	{
+		g_doorPosition = (elapsed < g_doorPosition) ? (g_doorPosition - elapsed) : 0;
+	}
+	g_doorPhaseTicks = remaining;	/* Counted once */
 }
 
 
@@ -348,8 +919,9 @@ void CTRL_openingDoor(void)
  *
  * [Function Name]: Timer_CallBackFunction
  *
- * [Description]:This function is responsible for incrementing global variable (g_seconds)
- * 				 that indicates the number of counted seconds.
+ * [Description]:This function is responsible for advancing the software timers of the
+ * 				 door and the buzzer alarm and for making their tasks ready, it subscribes to
+ * 				 the tick after UART_tick.
  *
  * [Arguments]: None
  *
@@ -362,7 +934,34 @@ void CTRL_openingDoor(void)
  ********************************************************************************************/
 void Timer_CallBackFunction(void)
 {
-	/* Call back function for the timer (when timer count 1 second)
-	 * the timer increment the global variable g_seconds every second */
-	g_seconds++; /* Increment global second variable each time the interrupt fired */
+	if(Timer_tickSoftTimers() == TRUE)	/* All the ticks of the period */
+	{
+		SCHEDULER_setReady(CTRL_TASK_TIMERS);	/* Call backs of the expired timers */
+	}
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	SCHEDULER_setReady(CTRL_TASK_COMMAND);	/* Timeout of the poll of the current panel */
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_alarmEnd
+ *
+ * [Description]:This function is the call back of the buzzer alarm software timer, it turns
+ * 				 off the buzzer at the end of the alarm.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_alarmEnd(void)
+{
+	BUZZER_off();
 }
@@ -24,8 +24,13 @@
  *******************************************************************************************/
 #define PASSWORD_LENGTH				5
 
+/* Door periods in seconds, the host benchmark builds a shorter door cycle */
+#ifndef DOOR_UNLOCKED_PERIOD
 #define	DOOR_UNLOCKED_PERIOD		15
+#endif
+#ifndef DOOR_LEFT_OPEN_PERIOD
 #define DOOR_LEFT_OPEN_PERIOD		5
+#endif
 #define BUZZER_ACTIVE_PERIOD		3
 
 #define MAX_ALLOWED_TRIALS			3
@@ -36,33 +41,138 @@
 #define PASSWORD_MATCHED			1
 #define PASSWORD_UNMATCHED			0
 
-#define READY_TO_SEND				0x10
-#define READY_TO_RECEIVE			0x20
-
 #define OPEN_DOOR					0x25
 
 #define WRONG_PASSWORD				0x30
 #define CHANGING_PASSWORD			0X31
 #define THIEF_IS_DETECTED			0x32
+#define NO_PASSWORD					0x33	/* No password is saved since the Control ECU reset */
 
 #define CHANGE_PASSWORD_OPTION		45 		/* ACII Code for '+' */
 #define DOOR_OPEN_OPTION			43		/* ACII Code for '-' */
+#define NEW_PASSWORD_OPTION			0x40	/* New password and its confirmation */
+#define DOOR_STATUS_OPTION			0x41	/* Reply with the door state */
+#define DOOR_CLOSE_OPTION			0x42	/* Close the door now */
+#define TRACE_DUMP_OPTION			0x43	/* Send the UART link trace, then the reply */
+#define NO_COMMAND					0		/* No new command is received yet */
+
+/* Door states (reply of DOOR_STATUS_OPTION) */
+#define DOOR_CLOSED					0x50
+#define DOOR_OPENING				0x51
+#define DOOR_HOLDING				0x52
+#define DOOR_CLOSING				0x53
+
+/*
+ * Command frame payload: sequence + option + password (+ confirmation password for new
+ * password). The sequence number is changed for every new command and kept for its
+ * retransmissions, the Control ECU answers a retransmission from its last reply.
+ */
+#define COMMAND_SEQUENCE_INDEX		0
+#define COMMAND_OPTION_INDEX		1
+#define COMMAND_PASSWORD_INDEX		2
+#define COMMAND_CONFIRMATION_INDEX	(COMMAND_PASSWORD_INDEX + PASSWORD_LENGTH)
+#define COMMAND_MAX_LENGTH			(COMMAND_CONFIRMATION_INDEX + PASSWORD_LENGTH)
+
+/* Reply frame payload: sequence of the command + result */
+#define REPLY_SEQUENCE_INDEX		0
+#define REPLY_RESULT_INDEX			1
+#define REPLY_LENGTH				2
+
+/*
+ * HMI panels: one on the point-to-point link, or CTRL_NUM_OF_PANELS panels at the bus
+ * addresses 1 to CTRL_NUM_OF_PANELS on the multi-drop bus (UART_MULTIDROP_ENABLE in uart.h).
+ * The panels are polled in turn, a panel answers the poll with its command or with an empty
+ * poll frame. A command waits one round at most: the polls and the commands of the other panels.
+ */
+#if (UART_MULTIDROP_ENABLE == TRUE)
+#define CTRL_NUM_OF_PANELS			4
+#else
+#define CTRL_NUM_OF_PANELS			1
+#endif
+#define CTRL_PANEL_ADDRESS(INDEX)	((INDEX) + 1)
+
+#define BUS_POLL_TIMEOUT_MS			40		/* Longer than a poll and a command frame at 9600 baud */
+#define BUS_OFFLINE_POLLS			3		/* Polls without answer in a row of an offline panel */
+#define BUS_OFFLINE_POLL_ROUNDS		8		/* An offline panel is polled once every 8 rounds */
+
+/* Timer1 tick (compare match with F_CPU/64 clock) is the UART time base */
+#define TIMER_TICK_COMPARE_VALUE	((uint16)(((F_CPU / 64UL) * UART_TICK_PERIOD_MS) / 1000UL) - 1)
+#define TICKS_PER_SECOND			(1000 / UART_TICK_PERIOD_MS)
+/* Motor ticks from the closed door to the open door */
+#define DOOR_TRAVEL_TICKS			(DOOR_UNLOCKED_PERIOD * TICKS_PER_SECOND)
+/* Ticks between two EEPROM bytes, more than the 10ms write time of the EEPROM */
+#define EEPROM_WRITE_TICKS			((10 / UART_TICK_PERIOD_MS) + 1)
+
+/* Tasks of the scheduler (index in the task table, 0 has the highest priority) */
+#define CTRL_TASK_COMMAND			0
+#define CTRL_TASK_TIMERS			1
+#define CTRL_NUM_OF_TASKS			2
+
+/********************************************************************************************
+ * 									Types Declaration										*
+ ********************************************************************************************/
+
+/* Command frame payload, the RX ISR writes the frame directly in it (no staging copy) */
+typedef struct{
+	uint8 sequence;
+	uint8 option;
+	uint8 password[PASSWORD_LENGTH];
+	uint8 confirmation[PASSWORD_LENGTH];	/* Only with NEW_PASSWORD_OPTION */
+}CTRL_CommandType;
+
+/* State of one HMI panel */
+typedef struct{
+	uint8 lastSequence;				/* To answer a retransmitted command (same sequence) */
+	uint8 lastOption;				/* without executing it again */
+	uint8 lastReply;
+	uint8 replyCached;
+	uint8 passwordChangeAllowed;	/* The new password is allowed after the old password */
+	uint8 missedPolls;				/* Bus: polls without answer in a row */
+}CTRL_PanelType;
 
 
 /********************************************************************************************
  * 									Global Variables										*
  ********************************************************************************************/
-/* Global array to receive the password from HMI ECU */
-uint8 g_receivedPassword[PASSWORD_LENGTH];
+/* Global structure to receive the command (option + password) from HMI ECU */
+CTRL_CommandType g_command;
+
+/* Global array for the state of the HMI panels, and index of the panel of g_command */
+CTRL_PanelType g_panels[CTRL_NUM_OF_PANELS];
+uint8 g_panel = 0;
+
+/* Global variables for the polling of the panels on the multi-drop bus */
+uint8 g_pollRound = 0;
+uint16 g_pollTime = 0;
 
 /* Global array to get the stored password from EEPROM */
 uint8 g_storedPassword[PASSWORD_LENGTH];
 
+/* Password write in EEPROM in background: index of the next byte and its software timer */
+uint8 g_eepromIndex = 0;
+Timer_SoftTimerType g_eepromTimer;
+
 /* Global variable to store the number of wrong attempts */
 uint8 g_wrongTrial=0;
 
-/* Global variable to be incremented every second */
-uint8 g_seconds = 0;
+/* Global variable set when the first password after the reset is saved */
+uint8 g_passwordSaved = FALSE;
+
+/* Door state machine, its phases are timed by a software timer in background */
+uint8 g_doorState = DOOR_CLOSED;
+uint16 g_doorPhaseTicks = 0;		/* Ticks of the current door phase not counted in the position */
+uint16 g_doorPosition = 0;			/* Opened part of the door in motor ticks (DOOR_TRAVEL_TICKS: open) */
+Timer_SoftTimerType g_doorTimer;
+
+/* Software timer of the buzzer alarm (running: the system is closed) */
+Timer_SoftTimerType g_alarmTimer;
+
+/* Global variable set while a command frame is required from the RX ISR */
+uint8 g_commandRequested = FALSE;
+
+/* Periodic software timer of a baud rate exchange after the startup (point-to-point link), the
+ * frames go to the exchange while it runs */
+Timer_SoftTimerType g_linkTimer;
 
 /********************************************************************************************
  * 									Function Prototype										*
@@ -70,13 +180,13 @@ uint8 g_seconds = 0;
 
 /********************************************************************************************
  *
- * [Function Name]: CTRL_takeFirstPassword
+ * [Function Name]: CTRL_commandTask
  *
- * [Description]:- This function is responsible for receiving the passwords form the HMI micro-
- * 				   controller and store it in global array (g_receivedPassword).
- * 				 - Also This function check the passwords received from the HMI micro-controller
- * 				   if both password identical it send Password match to HMI micro-controller to
- * 				   inform that the password saved.
+ * [Description]: This function is the task of the commands, it is made ready by the frame
+ * 				  receive (CTRL_frameCallBack), by the line errors (CTRL_lineErrorCallBack), at
+ * 				  the end of a baud rate exchange (CTRL_linkTimerCallBack) and, on the bus, by
+ * 				  every timer tick for the poll timeout. It executes the received commands and
+ * 				  requests the next frame (see CTRL_pollCommand).
  *
  * [Arguments]: None
  *
@@ -87,7 +197,156 @@ uint8 g_seconds = 0;
  * [Returns]: void
  *
  ********************************************************************************************/
-void CTRL_takeFirstPassword(void);
+void CTRL_commandTask(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_executeCommand
+ *
+ * [Description]: This function is responsible for executing one command of the HMI micro-
+ * 				  controller (g_command) and sending its reply. Until the first password is
+ * 				  saved, the other commands are answered with NO_PASSWORD.
+ *
+ * [Arguments]: uint8 a_option
+ *
+ * [in]: a_option: The selected option
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_executeCommand(uint8 a_option);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_timersTask
+ *
+ * [Description]: This function is the task of the software timers, it is made ready by the
+ * 				  timer tick when timers expired and calls their call backs (door phases and
+ * 				  buzzer alarm).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_timersTask(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_idle
+ *
+ * [Description]: This function is the idle hook of the scheduler (interrupts disabled), the
+ * 				  CPU sleeps until the next interrupt (UART RX, Timer1 compare or TWI). While
+ * 				  the link is idle the timer ticks are skipped up to the next door phase or
+ * 				  alarm end (tickless idle), the wake up ends the skip at the next tick.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_idle(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_frameCallBack
+ *
+ * [Description]: This function is called by the RX ISR when a frame is received in g_command,
+ * 				  it makes the task of the commands ready.
+ *
+ * [Arguments]: uint8 a_type, uint8 a_length
+ *
+ * [in]: - a_type: The type of the received frame
+ * 		 - a_length: The payload length of the received frame
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_frameCallBack(uint8 a_type, uint8 a_length);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_lineErrorCallBack
+ *
+ * [Description]: This function is called by the RX ISR for each line error, it makes the task
+ * 				  of the commands ready when the line errors in a row are enough to go back to
+ * 				  the default baud rate (see FRAME_recoverBaudRate).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_lineErrorCallBack(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_linkTimerCallBack
+ *
+ * [Description]: This function is the call back of the periodic software timer of a baud rate
+ * 				  exchange requested by the HMI ECU after the startup, it runs the next step of
+ * 				  the exchange every tick. At the end the timer is stopped and the task of the
+ * 				  commands requests the next command frame.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_linkTimerCallBack(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_setNewPassword
+ *
+ * [Description]: This function is responsible for checking the received password and its
+ * 				  confirmation (g_command), if both are identical it stores the password in
+ * 				  EEPROM. The result is sent to the HMI micro-controller.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: Unsigned Character
+ *
+ * [Returns]: SUCCESS if the password is saved, FAILED otherwise
+ *
+ ********************************************************************************************/
+uint8 CTRL_setNewPassword(void);
 
 
 
@@ -114,21 +373,79 @@ uint8 CTRL_verifyPassword(uint8 *a_firstPassword_Ptr, uint8 *a_secondPassword_Pt
 
 /********************************************************************************************
  *
- * [Function Name]: CTRL_receivePasswordByUART
+ * [Function Name]: CTRL_pollCommand
+ *
+ * [Description]: This function is responsible for checking (without waiting) if one command
+ * 				  frame is received form the HMI micro-controller. The RX ISR receives the
+ * 				  frame directly in the global structure (g_command), the frame carries the
+ * 				  selected option and the password (and the confirmation password in case of
+ * 				  new password). The next frame is not required until the next call, so the
+ * 				  command must be executed before calling this function again.
+ * 				  Corrupted or incomplete frames are dropped. A retransmission of the last
+ * 				  command (its reply is lost) is answered again from the last reply without
+ * 				  returning it. A baud rate request of the HMI ECU (new negotiation) is
+ * 				  answered in background (CTRL_linkTimerCallBack), no frame is required until
+ * 				  the end of the exchange. After line errors in a row the default baud rate is
+ * 				  taken again.
+ * 				  On the multi-drop bus the next panel is polled first (g_panel is the panel
+ * 				  of the command), a panel that doesn't answer in BUS_POLL_TIMEOUT_MS is
+ * 				  skipped.
  *
- * [Description]: This function is responsible for receiving the password form the HMI micro-
- * 				  controller through UART serial communication.
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: The selected option, NO_COMMAND if no new command is received
+ *
+ ********************************************************************************************/
+uint8 CTRL_pollCommand(void);
+
+
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_pollNextPanel
  *
- * [Arguments]: uint8 *password_Ptr
+ * [Description]: This function is responsible for selecting the next HMI panel (round-robin)
+ * 				  and sending it a poll frame, the answer is received in g_command. The offline
+ * 				  panels (BUS_OFFLINE_POLLS polls without answer) are polled once every
+ * 				  BUS_OFFLINE_POLL_ROUNDS rounds only, so they don't slow down the others.
  *
- * [in]: *password_Ptr: pointer to character
+ * [Arguments]: None
+ *
+ * [in]: void
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void CTRL_receivePasswordByUART(uint8 *password_Ptr);
+void CTRL_pollNextPanel(void);
+#endif
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_sendReply
+ *
+ * [Description]: This function is responsible for sending the result of the command to the
+ * 				  HMI micro-controller (panel g_panel) in one reply frame with the sequence of
+ * 				  the command, the reply is kept to answer a retransmission of the same command.
+ *
+ * [Arguments]: uint8 a_reply
+ *
+ * [in]: a_reply: The result (OPEN_DOOR, WRONG_PASSWORD, PASSWORD_MATCHED, ...)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_sendReply(uint8 a_reply);
 
 
 
@@ -136,7 +453,9 @@ void CTRL_receivePasswordByUART(uint8 *password_Ptr);
  *
  * [Function Name]: CTRL_storePassword
  *
- * [Description]: This function is responsible for storing the password in EEPROM
+ * [Description]: This function is responsible for storing the password in EEPROM, the
+ * 				  password is copied in g_storedPassword and written one byte every
+ * 				  EEPROM_WRITE_TICKS in background (no busy wait for the write time)
  *
  * [Arguments]: None
  *
@@ -151,6 +470,26 @@ void CTRL_storePassword(void);
 
 
 
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_storeNextByte
+ *
+ * [Description]: This function is responsible for writing the next byte of g_storedPassword
+ * 				  in EEPROM, it is the call back of g_eepromTimer
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_storeNextByte(void);
+
+
+
 /********************************************************************************************
  *
  * [Function Name]: CTRL_readStoredPassword
@@ -172,12 +511,98 @@ void CTRL_readStoredPassword(void);
 
 /********************************************************************************************
  *
- * [Function Name]: CTRL_openingDoor
+ * [Function Name]: CTRL_doorOpen
+ *
+ * [Description]: This function is responsible for starting to open the Door in background
+ * 				  (no busy wait): a closed door is opened, a holding door is held again from
+ * 				  the start and a closing door opens again the part that is closed.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorOpen(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorClose
  *
- * [Description]: - This function is responsible for opening and closing the Door.
+ * [Description]: This function is responsible for closing the Door now: a holding door is
+ * 				  closed and an opening door closes the opened part only (door position).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorClose(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorPhaseEnd
+ *
+ * [Description]: - This function is the call back of the door software timer (dispatched in
+ * 				    the timers task), it starts the next phase of the door.
  * 				  - Make the motor that responsible for opening and closing the door,
  * 				    rotates clockwise (in opening the door) and rotates anti-clockwise
- * 				    (in closing the door).
+ * 				    (in closing the door):
+ * 				    DOOR_CLOSED -> DOOR_OPENING -> DOOR_HOLDING -> DOOR_CLOSING -> DOOR_CLOSED
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorPhaseEnd(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorStartPhase
+ *
+ * [Description]: This function is responsible for starting one phase of the door and its
+ * 				  software timer (no timer for the closed door).
+ *
+ * [Arguments]: uint8 a_state, DcMotor_State a_motorState, uint16 a_ticks
+ *
+ * [in]: - a_state: The new door state
+ * 		 - a_motorState: The motor direction in this phase
+ * 		 - a_ticks: The phase period in timer ticks
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_doorStartPhase(uint8 a_state, DcMotor_State a_motorState, uint16 a_ticks);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_doorUpdatePosition
+ *
+ * [Description]: This function is responsible for adding the motor ticks of the current phase
+ * 				  since its start (or the last update) to the door position: the opening adds
+ * 				  them and the closing subtracts them, between the two end stops.
  *
  * [Arguments]: None
  *
@@ -188,7 +613,7 @@ void CTRL_readStoredPassword(void);
  * [Returns]: void
  *
  ********************************************************************************************/
-void CTRL_openingDoor(void);
+void CTRL_doorUpdatePosition(void);
 
 
 
@@ -196,8 +621,9 @@ void CTRL_openingDoor(void);
  *
  * [Function Name]: Timer_CallBackFunction
  *
- * [Description]:This function is responsible for incrementing global variable (g_seconds)
- * 				 that indicates the number of counted seconds.
+ * [Description]:This function is responsible for advancing the software timers of the
+ * 				 door and the buzzer alarm and for making their tasks ready, it subscribes to
+ * 				 the tick after UART_tick.
  *
  * [Arguments]: None
  *
@@ -210,4 +636,24 @@ void CTRL_openingDoor(void);
  ********************************************************************************************/
 void Timer_CallBackFunction(void);
 
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: CTRL_alarmEnd
+ *
+ * [Description]:This function is the call back of the buzzer alarm software timer, it turns
+ * 				 off the buzzer at the end of the alarm.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void CTRL_alarmEnd(void);
+
 #endif /* CONTROL_ECU_H_ */
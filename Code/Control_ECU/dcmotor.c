@@ -36,12 +36,9 @@
  ********************************************************************************************/
 void DcMotor_Init(void)
 {
-	/* configure pin of motors as output pins */
-	GPIO_setupPinDirection(MOTOR_PORT_ID,MOTOR_FIRST_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(MOTOR_PORT_ID,MOTOR_SECOND_PIN_ID,PIN_OUTPUT);
-	/* Motor is stop at the beginning */
-	GPIO_writePin(MOTOR_PORT_ID, MOTOR_FIRST_PIN_ID,LOGIC_LOW);
-	GPIO_writePin(MOTOR_PORT_ID, MOTOR_SECOND_PIN_ID,LOGIC_LOW);
+	/* Motor is stop at the beginning, then configure pin of motors as output pins */
+	GPIO_WRITE_PORT_MASKED(MOTOR_PORT_ID, MOTOR_PINS_MASK, MOTOR_STOP_VALUE);
+	GPIO_SETUP_PORT_DIRECTION_MASKED(MOTOR_PORT_ID, MOTOR_PINS_MASK, PORT_OUTPUT);
 }
 
 
@@ -65,23 +62,22 @@ void DcMotor_Init(void)
  ********************************************************************************************/
 void DcMotor_Rotate(DcMotor_State state)
 {
+	uint8 value;
+
 	switch (state)
 	{
 	default:
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_FIRST_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_SECOND_PIN_ID,LOGIC_LOW);
-		break;
 	case STOP:
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_FIRST_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_SECOND_PIN_ID,LOGIC_LOW);
+		value = MOTOR_STOP_VALUE;
 		break;
 	case CW:
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_FIRST_PIN_ID,LOGIC_HIGH);
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_SECOND_PIN_ID,LOGIC_LOW);
+		value = MOTOR_CW_VALUE;
 		break;
 	case ACW:
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_FIRST_PIN_ID,LOGIC_LOW);
-		GPIO_writePin(MOTOR_PORT_ID, MOTOR_SECOND_PIN_ID,LOGIC_HIGH);
+		value = MOTOR_ACW_VALUE;
 		break;
 	}
+
+	/* Both pins change in one store, the H-bridge never sees the state between the two */
+	GPIO_WRITE_PORT_MASKED(MOTOR_PORT_ID, MOTOR_PINS_MASK, value);
 }
@@ -21,6 +21,12 @@
 #define MOTOR_FIRST_PIN_ID			PIN0_ID
 #define MOTOR_SECOND_PIN_ID			PIN1_ID
 
+/* The two pins of the H-bridge are written together (one store) */
+#define MOTOR_PINS_MASK				((1<<MOTOR_FIRST_PIN_ID) | (1<<MOTOR_SECOND_PIN_ID))
+#define MOTOR_CW_VALUE				(1<<MOTOR_FIRST_PIN_ID)
+#define MOTOR_ACW_VALUE				(1<<MOTOR_SECOND_PIN_ID)
+#define MOTOR_STOP_VALUE			0
+
 
 /*******************************************************************************
  *                         Types Declaration                                   *
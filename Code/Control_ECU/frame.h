@@ -0,0 +1,395 @@
+ /******************************************************************************
+ *
+ * [Module]: FRAME
+ *
+ * [File Name]: frame.h
+ *
+ * [Description]: Header file for the framed UART protocol shared by the HMI and
+ * 				  Control ECUs
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef FRAME_H_
+#define FRAME_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Frame format on the wire:
+ * +-------+------+--------+-------------------+-------+
+ * | START | TYPE | LENGTH | PAYLOAD[LENGTH]   | CRC-8 |
+ * +-------+------+--------+-------------------+-------+
+ * The CRC-8 (polynomial 0x07, initial value 0x00) covers TYPE, LENGTH and PAYLOAD.
+ */
+#define FRAME_START_BYTE				0x7E
+#define FRAME_MAX_PAYLOAD_LENGTH		16
+#define FRAME_OVERHEAD_LENGTH			4		/* START + TYPE + LENGTH + CRC */
+
+#define FRAME_CRC8_POLYNOMIAL			0x07
+#define FRAME_CRC8_INITIAL_VALUE		0x00
+
+/* Frame types */
+#define FRAME_TYPE_COMMAND				0x01	/* HMI -> Control: option + password(s) */
+#define FRAME_TYPE_REPLY				0x02	/* Control -> HMI: result of the command */
+#define FRAME_TYPE_POLL					0x03	/* Bus: Control -> panel: send your command,
+												   panel -> Control (empty): nothing to send */
+#define FRAME_TYPE_BAUD_REQUEST			0x10	/* HMI -> Control: mask of the supported baud rates */
+#define FRAME_TYPE_BAUD_ACCEPT			0x11	/* Control -> HMI: index of the selected baud rate */
+#define FRAME_TYPE_BAUD_CONFIRM			0x12	/* Both: link check at the selected baud rate (index
+												   + FRAME_BAUD_CHECK_BYTE pattern) */
+#define FRAME_TYPE_TRACE_INFO			0x20	/* Link trace dump header (UART_traceDump) */
+#define FRAME_TYPE_TRACE_DATA			0x21	/* Link trace records, empty at the end */
+
+/*
+ * Baud rates offered in the startup negotiation, fastest first.
+ * Bit i in the baud rate mask means that the ECU supports FRAME_BAUD_RATES[i].
+ */
+#define FRAME_BAUD_RATES				{1000000UL, 500000UL, 250000UL, 115200UL, \
+										 57600UL, 38400UL, 19200UL, 9600UL}
+#define FRAME_NUM_OF_BAUD_RATES			8
+#define FRAME_NO_BAUD_RATE				0xFF
+
+/*
+ * Highest baud rate offered. The UART receive buffer holds 2 bytes, so the RX ISR may start up
+ * to 2 byte times late: about 1400 CPU cycles at 115200 baud (8 MHz), but only 160 cycles at
+ * 1 Mbps. The Timer1 ISR (keypad scan, timer wheel, subscribers) and the LCD Timer2 ISR take
+ * longer than that under load, and the link check frame is sent on a quiet link only. The
+ * faster rates of FRAME_BAUD_RATES are kept in the protocol for faster clocks.
+ */
+#define FRAME_MAX_BAUD_RATE				115200UL
+
+/* Negotiation timing (measured by UART_tick, the timer must be running before) */
+#define FRAME_NEGOTIATION_WAIT_MS		1000	/* Control waits the HMI request after reset */
+#define FRAME_NEGOTIATION_REPLY_MS		50		/* Wait for each reply */
+#define FRAME_NEGOTIATION_TRIALS		3
+#define FRAME_BAUD_SWITCH_DELAY_MS		2		/* Let the other ECU switch its baud rate */
+
+/*
+ * The link check frame has the maximum payload length, so a baud rate is used only if both
+ * RX ISRs receive the longest frames back to back at this rate. Byte 0 is the baud rate
+ * index, the next ones are FRAME_BAUD_CHECK_BYTE(i).
+ */
+#define FRAME_BAUD_CHECK_LENGTH			FRAME_MAX_PAYLOAD_LENGTH
+#define FRAME_BAUD_CHECK_BYTE(I)		((uint8)((((I) & 1) ? 0xAA : 0x55) ^ (I)))
+
+/*
+ * Link recovery when one ECU is reset alone (it restarts at the default baud rate):
+ * - The HMI ECU negotiates again after FRAME_RESYNC_TIMEOUTS reply timeouts in a row.
+ * - The Control ECU goes back to the default baud rate after FRAME_RESYNC_LINE_ERRORS line
+ *   errors in a row (see UART_getLineErrors) to receive the new negotiation.
+ */
+#define FRAME_RESYNC_TIMEOUTS			3
+#define FRAME_RESYNC_LINE_ERRORS		8
+
+/* Timeout value of the receive functions to wait without a deadline */
+#define FRAME_WAIT_FOREVER				0xFFFF
+
+/*
+ * Update the running CRC-8 with one byte by two look-ups in the nibble table, it is fast
+ * enough for the RX ISR and the table takes 16 bytes only.
+ */
+#define FRAME_CRC8_UPDATE(CRC,DATA)	do{ \
+										(CRC) ^= (DATA); \
+										(CRC) = (uint8)((CRC) << 4) ^ g_frameCrc8Table[(CRC) >> 4]; \
+										(CRC) = (uint8)((CRC) << 4) ^ g_frameCrc8Table[(CRC) >> 4]; \
+									}while(0)
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef enum{
+	FRAME_OK, FRAME_TIMEOUT
+}FRAME_Status;
+
+typedef struct{
+	uint8 type;
+	uint8 length;
+	uint8 payload[FRAME_MAX_PAYLOAD_LENGTH];
+}FRAME_Type;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* CRC-8 of each nibble value (polynomial 0x07) */
+extern const uint8 g_frameCrc8Table[16];
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_crc8Update
+ *
+ * [Description]: Update the running CRC-8 with one more byte.
+ *
+ * [Arguments]: uint8 crc, uint8 data
+ *
+ * [in]: - crc: The CRC of the previous bytes
+ * 		 - data: The new byte
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: The updated CRC
+ *
+ ********************************************************************************************/
+uint8 FRAME_crc8Update(uint8 crc, uint8 data);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_send
+ *
+ * [Description]: Build a frame from the type and the payload and send it through UART in
+ * 				  one burst (no handshake between the bytes).
+ *
+ * [Arguments]: uint8 type, const uint8 *payload_Ptr, uint8 length
+ *
+ * [in]: - type: Frame type (FRAME_TYPE_xxx)
+ * 		 - *payload_Ptr: Pointer to the payload bytes
+ * 		 - length: Number of payload bytes (up to FRAME_MAX_PAYLOAD_LENGTH)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_send(uint8 type, const uint8 *payload_Ptr, uint8 length);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_sendTo
+ *
+ * [Description]: Multi-drop bus (UART_MULTIDROP_ENABLE): send the address byte of the panel
+ * 				  then the frame, only this panel (and the Control ECU when it waits for this
+ * 				  panel) receives it. On the point-to-point link it is FRAME_send.
+ *
+ * [Arguments]: uint8 address, uint8 type, const uint8 *payload_Ptr, uint8 length
+ *
+ * [in]: - address: Panel address on the bus
+ * 		 - type: Frame type (FRAME_TYPE_xxx)
+ * 		 - *payload_Ptr: Pointer to the payload bytes
+ * 		 - length: Number of payload bytes (up to FRAME_MAX_PAYLOAD_LENGTH)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_sendTo(uint8 address, uint8 type, const uint8 *payload_Ptr, uint8 length);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_receiveTimeout
+ *
+ * [Description]: Wait at most timeout_ms for a valid frame, the RX ISR writes the payload
+ * 				  directly in the caller buffer (no staging copy). Frames with wrong CRC or
+ * 				  longer than the buffer are dropped by the RX ISR. The timeout is measured
+ * 				  by the UART time (UART_tick).
+ *
+ * [Arguments]: uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr, uint8 *length_Ptr,
+ * 				uint16 timeout_ms
+ *
+ * [in]: - maxLength: Size of the caller buffer
+ * 		 - timeout_ms: The maximum waiting time in ms (FRAME_WAIT_FOREVER for no deadline)
+ *
+ * [out]: - *buffer_Ptr: The payload of the received frame
+ * 		  - *type_Ptr: The type of the received frame
+ * 		  - *length_Ptr: The payload length of the received frame
+ *
+ * [Returns]: FRAME_OK if a frame is received, FRAME_TIMEOUT otherwise
+ *
+ ********************************************************************************************/
+FRAME_Status FRAME_receiveTimeout(uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr,
+		uint8 *length_Ptr, uint16 timeout_ms);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_receiveInto
+ *
+ * [Description]: Wait for a valid frame, the RX ISR writes the payload directly in the caller
+ * 				  buffer (no staging copy). Frames with wrong CRC or longer than the buffer
+ * 				  are dropped by the RX ISR.
+ *
+ * [Arguments]: uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr, uint8 *length_Ptr
+ *
+ * [in]: maxLength: Size of the caller buffer
+ *
+ * [out]: - *buffer_Ptr: The payload of the received frame
+ * 		  - *type_Ptr: The type of the received frame
+ * 		  - *length_Ptr: The payload length of the received frame
+ *
+ * [Returns]: FRAME_OK
+ *
+ ********************************************************************************************/
+FRAME_Status FRAME_receiveInto(uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr, uint8 *length_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_receive
+ *
+ * [Description]: Wait for a valid frame of any type (up to FRAME_MAX_PAYLOAD_LENGTH payload).
+ *
+ * [Arguments]: FRAME_Type *frame_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: *frame_Ptr: The received frame
+ *
+ * [Returns]: FRAME_OK
+ *
+ ********************************************************************************************/
+FRAME_Status FRAME_receive(FRAME_Type *frame_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_negotiateBaudRate
+ *
+ * [Description]: Used by the HMI ECU at startup to agree with the Control ECU
+ * 				  on the fastest baud rate supported by both (not on the multi-drop bus, all the
+ * 				  nodes keep the default baud rate), and wait for the end of the
+ * 				  exchange (see FRAME_startNegotiation).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use after the negotiation
+ *
+ ********************************************************************************************/
+uint32 FRAME_negotiateBaudRate(void);
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_startNegotiation
+ *
+ * [Description]: Used by the HMI ECU when the link is lost to start a new
+ * 				  baud rate negotiation without waiting (nothing on the multi-drop bus):
+ * 					1. Send the mask of the offered baud rates at the default baud rate.
+ * 					2. Switch to the baud rate accepted by the Control ECU.
+ * 					3. Check the link at the new baud rate with a maximum length frame. If the
+ * 					   Control ECU doesn't answer, go back to the default baud rate and offer
+ * 					   the slower baud rates only (step 1).
+ * 				  The exchange goes on in FRAME_serviceBaudRate.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_startNegotiation(void);
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_acceptBaudRate
+ *
+ * [Description]: Used by the Control ECU at startup to answer the HMI ECU negotiation (not on
+ * 				  the multi-drop bus):
+ * 				  wait for the HMI request (keep the default baud rate if no request), answer
+ * 				  it (see FRAME_startBaudAnswer) and wait for the end of the exchange.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use after the negotiation
+ *
+ ********************************************************************************************/
+uint32 FRAME_acceptBaudRate(void);
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_startBaudAnswer
+ *
+ * [Description]: Used by the Control ECU to answer a baud rate request of the
+ * 				  HMI ECU without waiting, at startup or later (the HMI ECU negotiates again when
+ * 				  the link is lost):
+ * 					1. Accept the fastest baud rate offered by the HMI and supported here.
+ * 					2. Echo the link checks at the new baud rate, go back to the default baud
+ * 					   rate if the HMI ECU doesn't check the link.
+ * 				  The exchange goes on in FRAME_serviceBaudRate.
+ *
+ * [Arguments]: uint8 a_offeredRates
+ *
+ * [in]: a_offeredRates: Mask of the baud rates offered by the HMI ECU (payload of the request)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_startBaudAnswer(uint8 a_offeredRates);
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_serviceBaudRate
+ *
+ * [Description]: Run the next step of the baud rate exchange started by
+ * 				  FRAME_startNegotiation or FRAME_startBaudAnswer, without waiting: check the
+ * 				  received answer or its timeout and send the next frame. It must be called
+ * 				  every UART_TICK_PERIOD_MS (or more often) until it returns FALSE, no other
+ * 				  frame may be received meanwhile.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: TRUE while the exchange is in progress, FALSE when it is over
+ *
+ ********************************************************************************************/
+uint8 FRAME_serviceBaudRate(void);
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_recoverBaudRate
+ *
+ * [Description]: Used by the Control ECU when no frame is received: after
+ * 				  FRAME_RESYNC_LINE_ERRORS line errors in a row the HMI ECU is talking at another
+ * 				  baud rate (reset alone), go back to the default baud rate to receive its new
+ * 				  negotiation (nothing on the multi-drop bus).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use
+ *
+ ********************************************************************************************/
+uint32 FRAME_recoverBaudRate(void);
+
+#endif /* FRAME_H_ */
@@ -14,6 +14,8 @@
 #define GPIO_H_
 
 #include "std_types.h"
+#include "common_macros.h" /* To use the macros like SET_BIT */
+#include "port.h" /* To use the IO Ports Registers */
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -35,6 +37,63 @@
 #define PIN6_ID                6
 #define PIN7_ID                7
 
+/*
+ * Registers of a port, selected at compile time when the port number is a constant (the
+ * ternaries are folded, even without optimization). The port number must be valid.
+ */
+#define GPIO_DDR_REG(PORT_ID)  (*(((PORT_ID) == PORTA_ID) ? &DDRA : ((PORT_ID) == PORTB_ID) ? &DDRB : \
+                                  ((PORT_ID) == PORTC_ID) ? &DDRC : &DDRD))
+#define GPIO_PORT_REG(PORT_ID) (*(((PORT_ID) == PORTA_ID) ? &PORTA : ((PORT_ID) == PORTB_ID) ? &PORTB : \
+                                  ((PORT_ID) == PORTC_ID) ? &PORTC : &PORTD))
+#define GPIO_PIN_REG(PORT_ID)  (*(((PORT_ID) == PORTA_ID) ? &PINA : ((PORT_ID) == PORTB_ID) ? &PINB : \
+                                  ((PORT_ID) == PORTC_ID) ? &PINC : &PIND))
+
+/*
+ * Compile-time GPIO access: the same requests as the functions below, without the call, the
+ * checks and the switch. With constant port and pin numbers a pin access is one instruction
+ * (sbi, cbi, sbis/sbic) once optimized. The arguments are not checked and may be evaluated
+ * more than once, the functions stay for the port and pin numbers known at run time.
+ */
+#define GPIO_SETUP_PIN_DIRECTION(PORT_ID,PIN_ID,DIRECTION) \
+	do{ \
+		if((DIRECTION) == PIN_OUTPUT) { SET_BIT(GPIO_DDR_REG(PORT_ID),(PIN_ID)); } \
+		else { CLEAR_BIT(GPIO_DDR_REG(PORT_ID),(PIN_ID)); } \
+	}while(0)
+
+#define GPIO_WRITE_PIN(PORT_ID,PIN_ID,VALUE) \
+	do{ \
+		if((VALUE) == LOGIC_HIGH) { SET_BIT(GPIO_PORT_REG(PORT_ID),(PIN_ID)); } \
+		else { CLEAR_BIT(GPIO_PORT_REG(PORT_ID),(PIN_ID)); } \
+	}while(0)
+
+#define GPIO_READ_PIN(PORT_ID,PIN_ID) \
+	(BIT_IS_SET(GPIO_PIN_REG(PORT_ID),(PIN_ID)) ? LOGIC_HIGH : LOGIC_LOW)
+
+#define GPIO_SETUP_PORT_DIRECTION(PORT_ID,DIRECTION)	(GPIO_DDR_REG(PORT_ID) = (DIRECTION))
+#define GPIO_WRITE_PORT(PORT_ID,VALUE)					(GPIO_PORT_REG(PORT_ID) = (VALUE))
+#define GPIO_READ_PORT(PORT_ID)							(GPIO_PIN_REG(PORT_ID))
+
+/*
+ * Batch access: the pins of MASK are written in one store (no intermediate state on the
+ * pins), the other pins keep their value. The read-modify-write is done with the interrupts
+ * disabled, so it is safe against an ISR writing the same port.
+ */
+#define GPIO_WRITE_PORT_MASKED(PORT_ID,MASK,VALUE) \
+	do{ \
+		uint8 gpio_sreg; \
+		PORT_ENTER_CRITICAL(gpio_sreg); \
+		GPIO_PORT_REG(PORT_ID) = (GPIO_PORT_REG(PORT_ID) & (uint8)~(MASK)) | ((VALUE) & (MASK)); \
+		PORT_EXIT_CRITICAL(gpio_sreg); \
+	}while(0)
+
+#define GPIO_SETUP_PORT_DIRECTION_MASKED(PORT_ID,MASK,DIRECTION) \
+	do{ \
+		uint8 gpio_sreg; \
+		PORT_ENTER_CRITICAL(gpio_sreg); \
+		GPIO_DDR_REG(PORT_ID) = (GPIO_DDR_REG(PORT_ID) & (uint8)~(MASK)) | ((DIRECTION) & (MASK)); \
+		PORT_EXIT_CRITICAL(gpio_sreg); \
+	}while(0)
+
 /*******************************************************************************
  *                               Types Declaration                             *
  *******************************************************************************/
@@ -99,4 +158,20 @@ void GPIO_writePort(uint8 port_num, uint8 value);
  */
 uint8 GPIO_readPort(uint8 port_num);
 
+/*
+ * Description :
+ * Write the value on the pins of the mask in one store, the other pins of the port keep
+ * their value. The interrupts are disabled during the read-modify-write.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writePortMasked(uint8 port_num, uint8 mask, uint8 value);
+
+/*
+ * Description :
+ * Setup the direction of the pins of the mask in one store (PORT_INPUT: input pins,
+ * PORT_OUTPUT: output pins), the other pins of the port keep their direction.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setupPortDirectionMasked(uint8 port_num, uint8 mask, uint8 direction);
+
 #endif /* GPIO_H_ */
@@ -0,0 +1,60 @@
+ /******************************************************************************
+ *
+ * [Module]: Port
+ *
+ * [File Name]: port.h
+ *
+ * [Description]: Port layer of the drivers, their only access to the registers and to the
+ * 				  interrupts of the micro-controller:
+ * 				  - AVR backend: the avr-libc registers themselves, the macros below are
+ * 				    plain register accesses (no overhead on the target).
+ * 				  - Linux backend (Code/Host/include/port_host.h): a simulated ATmega16, so
+ * 				    the same drivers run in the host builds.
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef PORT_H_
+#define PORT_H_
+
+#include "std_types.h"
+
+#if defined(__AVR__)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Access of the registers with side effects on read or write (data registers and
+ * write-one-to-clear flags: UDR, UCSRA, TWCR), the simulated peripherals of the Linux
+ * backend act on these accesses. The other registers are used directly.
+ */
+#define PORT_READ_REG(REG)				(REG)
+#define PORT_WRITE_REG(REG,VALUE)		((REG) = (VALUE))
+
+/* Critical section: the interrupts are disabled, STATE keeps the status register */
+#define PORT_ENTER_CRITICAL(STATE)		do{ (STATE) = SREG; cli(); }while(0)
+#define PORT_EXIT_CRITICAL(STATE)		(SREG = (STATE))
+
+/*
+ * Sleep until the next interrupt in MODE (SLEEP_MODE_IDLE ...), called with the interrupts
+ * disabled after the check that nothing is left to do: the I-bit is set by the instruction
+ * just before SLEEP, an interrupt that comes after the check wakes the CPU at once. The
+ * interrupts are enabled after it.
+ */
+#define PORT_SLEEP(MODE)				do{ set_sleep_mode(MODE); sleep_enable(); sei(); \
+											sleep_cpu(); sleep_disable(); }while(0)
+
+#else
+
+#include "port_host.h"	/* Linux backend */
+
+#endif
+
+#endif /* PORT_H_ */
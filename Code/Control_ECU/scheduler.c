@@ -0,0 +1,114 @@
+ /******************************************************************************
+ *
+ * [Module]: SCHEDULER
+ *
+ * [File Name]: scheduler.c
+ *
+ * [Description]: Source file for the cooperative scheduler
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include "scheduler.h"
+#include "port.h"	/* For the critical sections and the sleep */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Task table of the application */
+static const SCHEDULER_TaskType *g_tasks_Ptr = NULL_PTR;
+static uint8 g_numOfTasks = 0;
+
+/* Called when no task is ready, instead of SCHEDULER_sleep */
+static void (*g_idleHook_Ptr)(void) = NULL_PTR;
+
+/* Ready flags, bit n for the task n (written by the ISRs too) */
+static volatile uint8 g_readyTasks = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Take the task table of the application (index = task ID, index 0 has the highest priority)
+ * and the idle hook, called when no task is ready with the interrupts disabled: it sleeps with
+ * SCHEDULER_sleep and may program the wake up before (NULL_PTR: SCHEDULER_sleep only). The
+ * ready flags set before (by the ISRs) are kept.
+ */
+void SCHEDULER_init(const SCHEDULER_TaskType *Tasks_Ptr, uint8 numOfTasks, void (*idleHook_Ptr)(void))
+{
+	g_tasks_Ptr = Tasks_Ptr;
+	g_numOfTasks = (numOfTasks > SCHEDULER_MAX_TASKS) ? SCHEDULER_MAX_TASKS : numOfTasks;
+	g_idleHook_Ptr = idleHook_Ptr;
+}
+
+/*
+ * Description :
+ * Set the ready flag of a task, it runs once after the running task (also from an ISR, the
+ * flags set again before the task runs are merged).
+ */
+void SCHEDULER_setReady(uint8 taskId)
+{
+	uint8 sreg;
+
+	/* Read-modify-write of a flag byte shared with the ISRs */
+	PORT_ENTER_CRITICAL(sreg);
+	g_readyTasks |= (1<<taskId);
+	PORT_EXIT_CRITICAL(sreg);
+}
+
+/*
+ * Description :
+ * Run the ready task of the highest priority (its flag is cleared first) or the idle hook,
+ * forever. It never returns.
+ */
+void SCHEDULER_run(void)
+{
+	uint8 taskId;
+	uint8 ready;
+	uint8 sreg;
+
+	while(1)
+	{
+		/* Take the first ready task: after every task the table is checked again from the
+		 * highest priority */
+		PORT_ENTER_CRITICAL(sreg);
+		ready = g_readyTasks;
+		for(taskId = 0; taskId < g_numOfTasks; taskId++)
+		{
+			if(ready & (1<<taskId))
+			{
+				g_readyTasks = ready & ~(1<<taskId);
+				break;
+			}
+		}
+
+		if(taskId < g_numOfTasks)
+		{
+			PORT_EXIT_CRITICAL(sreg);
+			(*g_tasks_Ptr[taskId])();
+		}
+		else if(g_idleHook_Ptr != NULL_PTR)
+		{
+			(*g_idleHook_Ptr)();	/* Still in the critical section, it ends with the sleep */
+		}
+		else
+		{
+			SCHEDULER_sleep();
+		}
+	}
+}
+
+/*
+ * Description :
+ * Sleep in SCHEDULER_SLEEP_MODE until the next interrupt, called from the idle hook with the
+ * interrupts disabled (a task made ready after the check of the flags wakes it at once). The
+ * interrupts are enabled after it.
+ */
+void SCHEDULER_sleep(void)
+{
+	PORT_SLEEP(SCHEDULER_SLEEP_MODE);
+}
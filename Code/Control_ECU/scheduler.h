@@ -0,0 +1,71 @@
+ /******************************************************************************
+ *
+ * [Module]: SCHEDULER
+ *
+ * [File Name]: scheduler.h
+ *
+ * [Description]: Header file for the cooperative scheduler. The tasks of the application run
+ * 				  to completion in the main loop, a task runs when its ready flag is set (by an
+ * 				  ISR or by another task), the first tasks of the table have the priority.
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SCHEDULER_MAX_TASKS            8      /* One bit of the ready flags per task */
+
+/*
+ * Sleep mode of the CPU when no task is ready. Idle: the CPU clock is stopped, the UART, the
+ * TWI and the timers run and their interrupts wake it (the power-save mode stops the UART and
+ * Timer1, only Timer2 and the external interrupts would wake it).
+ */
+#define SCHEDULER_SLEEP_MODE           SLEEP_MODE_IDLE
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef void (*SCHEDULER_TaskType)(void);
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Take the task table of the application (index = task ID, index 0 has the highest priority)
+ * and the idle hook, called when no task is ready with the interrupts disabled: it sleeps with
+ * SCHEDULER_sleep and may program the wake up before (NULL_PTR: SCHEDULER_sleep only). The
+ * ready flags set before (by the ISRs) are kept.
+ */
+void SCHEDULER_init(const SCHEDULER_TaskType *Tasks_Ptr, uint8 numOfTasks, void (*idleHook_Ptr)(void));
+
+/*
+ * Description :
+ * Set the ready flag of a task, it runs once after the running task (also from an ISR, the
+ * flags set again before the task runs are merged).
+ */
+void SCHEDULER_setReady(uint8 taskId);
+
+/*
+ * Description :
+ * Run the ready task of the highest priority (its flag is cleared first) or the idle hook,
+ * forever. It never returns.
+ */
+void SCHEDULER_run(void);
+
+/*
+ * Description :
+ * Sleep in SCHEDULER_SLEEP_MODE until the next interrupt, called from the idle hook with the
+ * interrupts disabled (a task made ready after the check of the flags wakes it at once). The
+ * interrupts are enabled after it.
+ */
+void SCHEDULER_sleep(void);
+
+#endif /* SCHEDULER_H_ */
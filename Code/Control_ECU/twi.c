@@ -13,7 +13,7 @@
 #include "twi.h"
 
 #include "common_macros.h"
-#include <avr/io.h>
+#include "port.h" /* To use the TWI Registers */
 
 
 /*******************************************************************************
@@ -39,7 +39,7 @@ void TWI_init(const TWI_ConfigType *Config_Ptr)
     TWAR = ((Config_Ptr->slaveAddress)<<1);
 	
     /* enable TWI */
-    TWCR = (1<<TWEN);
+    PORT_WRITE_REG(TWCR, (1<<TWEN));
 }
 
 
@@ -54,7 +54,7 @@ void TWI_start(void)
 	 * send the start bit by TWSTA=1
 	 * Enable TWI Module TWEN=1 
 	 */
-    TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
+    PORT_WRITE_REG(TWCR, (1 << TWINT) | (1 << TWSTA) | (1 << TWEN));
     
     /* Wait for TWINT flag set in TWCR Register (start bit is send successfully) */
     while(BIT_IS_CLEAR(TWCR,TWINT));
@@ -72,7 +72,7 @@ void TWI_stop(void)
 	 * send the stop bit by TWSTO=1
 	 * Enable TWI Module TWEN=1 
 	 */
-    TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+    PORT_WRITE_REG(TWCR, (1 << TWINT) | (1 << TWSTO) | (1 << TWEN));
 }
 
 
@@ -84,7 +84,7 @@ void TWI_writeByte(uint8 data)
 	 * Clear the TWINT flag before sending the data TWINT=1
 	 * Enable TWI Module TWEN=1 
 	 */ 
-    TWCR = (1 << TWINT) | (1 << TWEN);
+    PORT_WRITE_REG(TWCR, (1 << TWINT) | (1 << TWEN));
     /* Wait for TWINT flag set in TWCR Register(data is send successfully) */
     while(BIT_IS_CLEAR(TWCR,TWINT));
 }
@@ -98,7 +98,7 @@ uint8 TWI_readByteWithACK(void)
 	 * Enable sending ACK after reading or receiving data TWEA=1
 	 * Enable TWI Module TWEN=1 
 	 */ 
-    TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
+    PORT_WRITE_REG(TWCR, (1 << TWINT) | (1 << TWEN) | (1 << TWEA));
     /* Wait for TWINT flag set in TWCR Register (data received successfully) */
     while(BIT_IS_CLEAR(TWCR,TWINT));
     /* Read Data */
@@ -112,7 +112,7 @@ uint8 TWI_readByteWithNACK(void)
 	 * Clear the TWINT flag before reading the data TWINT=1
 	 * Enable TWI Module TWEN=1 
 	 */
-    TWCR = (1 << TWINT) | (1 << TWEN);
+    PORT_WRITE_REG(TWCR, (1 << TWINT) | (1 << TWEN));
     /* Wait for TWINT flag set in TWCR Register (data received successfully) */
     while(BIT_IS_CLEAR(TWCR,TWINT));
     /* Read Data */
@@ -15,6 +15,105 @@
 
 #include "std_types.h"
 
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * UART transfer mode:
+ * TRUE  -> The RXC/UDRE interrupts move the bytes between UDR and two ring buffers,
+ * 			the application never waits for the hardware flags.
+ * FALSE -> The driver polls the RXC/UDRE flags (blocking driver).
+ */
+#define UART_INTERRUPT_MODE			TRUE
+
+/* Size of the ring buffers in bytes, must be a power of 2 (2, 4, 8 ... 128) */
+#define UART_RX_BUFFER_SIZE			32
+#define UART_TX_BUFFER_SIZE			32
+
+/* Baud rate used when the requested one can't be generated with an acceptable error */
+#define UART_DEFAULT_BAUD_RATE		9600
+
+/*
+ * Maximum accepted baud rate error in per-mille (8 data bits, no parity), from the ATmega16
+ * datasheet recommended maximum receiver error: 2.0% in normal speed and 1.5% in double
+ * speed (U2X = 1).
+ */
+#define UART_MAX_ERROR_NORMAL_SPEED	20
+#define UART_MAX_ERROR_DOUBLE_SPEED	15
+
+/* UBRR is a 12-bit register */
+#define UART_MAX_UBRR_VALUE			4095
+
+/*
+ * Period of the UART_tick calls in ms, the application subscribes UART_tick to its timer
+ * (Timer_subscribe). It is the time base (and the resolution) of the receive timeouts.
+ */
+#define UART_TICK_PERIOD_MS			10
+
+/*
+ * A frame in progress is dropped if no byte is received for this time (the bytes of a frame
+ * are sent back to back), so a lost byte costs one frame only and not the next frames.
+ */
+#ifndef UART_FRAME_GAP_TIMEOUT_MS
+#define UART_FRAME_GAP_TIMEOUT_MS	(3 * UART_TICK_PERIOD_MS)
+#endif
+
+/*
+ * TRUE if more than TIMEOUT_MS passed since START (a UART_getTime value).
+ * It is safe when the time wraps around, for timeouts up to 65535 - UART_TICK_PERIOD_MS.
+ */
+#define UART_TIME_ELAPSED(START,TIMEOUT_MS)	((uint16)(UART_getTime() - (START)) > (TIMEOUT_MS))
+
+/*
+ * Link trace:
+ * TRUE  -> Every byte written to UDR or read from UDR is recorded with its direction and time
+ * 			in a RAM ring buffer (the last UART_TRACE_SIZE bytes), UART_traceDump sends the
+ * 			records in frames for the host decoder (Code/Host/trace_decoder.c).
+ * 			A record costs a few cycles in the UART ISRs and 4 bytes of RAM. A record holds
+ * 			the 6 low bits of its tick, a marker record before it holds the ticks passed since
+ * 			the last record when they don't fit.
+ * FALSE -> No trace.
+ */
+#define UART_TRACE_ENABLE			TRUE
+#define UART_TRACE_SIZE				32		/* Number of records, must be a power of 2 */
+
+/*
+ * Time of the trace records, read with the interrupts disabled: ticks of the timer that calls
+ * UART_tick at the start of its running period (the ticks skipped by a tickless idle included)
+ * and the counts of its counter since this start. UART_TRACE_TICK_COUNTS is the counts of one
+ * tick (Timer1 at F_CPU / 64).
+ */
+#define UART_TRACE_TIME_STAMP(COUNTS_PTR)	Timer_getTickStamp(COUNTS_PTR)
+#define UART_TRACE_TICK_COUNTS		((uint16)(((F_CPU / 64UL) * UART_TICK_PERIOD_MS) / 1000UL))
+
+/* Trace record info: direction (bit 7), marker record (bit 6) and the low bits of the tick */
+#define UART_TRACE_RX				0x00
+#define UART_TRACE_TX				0x80
+#define UART_TRACE_MARKER			0x40
+#define UART_TRACE_TICK_MASK		0x3F
+
+/*
+ * Multi-drop bus (one Control ECU and many HMI panels on a shared half-duplex RS-485 bus):
+ * TRUE  -> 9-bit frames, the 9th bit marks the address bytes. Every transmission starts with
+ * 			an address byte (UART_sendAddress) and a node receives only the bytes after its
+ * 			address byte (UART_setAddress): the multi-processor communication mode (MPCM)
+ * 			drops the other bytes in hardware, they never wake the node. The transceiver
+ * 			driver is enabled by every queued byte and released by the TXC interrupt when
+ * 			the TX buffer is empty (UART_flush waits for this interrupt).
+ * 			It needs the interrupt mode.
+ * FALSE -> Point-to-point link, 8-bit frames.
+ */
+#define UART_MULTIDROP_ENABLE		FALSE
+
+/* Driver enable (DE and /RE tied) pin of the RS-485 transceiver */
+#define UART_BUS_DRIVER_PORT		PORTD
+#define UART_BUS_DRIVER_DDR			DDRD
+#define UART_BUS_DRIVER_PIN			PD2
+
+#if (UART_MULTIDROP_ENABLE == TRUE) && (UART_INTERRUPT_MODE == FALSE)
+#error "The multi-drop bus needs UART_INTERRUPT_MODE"
+#endif
 
 /*******************************************************************************
  *                      Type Declaration                                   *
@@ -40,6 +139,26 @@ typedef struct{
 	uint32 baud_rate;
 }UART_ConfigType;
 
+typedef struct{
+	uint16 ubrr_value;		/* Value of UBRRH:UBRRL */
+	uint8 double_speed;		/* U2X bit value */
+	sint16 error;			/* Actual baud rate error in per-mille (+ means faster) */
+}UART_BaudSettingType;
+
+/*
+ * One byte of the link trace, or a marker record (UART_TRACE_MARKER) before a record that is
+ * UART_TRACE_TICK_MASK ticks or more after the last one: its data and counter are the bits
+ * 16-23 and 0-15 of the ticks passed (0xFFFFFF: at least)
+ */
+typedef struct{
+	uint8 data;
+	uint8 info;			/* Direction (UART_TRACE_TX/RX), marker and the low bits of the tick */
+	uint16 counter;		/* Timer counts since the start of the tick (UART_TRACE_TIME_STAMP) */
+}UART_TraceRecordType;
+
+/* Called from the RX ISR when a valid frame is completely received in the caller buffer */
+typedef void (*UART_FrameCallBackType)(uint8 type, uint8 length);
+
 
 
 /************************************************************************
@@ -59,7 +178,8 @@ extern volatile uint8 g_receivedValue;
  * 					1. Setup the Frame format like number of data bits, parity bit type
  * 					   and number of stop bits.
  * 					2. Enable the UART.
- * 					3. Setup the UART baud rate.
+ * 					3. Setup the UART baud rate, UART_DEFAULT_BAUD_RATE is used if the
+ * 					   required one is not safe.
  *
  * [Arguments]: const UART_ConfigType * Config_Ptr
  *
@@ -74,6 +194,90 @@ void UART_init(const UART_ConfigType * Config_Ptr);
 
 
 
+/********************************************************************************************
+ *
+ * [Function Name]: UART_calculateBaudSetting
+ *
+ * [Description]: Functional responsible for finding the best U2X/UBRR pair for the required
+ * 				  baud rate with F_CPU clock:
+ * 					1. Calculate the rounded UBRR value in normal and double speed.
+ * 					2. Select the pair with the smallest error (normal speed if equal as
+ * 					   it samples each bit more times).
+ * 					3. Check the error against the maximum accepted error.
+ *
+ * [Arguments]: uint32 baud_rate, UART_BaudSettingType *Setting_Ptr
+ *
+ * [in]: baud_rate: The required baud rate
+ *
+ * [out]: *Setting_Ptr: The selected UBRR/U2X pair and its error
+ *
+ * [Returns]: TRUE if the baud rate is safe to be used, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 UART_calculateBaudSetting(uint32 baud_rate, UART_BaudSettingType *Setting_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_setBaudRate
+ *
+ * [Description]: Functional responsible for changing the baud rate after sending all the
+ * 				  queued bytes, unsafe baud rates are refused and the current one is kept.
+ * 				  The line errors count starts again.
+ *
+ * [Arguments]: uint32 baud_rate
+ *
+ * [in]: baud_rate: The required baud rate
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if the baud rate is changed, FALSE if it is refused
+ *
+ ********************************************************************************************/
+uint8 UART_setBaudRate(uint32 baud_rate);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_getBaudRate
+ *
+ * [Description]: Functional responsible for returning the baud rate in use.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use
+ *
+ ********************************************************************************************/
+uint32 UART_getBaudRate(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_flush
+ *
+ * [Description]: Functional responsible for waiting until all the queued bytes are completely
+ * 				  shifted out of the transmitter.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_flush(void);
+
+
+
 /********************************************************************************************
  *
  * [Function Name]: UART_sendByte
@@ -112,6 +316,332 @@ uint8 UART_recieveByte(void);
 
 
 
+/********************************************************************************************
+ *
+ * [Function Name]: UART_tryReceive
+ *
+ * [Description]: Non-blocking receive, takes one byte from the RX ring buffer (or from UDR
+ * 				  in the polling mode) if there is any.
+ *
+ * [Arguments]: uint8 *data_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: *data_Ptr: The received byte (not touched if there is no byte)
+ *
+ * [Returns]: TRUE if a byte is received, FALSE if there is no received byte
+ *
+ ********************************************************************************************/
+uint8 UART_tryReceive(uint8 *data_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_recieveByteTimeout
+ *
+ * [Description]: Functional responsible for receiving one byte with a deadline, the function
+ * 				  returns if no byte is received for timeout_ms instead of waiting forever.
+ *
+ * [Arguments]: uint16 timeout_ms, uint8 *data_Ptr
+ *
+ * [in]: timeout_ms: The maximum waiting time in ms (rounded up to UART_TICK_PERIOD_MS)
+ *
+ * [out]: *data_Ptr: The received byte (not touched in case of timeout)
+ *
+ * [Returns]: TRUE if a byte is received, FALSE in case of timeout
+ *
+ ********************************************************************************************/
+uint8 UART_recieveByteTimeout(uint16 timeout_ms, uint8 *data_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_tick
+ *
+ * [Description]: Functional responsible for advancing the UART time by UART_TICK_PERIOD_MS,
+ * 				  it must be called every UART_TICK_PERIOD_MS (from the timer ISR) for the
+ * 				  receive timeouts to expire. A tickless idle may skip the ticks while no
+ * 				  frame is in progress (UART_isFrameInProgress): the UART time then counts
+ * 				  the time of the link activity only.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_tick(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_traceDump
+ *
+ * [Description]: Functional responsible for sending the link trace (UART_TRACE_ENABLE) as
+ * 				  frames then clearing it:
+ * 					1. FRAME_TYPE_TRACE_INFO: tick period in ms, timer counts per tick (2
+ * 					   bytes) and the number of records.
+ * 					2. FRAME_TYPE_TRACE_DATA: up to 4 records each (data, info, counter high
+ * 					   and low bytes) from the oldest one, markers included.
+ * 					3. Empty FRAME_TYPE_TRACE_DATA frame at the end.
+ * 				  The dump itself is not traced, the recording starts again after it.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_traceDump(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_tracePause
+ *
+ * [Description]: Functional responsible for stopping the link trace recording until the next
+ * 				  UART_traceDump, so the trace dump of the other ECU doesn't overwrite it.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_tracePause(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_getTime
+ *
+ * [Description]: Functional responsible for reading the UART time (advanced by UART_tick).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned short
+ *
+ * [Returns]: The time in ms, it wraps around after 65535
+ *
+ ********************************************************************************************/
+uint16 UART_getTime(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_queueSend
+ *
+ * [Description]: Non-blocking send, puts one byte in the TX ring buffer and the UDRE interrupt
+ * 				  sends it in the background (in the polling mode the byte is written in UDR
+ * 				  directly if it is empty).
+ *
+ * [Arguments]: const uint8 data
+ *
+ * [in]: data: unsigned character
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if the byte is queued, FALSE if the TX buffer is full
+ *
+ ********************************************************************************************/
+uint8 UART_queueSend(const uint8 data);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_receiveFrameInto
+ *
+ * [Description]: Functional responsible for receiving the next frame (frame.h format) directly
+ * 				  in the caller buffer:
+ * 					1. The RX ISR hunts the start byte and checks the length and the CRC of
+ * 					   the frame while writing the payload in the buffer (no staging copy).
+ * 					2. Frames with wrong CRC or longer than the buffer are dropped and the ISR
+ * 					   hunts the next start byte.
+ * 					3. When a valid frame is received, the callback is called (from the ISR)
+ * 					   and UART_isFrameReceived returns TRUE.
+ * 				  The bytes that are already in the RX buffer are parsed first. The RX buffer
+ * 				  is not used until the frame is received or cancelled.
+ *
+ * [Arguments]: uint8 *buffer_Ptr, uint8 maxLength, UART_FrameCallBackType a_callBack_Ptr
+ *
+ * [in]: - *buffer_Ptr: The buffer of the payload, it must be kept until the frame is received
+ * 		 - maxLength: Size of the buffer
+ * 		 - a_callBack_Ptr: Completion callback (NULL_PTR to use UART_isFrameReceived only)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_receiveFrameInto(uint8 *buffer_Ptr, uint8 maxLength, UART_FrameCallBackType a_callBack_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_isFrameReceived
+ *
+ * [Description]: Functional responsible for checking the completion of UART_receiveFrameInto,
+ * 				  the frame receive ends when this function returns TRUE.
+ *
+ * [Arguments]: uint8 *type_Ptr, uint8 *length_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: - *type_Ptr: The type of the received frame
+ * 		  - *length_Ptr: The payload length of the received frame
+ *
+ * [Returns]: TRUE if a valid frame is received in the buffer, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 UART_isFrameReceived(uint8 *type_Ptr, uint8 *length_Ptr);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_cancelFrameReceive
+ *
+ * [Description]: Functional responsible for stopping UART_receiveFrameInto, the next bytes
+ * 				  go to the RX buffer again.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_cancelFrameReceive(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_isFrameInProgress
+ *
+ * [Description]: Functional responsible for checking if a frame of UART_receiveFrameInto is
+ * 				  being received (from its start byte to its CRC), the gap between its bytes
+ * 				  is measured by the UART time.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if a frame is in progress, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 UART_isFrameInProgress(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_getLineErrors
+ *
+ * [Description]: Functional responsible for returning the number of line errors in a row:
+ * 				  received bytes with a framing or overrun error and frames with a wrong CRC
+ * 				  (up to 255). A valid frame and a new baud rate clear it.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: The number of line errors since the last valid frame
+ *
+ ********************************************************************************************/
+uint8 UART_getLineErrors(void);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_setLineErrorCallBack
+ *
+ * [Description]: Functional responsible for setting the call back of the line errors, it is
+ * 				  called from the RX ISR for each line error (see UART_getLineErrors).
+ *
+ * [Arguments]: void(*a_ptr)(void)
+ *
+ * [in]: a_ptr: Pointer to the call back function (NULL_PTR for none)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_setLineErrorCallBack(void(*a_ptr)(void));
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_setAddress
+ *
+ * [Description]: Multi-drop bus only (UART_MULTIDROP_ENABLE): receive only the bytes sent after
+ * 				  the address byte a_address, the bytes sent to the other addresses are dropped
+ * 				  by the hardware (MPCM) until the next address byte.
+ * 				  The HMI panels set their own address once, the Control ECU sets the address
+ * 				  of the polled panel before each poll to get its answer only.
+ *
+ * [Arguments]: uint8 a_address
+ *
+ * [in]: a_address: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_setAddress(uint8 a_address);
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_sendAddress
+ *
+ * [Description]: Multi-drop bus only (UART_MULTIDROP_ENABLE): queue one address byte (9th bit
+ * 				  set) to start a new transmission on the bus, the bytes queued after it are
+ * 				  received by the node(s) of this address only. It enables the bus driver.
+ *
+ * [Arguments]: uint8 a_address
+ *
+ * [in]: a_address: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_sendAddress(uint8 a_address);
+
+
+
 /****************************************************************************************
  *
  * [Function Name]: UART_sendString
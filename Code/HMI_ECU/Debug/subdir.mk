@@ -4,26 +4,35 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../frame.c \
 ../gpio.c \
 ../hmi_ecu.c \
 ../keypad.c \
 ../lcd.c \
+../scheduler.c \
+../screen.c \
 ../timer.c \
 ../uart.c 
 
 OBJS += \
+./frame.o \
 ./gpio.o \
 ./hmi_ecu.o \
 ./keypad.o \
 ./lcd.o \
+./scheduler.o \
+./screen.o \
 ./timer.o \
 ./uart.o 
 
 C_DEPS += \
+./frame.d \
 ./gpio.d \
 ./hmi_ecu.d \
 ./keypad.d \
 ./lcd.d \
+./scheduler.d \
+./screen.d \
 ./timer.d \
 ./uart.d 
 
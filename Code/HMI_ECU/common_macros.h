@@ -34,4 +34,7 @@
 /* Check if a specific bit is cleared in any register and return true if yes */
 #define BIT_IS_CLEAR(REG,BIT) ( !(REG & (1<<BIT)) )
 
+/* Absolute value of a signed number */
+#define ABS(NUM) ( ((NUM) < 0) ? -(NUM) : (NUM) )
+
 #endif
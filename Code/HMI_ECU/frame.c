@@ -0,0 +1,739 @@
+ /******************************************************************************
+ *
+ * [Module]: FRAME
+ *
+ * [File Name]: frame.c
+ *
+ * [Description]: Source file for the framed UART protocol shared by the HMI and
+ * 				  Control ECUs
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include "frame.h"
+#include "uart.h"
+
+/*******************************************************************************
+ *                           Private Types                                     *
+ *******************************************************************************/
+#if (UART_MULTIDROP_ENABLE == FALSE)
+typedef enum{
+	FRAME_BAUD_IDLE,			/* No baud rate exchange */
+	FRAME_BAUD_REQUEST,			/* HMI: request sent, wait for the accept frame */
+	FRAME_BAUD_SWITCH,			/* HMI: new baud rate set, let the Control ECU switch */
+	FRAME_BAUD_CHECK,			/* HMI: link check sent, wait for its echo */
+	FRAME_BAUD_FALLBACK,		/* HMI: back to the default baud rate, let the Control ECU too */
+	FRAME_BAUD_ANSWER			/* Control: echo the link checks at the new baud rate */
+}FRAME_BaudStateType;
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* CRC-8 of each nibble value (polynomial 0x07) */
+const uint8 g_frameCrc8Table[16] = {
+		0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+		0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+/*******************************************************************************
+ *                           Private Variables                                 *
+ *******************************************************************************/
+
+#if (UART_MULTIDROP_ENABLE == FALSE)
+/* Baud rates offered in the startup negotiation, fastest first */
+static const uint32 g_baudRates[FRAME_NUM_OF_BAUD_RATES] = FRAME_BAUD_RATES;
+
+/* Baud rate exchange in progress (see FRAME_serviceBaudRate) */
+static FRAME_BaudStateType g_baudState = FRAME_BAUD_IDLE;
+static uint8 g_baudOffered;			/* HMI: mask of the baud rates still offered */
+static uint8 g_baudIndex;			/* Index of the baud rate being checked */
+static uint8 g_baudTrial;			/* HMI: frames sent in the current step */
+static uint8 g_baudConfirmed;		/* Control: a link check is echoed at the new baud rate */
+static uint16 g_baudTime;			/* UART time at the start of the current wait */
+static uint8 g_baudFrame[FRAME_MAX_PAYLOAD_LENGTH];	/* Payload of the received answer */
+#endif
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Let the RX ISR receive the next valid frame directly in the caller buffer and wait for it
+ * until timeout_ms passes since the start time (no deadline with FRAME_WAIT_FOREVER).
+ */
+static FRAME_Status FRAME_receiveFrame(uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr,
+		uint8 *length_Ptr, uint16 start, uint16 timeout_ms)
+{
+	UART_receiveFrameInto(buffer_Ptr, maxLength, NULL_PTR);
+
+	while(UART_isFrameReceived(type_Ptr, length_Ptr) == FALSE)
+	{
+		if((timeout_ms != FRAME_WAIT_FOREVER) && UART_TIME_ELAPSED(start, timeout_ms))
+		{
+			UART_cancelFrameReceive();
+			return FRAME_TIMEOUT;
+		}
+	}
+	return FRAME_OK;
+}
+
+#if (UART_MULTIDROP_ENABLE == FALSE)
+/*
+ * Description :
+ * Wait at most timeout_ms for a valid frame of the required type with one byte payload,
+ * other frames are ignored.
+ * Returns TRUE and the payload byte if the frame is received before the timeout.
+ */
+static uint8 FRAME_waitByteFrame(uint8 type, uint8 *data_Ptr, uint16 timeout_ms)
+{
+	FRAME_Type frame;
+	uint16 start = UART_getTime();
+	FRAME_Status status;
+
+	do
+	{
+		status = FRAME_receiveFrame(frame.payload, FRAME_MAX_PAYLOAD_LENGTH, &frame.type,
+				&frame.length, start, timeout_ms);
+		if((status == FRAME_OK) && (frame.type == type) && (frame.length == 1))
+		{
+			*data_Ptr = frame.payload[0];
+			return TRUE;
+		}
+	}while(status != FRAME_TIMEOUT);
+
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Send the link check frame of the baud rate index (maximum payload length).
+ */
+static void FRAME_sendCheckFrame(uint8 index)
+{
+	uint8 payload[FRAME_BAUD_CHECK_LENGTH];
+	uint8 i;
+
+	payload[0] = index;
+	for(i = 1; i < FRAME_BAUD_CHECK_LENGTH; i++)
+	{
+		payload[i] = FRAME_BAUD_CHECK_BYTE(i);
+	}
+	FRAME_send(FRAME_TYPE_BAUD_CONFIRM, payload, FRAME_BAUD_CHECK_LENGTH);
+}
+
+/*
+ * Description :
+ * Return TRUE if the frame received in g_baudFrame is the link check frame of the baud rate
+ * being checked (check frames with a wrong byte are ignored).
+ */
+static uint8 FRAME_isCheckFrame(uint8 type, uint8 length)
+{
+	uint8 i;
+
+	if((type != FRAME_TYPE_BAUD_CONFIRM) || (length != FRAME_BAUD_CHECK_LENGTH)
+			|| (g_baudFrame[0] != g_baudIndex))
+	{
+		return FALSE;
+	}
+	for(i = 1; i < FRAME_BAUD_CHECK_LENGTH; i++)
+	{
+		if(g_baudFrame[i] != FRAME_BAUD_CHECK_BYTE(i))
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Return the mask of the negotiation baud rates that this ECU can generate with an
+ * acceptable error, up to FRAME_MAX_BAUD_RATE (the RX ISR latency).
+ */
+static uint8 FRAME_getSupportedBaudRates(void)
+{
+	UART_BaudSettingType baudSetting;
+	uint8 mask = 0;
+	uint8 i;
+
+	for(i = 0; i < FRAME_NUM_OF_BAUD_RATES; i++)
+	{
+		if((g_baudRates[i] <= FRAME_MAX_BAUD_RATE)
+				&& (UART_calculateBaudSetting(g_baudRates[i], &baudSetting) == TRUE))
+		{
+			mask |= (1<<i);
+		}
+	}
+	return mask;
+}
+
+/*
+ * Description :
+ * Send the frame of the current exchange step (the request, or the link check), then let the
+ * RX ISR receive the answer in g_baudFrame and restart the wait.
+ */
+static void FRAME_sendBaudStep(void)
+{
+	if(g_baudState == FRAME_BAUD_REQUEST)
+	{
+		FRAME_send(FRAME_TYPE_BAUD_REQUEST, &g_baudOffered, 1);
+	}
+	else
+	{
+		FRAME_sendCheckFrame(g_baudIndex);
+	}
+	UART_receiveFrameInto(g_baudFrame, FRAME_MAX_PAYLOAD_LENGTH, NULL_PTR);
+	g_baudTime = UART_getTime();
+}
+
+/*
+ * Description :
+ * HMI: offer the baud rates of g_baudOffered at the default baud rate.
+ */
+static void FRAME_requestBaudRate(void)
+{
+	g_baudState = FRAME_BAUD_REQUEST;
+	g_baudTrial = 0;
+	FRAME_sendBaudStep();
+}
+
+/*
+ * Description :
+ * HMI: no expected answer in the current step. Keep waiting if another frame is received,
+ * send the frame again after FRAME_NEGOTIATION_REPLY_MS, and after FRAME_NEGOTIATION_TRIALS
+ * frames give up the request, or fall back from a baud rate that fails the link check.
+ */
+static void FRAME_waitBaudAnswer(uint8 received)
+{
+	if(received == TRUE)
+	{
+		UART_receiveFrameInto(g_baudFrame, FRAME_MAX_PAYLOAD_LENGTH, NULL_PTR);
+	}
+	else if(UART_TIME_ELAPSED(g_baudTime, FRAME_NEGOTIATION_REPLY_MS))
+	{
+		UART_cancelFrameReceive();
+		g_baudTrial++;
+		if(g_baudTrial < FRAME_NEGOTIATION_TRIALS)
+		{
+			FRAME_sendBaudStep();
+		}
+		else if(g_baudState == FRAME_BAUD_REQUEST)
+		{
+			/* No answer, keep the default baud rate */
+			g_baudState = FRAME_BAUD_IDLE;
+		}
+		else
+		{
+			/* The longest frames are not received at this baud rate, fall back and offer the
+			 * slower ones after the Control ECU falls back too */
+			UART_setBaudRate(UART_DEFAULT_BAUD_RATE);
+			g_baudOffered &= (uint8)~(1<<g_baudIndex);
+			g_baudState = FRAME_BAUD_FALLBACK;
+			g_baudTime = UART_getTime();
+		}
+	}
+}
+#endif /* The baud rate negotiation is not used on the multi-drop bus */
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_crc8Update
+ *
+ * [Description]: Update the running CRC-8 with one more byte.
+ *
+ * [Arguments]: uint8 crc, uint8 data
+ *
+ * [in]: - crc: The CRC of the previous bytes
+ * 		 - data: The new byte
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: The updated CRC
+ *
+ ********************************************************************************************/
+uint8 FRAME_crc8Update(uint8 crc, uint8 data)
+{
+	FRAME_CRC8_UPDATE(crc, data);
+	return crc;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_send
+ *
+ * [Description]: Build a frame from the type and the payload and send it through UART in
+ * 				  one burst (no handshake between the bytes).
+ *
+ * [Arguments]: uint8 type, const uint8 *payload_Ptr, uint8 length
+ *
+ * [in]: - type: Frame type (FRAME_TYPE_xxx)
+ * 		 - *payload_Ptr: Pointer to the payload bytes
+ * 		 - length: Number of payload bytes (up to FRAME_MAX_PAYLOAD_LENGTH)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_send(uint8 type, const uint8 *payload_Ptr, uint8 length)
+{
+	uint8 i;
+	uint8 crc = FRAME_CRC8_INITIAL_VALUE;
+
+	if(length > FRAME_MAX_PAYLOAD_LENGTH)
+	{
+		return; /* The receiver will refuse this frame anyway */
+	}
+
+	UART_sendByte(FRAME_START_BYTE);
+
+	UART_sendByte(type);
+	FRAME_CRC8_UPDATE(crc, type);
+
+	UART_sendByte(length);
+	FRAME_CRC8_UPDATE(crc, length);
+
+	for(i = 0; i < length; i++)
+	{
+		UART_sendByte(payload_Ptr[i]);
+		FRAME_CRC8_UPDATE(crc, payload_Ptr[i]);
+	}
+
+	UART_sendByte(crc);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_sendTo
+ *
+ * [Description]: Multi-drop bus (UART_MULTIDROP_ENABLE): send the address byte of the panel
+ * 				  then the frame, only this panel (and the Control ECU when it waits for this
+ * 				  panel) receives it. On the point-to-point link it is FRAME_send.
+ *
+ * [Arguments]: uint8 address, uint8 type, const uint8 *payload_Ptr, uint8 length
+ *
+ * [in]: - address: Panel address on the bus
+ * 		 - type: Frame type (FRAME_TYPE_xxx)
+ * 		 - *payload_Ptr: Pointer to the payload bytes
+ * 		 - length: Number of payload bytes (up to FRAME_MAX_PAYLOAD_LENGTH)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_sendTo(uint8 address, uint8 type, const uint8 *payload_Ptr, uint8 length)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	UART_sendAddress(address);
+#else
+	(void)address;
+#endif
+	FRAME_send(type, payload_Ptr, length);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_receiveTimeout
+ *
+ * [Description]: Wait at most timeout_ms for a valid frame, the RX ISR writes the payload
+ * 				  directly in the caller buffer (no staging copy). Frames with wrong CRC or
+ * 				  longer than the buffer are dropped by the RX ISR. The timeout is measured
+ * 				  by the UART time (UART_tick).
+ *
+ * [Arguments]: uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr, uint8 *length_Ptr,
+ * 				uint16 timeout_ms
+ *
+ * [in]: - maxLength: Size of the caller buffer
+ * 		 - timeout_ms: The maximum waiting time in ms (FRAME_WAIT_FOREVER for no deadline)
+ *
+ * [out]: - *buffer_Ptr: The payload of the received frame
+ * 		  - *type_Ptr: The type of the received frame
+ * 		  - *length_Ptr: The payload length of the received frame
+ *
+ * [Returns]: FRAME_OK if a frame is received, FRAME_TIMEOUT otherwise
+ *
+ ********************************************************************************************/
+FRAME_Status FRAME_receiveTimeout(uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr,
+		uint8 *length_Ptr, uint16 timeout_ms)
+{
+	return FRAME_receiveFrame(buffer_Ptr, maxLength, type_Ptr, length_Ptr, UART_getTime(),
+			timeout_ms);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_receiveInto
+ *
+ * [Description]: Wait for a valid frame, the RX ISR writes the payload directly in the caller
+ * 				  buffer (no staging copy). Frames with wrong CRC or longer than the buffer
+ * 				  are dropped by the RX ISR.
+ *
+ * [Arguments]: uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr, uint8 *length_Ptr
+ *
+ * [in]: maxLength: Size of the caller buffer
+ *
+ * [out]: - *buffer_Ptr: The payload of the received frame
+ * 		  - *type_Ptr: The type of the received frame
+ * 		  - *length_Ptr: The payload length of the received frame
+ *
+ * [Returns]: FRAME_OK
+ *
+ ********************************************************************************************/
+FRAME_Status FRAME_receiveInto(uint8 *buffer_Ptr, uint8 maxLength, uint8 *type_Ptr, uint8 *length_Ptr)
+{
+	return FRAME_receiveFrame(buffer_Ptr, maxLength, type_Ptr, length_Ptr, 0, FRAME_WAIT_FOREVER);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_receive
+ *
+ * [Description]: Wait for a valid frame of any type (up to FRAME_MAX_PAYLOAD_LENGTH payload).
+ *
+ * [Arguments]: FRAME_Type *frame_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: *frame_Ptr: The received frame
+ *
+ * [Returns]: FRAME_OK
+ *
+ ********************************************************************************************/
+FRAME_Status FRAME_receive(FRAME_Type *frame_Ptr)
+{
+	return FRAME_receiveFrame(frame_Ptr->payload, FRAME_MAX_PAYLOAD_LENGTH, &frame_Ptr->type,
+			&frame_Ptr->length, 0, FRAME_WAIT_FOREVER);
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_negotiateBaudRate
+ *
+ * [Description]: Used by the HMI ECU at startup to agree with the Control ECU
+ * 				  on the fastest baud rate supported by both, and wait for the end of the
+ * 				  exchange (see FRAME_startNegotiation).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use after the negotiation
+ *
+ ********************************************************************************************/
+uint32 FRAME_negotiateBaudRate(void)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* All the nodes of the bus share the default baud rate */
+	return UART_getBaudRate();
+#else
+	FRAME_startNegotiation();
+	while(FRAME_serviceBaudRate() == TRUE)
+	{
+	}
+	return UART_getBaudRate();
+#endif
+}
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_startNegotiation
+ *
+ * [Description]: Used by the HMI ECU when the link is lost to start a new
+ * 				  baud rate negotiation without waiting:
+ * 					1. Send the mask of the offered baud rates at the default baud rate.
+ * 					2. Switch to the baud rate accepted by the Control ECU.
+ * 					3. Check the link at the new baud rate with a maximum length frame. If the
+ * 					   Control ECU doesn't answer, go back to the default baud rate and offer
+ * 					   the slower baud rates only (step 1).
+ * 				  The exchange goes on in FRAME_serviceBaudRate.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_startNegotiation(void)
+{
+#if (UART_MULTIDROP_ENABLE == FALSE)
+	/* The Control ECU waits the request at the default baud rate (after its reset too) */
+	UART_setBaudRate(UART_DEFAULT_BAUD_RATE);
+	g_baudOffered = FRAME_getSupportedBaudRates();
+	if(g_baudOffered != 0)
+	{
+		FRAME_requestBaudRate();
+	}
+#endif
+}
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_acceptBaudRate
+ *
+ * [Description]: Used by the Control ECU at startup to answer the HMI ECU negotiation:
+ * 				  wait for the HMI request (keep the default baud rate if no request), answer
+ * 				  it (see FRAME_startBaudAnswer) and wait for the end of the exchange.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use after the negotiation
+ *
+ ********************************************************************************************/
+uint32 FRAME_acceptBaudRate(void)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* All the nodes of the bus share the default baud rate */
+	return UART_getBaudRate();
+#else
+	uint8 request;
+
+	if(FRAME_waitByteFrame(FRAME_TYPE_BAUD_REQUEST, &request, FRAME_NEGOTIATION_WAIT_MS) == FALSE)
+	{
+		return UART_getBaudRate(); /* Nobody is negotiating */
+	}
+	FRAME_startBaudAnswer(request);
+	while(FRAME_serviceBaudRate() == TRUE)
+	{
+	}
+	return UART_getBaudRate();
+#endif
+}
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_startBaudAnswer
+ *
+ * [Description]: Used by the Control ECU to answer a baud rate request of the
+ * 				  HMI ECU without waiting, at startup or later (the HMI ECU negotiates again when
+ * 				  the link is lost):
+ * 					1. Accept the fastest baud rate offered by the HMI and supported here.
+ * 					2. Echo the link checks at the new baud rate, go back to the default baud
+ * 					   rate if the HMI ECU doesn't check the link.
+ * 				  The exchange goes on in FRAME_serviceBaudRate.
+ *
+ * [Arguments]: uint8 a_offeredRates
+ *
+ * [in]: a_offeredRates: Mask of the baud rates offered by the HMI ECU (payload of the request)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void FRAME_startBaudAnswer(uint8 a_offeredRates)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	(void)a_offeredRates;	/* All the nodes of the bus share the default baud rate */
+#else
+	uint8 commonRates;
+	uint8 i;
+
+	/* The fastest baud rate supported by both ECUs is the lowest common bit */
+	commonRates = a_offeredRates & FRAME_getSupportedBaudRates();
+	g_baudIndex = FRAME_NO_BAUD_RATE;
+	for(i = 0; i < FRAME_NUM_OF_BAUD_RATES; i++)
+	{
+		if(commonRates & (1<<i))
+		{
+			g_baudIndex = i;
+			break;
+		}
+	}
+
+	FRAME_send(FRAME_TYPE_BAUD_ACCEPT, &g_baudIndex, 1);
+
+	if((g_baudIndex == FRAME_NO_BAUD_RATE) || (g_baudRates[g_baudIndex] == UART_getBaudRate()))
+	{
+		g_baudState = FRAME_BAUD_IDLE;
+		return;
+	}
+
+	/* The accept frame is sent completely before switching */
+	UART_setBaudRate(g_baudRates[g_baudIndex]);
+	g_baudConfirmed = FALSE;
+	g_baudState = FRAME_BAUD_ANSWER;
+	UART_receiveFrameInto(g_baudFrame, FRAME_MAX_PAYLOAD_LENGTH, NULL_PTR);
+	g_baudTime = UART_getTime();
+#endif
+}
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_serviceBaudRate
+ *
+ * [Description]: Run the next step of the baud rate exchange started by
+ * 				  FRAME_startNegotiation or FRAME_startBaudAnswer, without waiting: check the
+ * 				  received answer or its timeout and send the next frame. It must be called
+ * 				  every UART_TICK_PERIOD_MS (or more often) until it returns FALSE, no other
+ * 				  frame may be received meanwhile.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: TRUE while the exchange is in progress, FALSE when it is over
+ *
+ ********************************************************************************************/
+uint8 FRAME_serviceBaudRate(void)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	return FALSE;
+#else
+	uint8 type;
+	uint8 length;
+	uint8 received = UART_isFrameReceived(&type, &length);
+
+	switch(g_baudState)
+	{
+	case FRAME_BAUD_REQUEST:
+		if((received == TRUE) && (type == FRAME_TYPE_BAUD_ACCEPT) && (length == 1))
+		{
+			g_baudIndex = g_baudFrame[0];
+			if((g_baudIndex >= FRAME_NUM_OF_BAUD_RATES) || ((g_baudOffered & (1<<g_baudIndex)) == 0)
+					|| (g_baudRates[g_baudIndex] == UART_getBaudRate())
+					|| (UART_setBaudRate(g_baudRates[g_baudIndex]) == FALSE))
+			{
+				/* No common faster baud rate, keep the default one */
+				g_baudState = FRAME_BAUD_IDLE;
+			}
+			else
+			{
+				g_baudState = FRAME_BAUD_SWITCH;
+				g_baudTime = UART_getTime();
+			}
+		}
+		else
+		{
+			FRAME_waitBaudAnswer(received);
+		}
+		break;
+	case FRAME_BAUD_SWITCH:
+		if(UART_TIME_ELAPSED(g_baudTime, FRAME_BAUD_SWITCH_DELAY_MS))
+		{
+			/* Check the link at the new baud rate */
+			g_baudState = FRAME_BAUD_CHECK;
+			g_baudTrial = 0;
+			FRAME_sendBaudStep();
+		}
+		break;
+	case FRAME_BAUD_CHECK:
+		if((received == TRUE) && (FRAME_isCheckFrame(type, length) == TRUE))
+		{
+			g_baudState = FRAME_BAUD_IDLE;
+		}
+		else
+		{
+			FRAME_waitBaudAnswer(received);
+		}
+		break;
+	case FRAME_BAUD_FALLBACK:
+		if(UART_TIME_ELAPSED(g_baudTime, FRAME_NEGOTIATION_REPLY_MS))
+		{
+			if(g_baudOffered != 0)
+			{
+				FRAME_requestBaudRate();
+			}
+			else
+			{
+				g_baudState = FRAME_BAUD_IDLE;
+			}
+		}
+		break;
+	case FRAME_BAUD_ANSWER:
+		if((received == TRUE) && (FRAME_isCheckFrame(type, length) == TRUE))
+		{
+			/* Echo every link check, the HMI may repeat it if an answer is lost */
+			g_baudConfirmed = TRUE;
+			FRAME_sendBaudStep();
+		}
+		else if(received == TRUE)
+		{
+			UART_receiveFrameInto(g_baudFrame, FRAME_MAX_PAYLOAD_LENGTH, NULL_PTR);
+		}
+		else if(UART_TIME_ELAPSED(g_baudTime, FRAME_NEGOTIATION_REPLY_MS * FRAME_NEGOTIATION_TRIALS))
+		{
+			UART_cancelFrameReceive();
+			if(g_baudConfirmed == FALSE)
+			{
+				/* The HMI ECU is not talking at the new baud rate, fall back */
+				UART_setBaudRate(UART_DEFAULT_BAUD_RATE);
+			}
+			g_baudState = FRAME_BAUD_IDLE;
+		}
+		break;
+	default:
+		break;
+	}
+	return (g_baudState != FRAME_BAUD_IDLE) ? TRUE : FALSE;
+#endif
+}
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: FRAME_recoverBaudRate
+ *
+ * [Description]: Used by the Control ECU when no frame is received: after
+ * 				  FRAME_RESYNC_LINE_ERRORS line errors in a row the HMI ECU is talking at another
+ * 				  baud rate (reset alone), go back to the default baud rate to receive its new
+ * 				  negotiation (nothing on the multi-drop bus).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use
+ *
+ ********************************************************************************************/
+uint32 FRAME_recoverBaudRate(void)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* All the nodes of the bus share the default baud rate */
+	return UART_getBaudRate();
+#else
+	if((UART_getLineErrors() >= FRAME_RESYNC_LINE_ERRORS)
+			&& (UART_getBaudRate() != UART_DEFAULT_BAUD_RATE))
+	{
+		UART_setBaudRate(UART_DEFAULT_BAUD_RATE);
+	}
+	return UART_getBaudRate();
+#endif
+}
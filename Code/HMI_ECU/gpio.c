@@ -12,7 +12,7 @@
 
 #include "gpio.h"
 #include "common_macros.h" /* To use the macros like SET_BIT */
-#include "avr/io.h" /* To use the IO Ports Registers */
+#include "port.h" /* To use the IO Ports Registers */
 
 /*
  * Description :
@@ -329,3 +329,47 @@ uint8 GPIO_readPort(uint8 port_num)
 
 	return value;
 }
+
+/*
+ * Description :
+ * Write the value on the pins of the mask in one store, the other pins of the port keep
+ * their value. The interrupts are disabled during the read-modify-write.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writePortMasked(uint8 port_num, uint8 mask, uint8 value)
+{
+	/*
+	 * Check if the input number is greater than NUM_OF_PORTS value.
+	 * In this case the input is not valid port number
+	 */
+	if(port_num >= NUM_OF_PORTS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		GPIO_WRITE_PORT_MASKED(port_num,mask,value);
+	}
+}
+
+/*
+ * Description :
+ * Setup the direction of the pins of the mask in one store (PORT_INPUT: input pins,
+ * PORT_OUTPUT: output pins), the other pins of the port keep their direction.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setupPortDirectionMasked(uint8 port_num, uint8 mask, uint8 direction)
+{
+	/*
+	 * Check if the input number is greater than NUM_OF_PORTS value.
+	 * In this case the input is not valid port number
+	 */
+	if(port_num >= NUM_OF_PORTS)
+	{
+		/* Do Nothing */
+	}
+	else
+	{
+		GPIO_SETUP_PORT_DIRECTION_MASKED(port_num,mask,direction);
+	}
+}
@@ -14,312 +14,543 @@
 
 /*-----------------------------------INCLUDES---------------------------------*/
 #include "lcd.h"
+#include "screen.h"
 #include "keypad.h"
 #include "uart.h"
 #include "timer.h"
+#include "frame.h"
+#include "scheduler.h"
 #include "hmi_ecu.h"
 #include <avr/io.h>
-#include <util/delay.h>
+#include <avr/pgmspace.h>
 
 
 int main(void)
 {
-	uint8 receivedByte, key;
+	/* Tasks of the scheduler, in the order of their IDs (priority) */
+	static const SCHEDULER_TaskType tasks[HMI_NUM_OF_TASKS] = {HMI_timersTask, HMI_uiTask};
 
 	SREG |= (1<<7); /* Enable I-Bit for Interrupts*/
 
 	LCD_init();		/* Initialize LCD driver */
+	SCREEN_init();	/* The screens are drawn in RAM and only their changes are sent */
+	KEYPAD_init();	/* Initialize Keypad driver, scanned by the timer ISR */
+
+	/* Create configuration structure for Timer driver (before UART, it is the time base of
+	 * the UART timeouts) */
+	Timer_ConfigType TIMER_Config = {TIMER1, COMPARE,0,TIMER_TICK_COMPARE_VALUE,CLK_64};
+	Timer_init(&TIMER_Config);		/* Initialize Timer driver */
+	Timer_subscribe(TIMER1, UART_tick);	/* The UART time of the receive timeouts */
+	Timer_subscribe(TIMER1, Timer_CallBackFunction);
 
 	/* Create configuration structure for UART driver */
-	UART_ConfigType UART_Config = {EIGHT_BIT,DISABLED,ONT_BIT,9600};
+	UART_ConfigType UART_Config = {EIGHT_BIT,DISABLED,ONT_BIT,UART_DEFAULT_BAUD_RATE};
 	UART_init(&UART_Config);		/* Initialize UART driver */
+	FRAME_negotiateBaudRate();		/* Agree with the Control ECU on the fastest baud rate */
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* Answer the polls of the Control ECU from the RX ISR */
+	UART_setAddress(HMI_PANEL_ADDRESS);
+	UART_receiveFrameInto(g_busFrame, REPLY_LENGTH, HMI_busFrameCallBack);
+#endif
+
+	/* The screens are the states of the user interface task, driven by the keys and by the
+	 * software timers (messages, door state queries, alarm lockout) without busy waits. The
+	 * CPU sleeps between the ticks (no tickless idle: the keypad is scanned every tick) */
+	SCHEDULER_init(tasks, HMI_NUM_OF_TASKS, NULL_PTR);
+
+	/* Display welcome screen when starting the system, then take the password and
+	 * confirmation password from the user */
+	HMI_showMessage(HMI_STRING_WELCOME, HMI_NUM_OF_STRINGS, HMI_STATE_NEW_PASSWORD);
+
+	SCHEDULER_run();
+}
 
-	/* Create configuration structure for Timer driver */
-	Timer_ConfigType TIMER_Config = {TIMER1, COMPARE,0,7812,CLK_1024};
-	Timer_init(&TIMER_Config);		/* Initialize Timer driver */
-	Timer_setCallBack(Timer_CallBackFunction,TIMER1);
 
-	HMI_displayWelcomeScreen();		/* Display welcome screen when starting the system */
+/********************************************************************************************
+ * 									Function Definitions									*
+ ********************************************************************************************/
 
-	HMI_takeFirstPassword();		/* Take the password and confirmation password from the
-	 	 	 	 	 	 	 	 	   the user */
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_getString
+ *
+ * [Description]:This function is responsible for returning the flash address of the message
+ * 				 of the LCD (for the _P display functions).
+ *
+ * [Arguments]: HMI_StringIdType a_stringId
+ *
+ * [in]: a_stringId: Enum to the message
+ *
+ * [out]: Pointer to the string in flash
+ *
+ * [Returns]: PGM_P
+ *
+ ********************************************************************************************/
+PGM_P HMI_getString(HMI_StringIdType a_stringId)
+{
+	/* The table itself is in flash, its entries are read with the LPM instruction */
+	return (PGM_P)pgm_read_ptr(&g_hmiStrings[a_stringId]);
+}
 
-	HMI_mainOptions();				/* Display the main options after taking the password */
 
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_timersTask
+ *
+ * [Description]:This function is the task of the software timers, it is made ready by the
+ * 				 timer tick when timers expired and calls their call backs.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_timersTask(void)
+{
+	Timer_dispatchSoftTimers();
+}
 
-	while(1)
-	{
-		key = KEYPAD_getPressedKey();		/* Get the pressed button from keypad */
-		_delay_ms(4000); /* Delay for switch debouncing */
-		switch(key)
-		{
-		/* Case the user wants to open the door */
-		case DOOR_OPEN_OPTION:
-			/*
-			 * 1.Clear the LCD
-			 * 2.Display the required Message
-			 * 3.Move the cursor to the location where we type the password
-			 */
-			LCD_clearScreen();
-			LCD_displayStringRowColumn(0, 0, "Enter Password:");
-			LCD_displayStringRowColumn(1, 0, "= : To submit");
-			LCD_moveCursor(3,12);
-
-			HMI_getPassword(g_userPassword); /* Get the password from the user */
-
-
-			UART_sendByte(READY_TO_SEND);	/* Inform Control ECU to start sending */
-			while(UART_recieveByte() != READY_TO_RECEIVE);
-			HMI_sendPasswordByUART(g_userPassword);
-
-			UART_sendByte(DOOR_OPEN_OPTION);
-
-			while(UART_recieveByte() != READY_TO_RECEIVE); /* Wait until the Control ECU checking the received password
-			 	 	 	 	 	 	 	 	 	 	 	 	  and receive a byte that determine the password correct or not */
-			receivedByte = UART_recieveByte(); /* - Receive open door in case Control ECU check the password and its identical
-			 	 	 	 	 	 	 	 	 	  - In case the checked password wrong the HMI receive that password is wrong */
-			if(receivedByte == OPEN_DOOR)
-			{
-				HMI_openingDoor();
-			}
-			else if(receivedByte == WRONG_PASSWORD)
-			{
-				++g_trialNumber; /* Increment the number of failed trails from the user */
-				LCD_clearScreen();
-				LCD_displayString("Wrong Password");
-				_delay_ms(3000);
-				if(g_trialNumber == MAX_ALLOWED_TRIALS)
-				{
-					/* Display message on LCD when the user enter wrong password three times */
-					HMI_countBuzzerRunTime();
-					g_trialNumber = 0; /* Reset the counting of wrong trials */
-				}
-			}
-			receivedByte = 0;
-			HMI_mainOptions();
-			break;
 
-		/* Case the user wants to change his password */
-		case CHANGE_PASSWORD_OPTION:
-			/*
-			 * 1.Clear the LCD
-			 * 2.Display the required Message
-			 * 3.Move the cursor to the location where we type the password
-			 */
-			LCD_clearScreen();
-			LCD_displayStringRowColumn(0, 0, "Enter old Password:");
-			LCD_displayStringRowColumn(1, 0, "= : To submit");
-			LCD_moveCursor(3,12);
 
-			HMI_getPassword(g_userPassword); /* Get the old password from the user */
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_uiTask
+ *
+ * [Description]:This function is the task of the user interface (state machine of the
+ * 				 screens), it is made ready by the new key events, by the timeout of the
+ * 				 current state, by the reply frames, when a state is entered and at the end of a
+ * 				 baud rate negotiation. The keys are taken only in the states that wait for the
+ * 				 user, in the other states (message, door, alarm lockout, reply) and during a
+ * 				 negotiation they are kept for later (type-ahead).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_uiTask(void)
+{
+	uint8 key;
 
+	if(g_hmiState == HMI_STATE_REPLY)
+	{
+		HMI_checkReply();	/* A reply in time is taken before its timeout */
+	}
 
-			UART_sendByte(READY_TO_SEND);	/* Inform Control ECU to start sending */
-			while(UART_recieveByte() != READY_TO_RECEIVE); /* Inform HMI that Control ready to receive */
-			HMI_sendPasswordByUART(g_userPassword);	/* Send the old password to Control ECU to check it */
+	if(g_stateTimeout == TRUE)
+	{
+		g_stateTimeout = FALSE;
+		HMI_stateTimeout();
+	}
 
-			UART_sendByte(CHANGE_PASSWORD_OPTION); /* Send the option that the user wants to do (Change password option)*/
+	/* No command is sent during a baud rate negotiation */
+	while(HMI_IS_KEY_STATE(g_hmiState) && (Timer_isSoftTimerActive(&g_linkTimer) == FALSE)
+			&& (HMI_pollKey(&key) == TRUE))
+	{
+		HMI_handleKey(key);
+	}
+}
 
-			while(UART_recieveByte() != READY_TO_RECEIVE); /* Wait until the Control ECU inform HMI ECU that the entered
-			 	 	 	 	 	 	 	 	 	 	 	 	  password correct or not
-			 	 	 	 	 	 	 	 	 	 	 	 	  if the entered password correct: HMI receives Change password byte
-			 	 	 	 	 	 	 	 	 	 	 	 	  else the HMI receive that password wrong */
 
-			receivedByte = UART_recieveByte();
 
-			if(receivedByte == CHANGING_PASSWORD)
-			{
-				HMI_takeFirstPassword();
-			}
-			else if( receivedByte == WRONG_PASSWORD )
-			{
-				LCD_clearScreen();
-				LCD_displayStringRowColumn(0,0,"Wrong Password");
-				LCD_displayStringRowColumn(1,0,"Try again!!");
-				_delay_ms(3000);		/*Delay to display the message for 3 seconds */
-			}
-			receivedByte = 0;
-			HMI_mainOptions();
-			break;
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_enterState
+ *
+ * [Description]:This function is responsible for entering a state of the user interface
+ * 				 (except the message state, see HMI_showMessage): its screen is displayed
+ * 				 and its timer is started, the timer of the last state is cancelled.
+ *
+ * [Arguments]: uint8 a_state
+ *
+ * [in]: a_state: The new state (HMI_STATE_...)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_enterState(uint8 a_state)
+{
+	Timer_cancelSoftTimer(&g_stateTimer);	/* A waiting timeout of the last state is dropped too */
+	g_stateTimeout = FALSE;
+	g_hmiState = a_state;
+	g_passwordIndex = 0;
+
+	SCREEN_clear();
+	switch(a_state)
+	{
+	case HMI_STATE_MAIN_OPTIONS:
+		/*
+		 * Display main options of the system
+		 *    -> "+: Open door"
+		 *    -> "-: Change password"
+		 */
+		SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_OPEN_DOOR));
+		SCREEN_displayStringRowColumn_P(1, 0, HMI_getString(HMI_STRING_CHANGE_PASSWORD));
+		break;
+
+	case HMI_STATE_DOOR:
+		/* The door starts opening with the open door reply, its state is queried from the
+		 * Control ECU (which moves the door in background) until the door is closed, the next
+		 * query is started by the reply of the last one */
+		g_doorState = DOOR_OPENING;
+		SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_DOOR_OPENING));
+		Timer_startSoftTimer(&g_stateTimer, DOOR_STATUS_PERIOD_TICKS, 0, HMI_stateTimerCallBack);
+		break;
+
+	case HMI_STATE_LOCKOUT:
+		/* Warning message during the buzzer alarm of the Control ECU */
+		SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_SYSTEM_CLOSED));
+		SCREEN_displayStringRowColumn_P(1, 0, HMI_getString(HMI_STRING_CATCH_THIEF));
+		Timer_startSoftTimer(&g_stateTimer, BUZZER_ACTIVE_PERIOD * TICKS_PER_SECOND, 0,
+				HMI_stateTimerCallBack);
+		break;
+
+	default:
+		/*
+		 * Password entry:
+		 * 1. Display the required Message
+		 * 2. Display Message "= : To submit"
+		 * 3. Move the cursor to the location where the user can type the password
+		 */
+		if(a_state == HMI_STATE_NEW_PASSWORD)
+		{
+			SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_ENTER_NEW_PASSWORD));
+		}
+		else if(a_state == HMI_STATE_CONFIRM_PASSWORD)
+		{
+			SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_REENTER_PASSWORD));
+		}
+		else if(a_state == HMI_STATE_OLD_PASSWORD)
+		{
+			SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_ENTER_OLD_PASSWORD));
+		}
+		else
+		{
+			SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_ENTER_PASSWORD));
 		}
+		SCREEN_displayStringRowColumn_P(1, 0, HMI_getString(HMI_STRING_SUBMIT));
+		SCREEN_moveCursor(3,12);
+
+		/* The keys not typed (submit with '=') are 0 */
+		HMI_clearArray((a_state == HMI_STATE_CONFIRM_PASSWORD) ? g_confirmationPassword : g_userPassword);
+		break;
 	}
+	SCREEN_flush();
+
+	SCHEDULER_setReady(HMI_TASK_UI);	/* Keys typed ahead may wait for the new state */
 }
 
 
-/********************************************************************************************
- * 									Function Definitions									*
- ********************************************************************************************/
 
 /********************************************************************************************
  *
- * [Function Name]: HMI_displayWelcomeScreen
+ * [Function Name]: HMI_showMessage
  *
- * [Description]:This function is responsible for displaying the welcome message on LCD for the
- * 				 person who use this system for the first time.
+ * [Description]:This function is responsible for displaying a message on the LCD for
+ * 				 MESSAGE_PERIOD_MS (message state), then the next state is entered.
  *
- * [Arguments]: None
+ * [Arguments]: HMI_StringIdType a_firstLine, HMI_StringIdType a_secondLine, uint8 a_nextState
  *
- * [in]: void
+ * [in]: - a_firstLine: The message of the first row
+ * 		 - a_secondLine: The message of the second row (HMI_NUM_OF_STRINGS: none)
+ * 		 - a_nextState: The state entered at the end of the message
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_displayWelcomeScreen(void)
+void HMI_showMessage(HMI_StringIdType a_firstLine, HMI_StringIdType a_secondLine, uint8 a_nextState)
 {
-	/*
-	 * 1. Clear the LCD
-	 * 2. Display Message "Welcome to Security Door Lock System"
-	 */
-	LCD_clearScreen();
-	LCD_displayString("Welcome to Security Door Lock System");
-	_delay_ms(3000);	/* Delay to display the message for 3 seconds */
+	/* The timer of the last state is restarted for the message */
+	Timer_startSoftTimer(&g_stateTimer, MESSAGE_PERIOD_TICKS, 0, HMI_stateTimerCallBack);
+	g_stateTimeout = FALSE;
+	g_hmiState = HMI_STATE_MESSAGE;
+	g_nextState = a_nextState;
+
+	SCREEN_clear();
+	SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(a_firstLine));
+	if(a_secondLine != HMI_NUM_OF_STRINGS)
+	{
+		SCREEN_displayStringRowColumn_P(1, 0, HMI_getString(a_secondLine));
+	}
+	SCREEN_flush();
 }
 
 
+
 /********************************************************************************************
  *
- * [Function Name]: HMI_takeFirstPassword
+ * [Function Name]: HMI_handleKey
  *
- * [Description]:This function is responsible for taking the password form the user and
- * 				 store it in global array (g_userPassword) in order to send the password
- * 				 to the other micro-controller.
+ * [Description]:This function is responsible for taking one key in the main options (the
+ * 				 selected option) or in a password entry: a digit is stored and displayed as
+ * 				 '*', '=' submits the password, the password is submitted after
+ * 				 PASSWORD_LENGTH keys too.
  *
- * [Arguments]: None
+ * [Arguments]: uint8 a_key
  *
- * [in]: void
+ * [in]: a_key: The pressed key
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_takeFirstPassword(void)
+void HMI_handleKey(uint8 a_key)
 {
-	while(g_passwordStatus == PASSWORD_UNMATCHED)
+	uint8 *password_Ptr;
+
+	if(g_hmiState == HMI_STATE_MAIN_OPTIONS)
 	{
-		/*------------------ Get First Password from the user ----------------------------*/
-		/*
-		 * 1. Clear the LCD
-		 * 2. Display Message "Enter New Password:"
-		 * 3. Display Message "= : To submit"
-		 * 4. Move the cursor to the location where the user can type the password
-		 */
-		LCD_clearScreen();
-		LCD_displayStringRowColumn(0, 0, "Enter New Password:");
-		LCD_displayStringRowColumn(1, 0, "= : To submit");
-		LCD_moveCursor(3,12);
+		switch(a_key)
+		{
+		/* Case the user wants to open the door */
+		case DOOR_OPEN_OPTION:
+			HMI_enterState(HMI_STATE_OPEN_DOOR_PASSWORD);
+			break;
 
-		/* Function to get the First password entered and store it in Array */
-		HMI_getPassword(g_userPassword);
+		/* Case the user wants to change his password */
+		case CHANGE_PASSWORD_OPTION:
+			HMI_enterState(HMI_STATE_OLD_PASSWORD);
+			break;
 
-		UART_sendByte(READY_TO_SEND);	/* Inform Control ECU to be ready to receive the first password */
-		while (UART_recieveByte() != READY_TO_RECEIVE);	/* Wait until the Control ECU responds that it is ready to receive
-														   first password */
+#if (UART_MULTIDROP_ENABLE == FALSE)
+		/* Case the service technician wants the UART link traces (a panel doesn't talk on the
+		 * bus without a poll): the Control ECU sends its trace first, the trace of this ECU
+		 * follows its reply (HMI_replyReceived). Each trace is captured on the TX line of its
+		 * ECU, the other ECU drops the trace frames. */
+		case TRACE_DUMP_KEY:
+			UART_tracePause();	/* Keep the trace of this ECU out of the Control ECU dump */
+			HMI_sendCommand(TRACE_DUMP_OPTION, g_userPassword, NULL_PTR);
+			HMI_awaitReply();
+			break;
+#endif
+		}
+		return;
+	}
 
-		/* Call function that responsible for sending password to the Control ECU */
-		HMI_sendPasswordByUART(g_userPassword); /* Send First Password to Control ECU */
-		_delay_ms(1000);
+	password_Ptr = (g_hmiState == HMI_STATE_CONFIRM_PASSWORD) ? g_confirmationPassword : g_userPassword;
 
-		/*-------------- Get Second (confirmation) Password from the user ------------------*/
-		/*
-		 * 1. Clear the LCD
-		 * 2. Display Message "Re-enter Password:"
-		 * 3. Display Message "= : To submit"
-		 * 3. Move the cursor to the location where the user can type the password
-		 */
-		LCD_clearScreen();
-		LCD_displayStringRowColumn(0, 0, "Re-enter Password:");
-		LCD_displayStringRowColumn(1, 0, "= : To submit");
-		LCD_moveCursor(3,12);
+	if(a_key <= 9)
+	{
+		SCREEN_displayCharacter('*');		/* Display '*' instead of the pressed key for security */
+		SCREEN_flush();
+		password_Ptr[g_passwordIndex] = a_key; 		/* Store the pressed button in the array */
+	}
+
+	if(a_key != '=')
+	{
+		g_passwordIndex++;
+	}
+	if((a_key == '=') || (g_passwordIndex == PASSWORD_LENGTH))
+	{
+		HMI_passwordEntered();
+	}
+}
 
-		/* Function to get the Second password (confirmation password) entered and store it in Array */
-		HMI_getPassword(g_userPassword);
 
-		UART_sendByte(READY_TO_SEND);	/* Inform Control ECU to be ready to receive the second password */
-		while(UART_recieveByte() != READY_TO_RECEIVE);	/* Wait until the Control ECU responds that it is ready to receive
-														   second password */
 
-		/* Call function that responsible for sending password to the Control ECU */
-		HMI_sendPasswordByUART(g_userPassword);	/* Send Second Password to Control ECU */
-		_delay_ms(1000);
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_passwordEntered
+ *
+ * [Description]:This function is responsible for the submitted password of the current
+ * 				 state: the command is sent to the Control ECU in one frame and its reply is
+ * 				 waited in the reply state (see HMI_replyReceived).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_passwordEntered(void)
+{
+	switch(g_hmiState)
+	{
+	case HMI_STATE_NEW_PASSWORD:
+		HMI_enterState(HMI_STATE_CONFIRM_PASSWORD);	/* Get the confirmation password */
+		break;
+
+	case HMI_STATE_CONFIRM_PASSWORD:
+		/* Send the two passwords to the Control ECU in one frame, it replies if they are
+		 * matching or not */
+		HMI_sendCommand(NEW_PASSWORD_OPTION, g_userPassword, g_confirmationPassword);
+		HMI_awaitReply();
+		break;
+
+	case HMI_STATE_OPEN_DOOR_PASSWORD:
+		/* Send the password and the option in one frame to the Control ECU:
+		 * - Receive open door in case Control ECU check the password and its identical
+		 * - In case the checked password wrong the HMI receive that password is wrong */
+		HMI_sendCommand(DOOR_OPEN_OPTION, g_userPassword, NULL_PTR);
+		HMI_awaitReply();
+		break;
+
+	case HMI_STATE_OLD_PASSWORD:
+		/* Send the old password to Control ECU to check it with the option that the user
+		 * wants to do (Change password option) in one frame:
+		 * if the entered password correct: HMI receives Change password byte
+		 * else the HMI receive that password wrong */
+		HMI_sendCommand(CHANGE_PASSWORD_OPTION, g_userPassword, NULL_PTR);
+		HMI_awaitReply();
+		break;
+	}
+}
+
 
-		/*
-		 * Wait until the control ECU make response about the
-		 * password and confirmation password if they are matching
-		 * or not
-		 */
-		while(UART_recieveByte() != READY_TO_SEND); 	/* Wait until Control ECU send the response of checking the password */
-		g_passwordStatus = UART_recieveByte(); /* Get the response from Control ECU that the password matched or not */
 
-		/* After Control ECU check the two passwords, If two passwords are identical display message "Password Saved" */
-		if(g_passwordStatus == PASSWORD_MATCHED)
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_stateTimeout
+ *
+ * [Description]:This function is responsible for the timeout of the current state: the end
+ * 				 of a message or of the alarm lockout, the next door state query, or no reply
+ * 				 in time (the command is sent again). After FRAME_RESYNC_TIMEOUTS reply timeouts
+ * 				 in a row the baud rate is negotiated again.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_stateTimeout(void)
+{
+	switch(g_hmiState)
+	{
+	case HMI_STATE_MESSAGE:
+		HMI_enterState(g_nextState);
+		break;
+
+	case HMI_STATE_LOCKOUT:
+		HMI_discardKeys();	/* The keys typed during the lockout are not used */
+		HMI_enterState(HMI_STATE_MAIN_OPTIONS);
+		break;
+
+	case HMI_STATE_DOOR:
+		HMI_sendCommand(DOOR_STATUS_OPTION, g_userPassword, NULL_PTR);
+		HMI_awaitReply();
+		break;
+
+	case HMI_STATE_REPLY:
+#if (UART_MULTIDROP_ENABLE == TRUE)
+		g_commandPending = FALSE;	/* Not sent to the next polls */
+		HMI_replyReceived(LINK_ERROR);
+#else
+		g_replyTrial++;
+		if(g_replyTimeouts < FRAME_RESYNC_TIMEOUTS)
 		{
-			LCD_clearScreen();
-			LCD_displayStringRowColumn(0,0,"Password Saved");
-			_delay_ms(3000);		/*Delay to display the message for 3 seconds */
-			g_passwordStatus = PASSWORD_UNMATCHED;	/* Return the variable to its initial state in order to
-													   be able use this function again */
-			break;
+			g_replyTimeouts++;
+		}
+		if(g_replyTrial < MAX_COMMAND_TRIALS)
+		{
+			/* No reply in time, send the same command (same sequence) again */
+			FRAME_send(FRAME_TYPE_COMMAND, g_commandPayload, g_commandLength);
+			Timer_startSoftTimer(&g_stateTimer, REPLY_TIMEOUT_TICKS, 0, HMI_stateTimerCallBack);
 		}
-		/* If two passwords are not identical display message "Password Unmatched" and "Try again!!" */
-		else if(g_passwordStatus == PASSWORD_UNMATCHED)
+		else
 		{
-			LCD_clearScreen();
-			LCD_displayStringRowColumn(0,0,"Password Unmatched");
-			LCD_displayStringRowColumn(1,0,"Try again!!");
-			HMI_clearArray(g_userPassword); /* Clear the received password from the user to be able to
-			 	 	 	 	 	 	 	 	   receive new one
-			 	 	 	 	 	 	 	 	 */
-			_delay_ms(3000);		/*Delay to display the message for 3 seconds */
+			UART_cancelFrameReceive();
+			if(g_replyTimeouts == FRAME_RESYNC_TIMEOUTS)
+			{
+				/* The Control ECU may be reset alone (default baud rate), negotiate again from
+				 * the timers task while the message is displayed */
+				g_replyTimeouts = 0;
+				FRAME_startNegotiation();
+				Timer_startSoftTimer(&g_linkTimer, 1, 1, HMI_linkTimerCallBack);
+			}
+			HMI_replyReceived(LINK_ERROR);
 		}
+#endif
+		break;
 	}
 }
 
+
+
 /********************************************************************************************
  *
- * [Function Name]: HMI_getPassword
+ * [Function Name]: HMI_stateTimerCallBack
  *
- * [Description]:This function is responsible for displaying the main options in LCD.
+ * [Description]:This function is the call back of the software timer of the current state,
+ * 				 the timeout is served by the task of the user interface.
  *
- * [Arguments]:
+ * [Arguments]: None
  *
- * [in]: *a_password_Ptr: pointer to unsigned character
+ * [in]: void
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_getPassword(uint8 *a_password_Ptr)
+void HMI_stateTimerCallBack(void)
 {
-	uint8 i = 0; 	/* variable used as counter for for-Loop */
-	uint8 key;		/* variable used to get the pressed button */
+	g_stateTimeout = TRUE;
+	SCHEDULER_setReady(HMI_TASK_UI);
+}
 
-	for(i=0;i<PASSWORD_LENGTH;i++)
-	{
-		key = KEYPAD_getPressedKey();	/* Get the pressed button from keypad */
 
-		_delay_ms(4000); /* Delay for switch debouncing */
 
-		if((key >= 0) && (key <= 9))
-		{
-			LCD_displayCharacter ('*');		/* Display '*' instead of the pressed key for security */
-			a_password_Ptr[i] = key; 		/* Store the pressed button in the array */
-		}
-		else if (key == '=')
+/********************************************************************************************
+ *
+ * [Function Name]: HMI_pollKey
+ *
+ * [Description]:This function is responsible for taking the next pressed key from the keypad
+ * 				 events in order (type-ahead) without waiting, the keys older than
+ * 				 TYPE_AHEAD_MAX_AGE_MS are dropped.
+ *
+ * [Arguments]: uint8 *a_key_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: *a_key_Ptr: The pressed key
+ *
+ * [Returns]: TRUE if a key is pressed, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 HMI_pollKey(uint8 *a_key_Ptr)
+{
+	KEYPAD_KeyEventType keyEvent;
+
+	/* The events are queued by the timer ISR, also while the HMI is busy */
+	while(KEYPAD_getEvent(&keyEvent) == TRUE)
+	{
+		if((keyEvent.event == KEYPAD_KEY_PRESSED)
+				&& ((uint16)(KEYPAD_getTime() - keyEvent.time) <= TYPE_AHEAD_MAX_AGE_TICKS))
 		{
-			break; /* Exit from for-loop in case the user finishes entering the password */
+			*a_key_Ptr = keyEvent.key;
+			return TRUE;
 		}
 	}
+	return FALSE;
 }
 
+
+
 /********************************************************************************************
  *
- * [Function Name]: HMI_mainOptions
+ * [Function Name]: HMI_discardKeys
  *
- * [Description]:This function is responsible for displaying the main options on LCD.
+ * [Description]:This function is responsible for dropping all the keys typed until now.
  *
  * [Arguments]: None
  *
@@ -330,55 +561,84 @@ void HMI_getPassword(uint8 *a_password_Ptr)
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_mainOptions(void)
+void HMI_discardKeys(void)
 {
-	/*
-	 * 1. Clear the LCD
-	 * 2. Display main options of the system
-	 *    -> "+: Open door"
-	 *    -> "-: Change password"
-	 */
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0, 0, "+: Open door");
-	LCD_displayStringRowColumn(1, 0, "-: Change password");
-}
-
+	KEYPAD_KeyEventType keyEvent;
 
+	while(KEYPAD_getEvent(&keyEvent) == TRUE)
+	{
+		/* Drop the event */
+	}
+}
 
 /********************************************************************************************
- * [Function Name]: HMI_sendPasswordByUART
+ * [Function Name]: HMI_sendCommand
  *
- * [Description]:This function is responsible for sending password to other micro-controller
- * 				 through UART serial communication.
+ * [Description]:This function is responsible for sending the selected option and the password
+ * 				 (and the confirmation password) to other micro-controller in one frame, with
+ * 				 a new sequence number. The frame is kept to be sent again in the reply state.
+ * 				 On the multi-drop bus the frame is sent as the answer of the next poll.
  *
- * [Arguments]:
+ * [Arguments]: uint8 a_option, uint8 *a_password_Ptr, uint8 *a_confirmation_Ptr
  *
- * [in]: *password_Ptr: pointer to unsigned character
+ * [in]: - a_option: The selected option
+ * 		 - *a_password_Ptr: pointer to unsigned character
+ * 		 - *a_confirmation_Ptr: pointer to unsigned character (NULL_PTR if not needed)
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_sendPasswordByUART(uint8 *password_Ptr)
+void HMI_sendCommand(uint8 a_option, uint8 *a_password_Ptr, uint8 *a_confirmation_Ptr)
 {
 	uint8 counter; /* Variable to be used as a counter for for-Loop */
 
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	g_commandPending = FALSE;	/* The RX ISR must not send the payload while it is changed */
+#endif
+
+	g_sequence++;	/* New command */
+
+	g_commandPayload[COMMAND_SEQUENCE_INDEX] = g_sequence;
+	g_commandPayload[COMMAND_OPTION_INDEX] = a_option;
 	for(counter = 0; counter<PASSWORD_LENGTH; counter++)
 	{
-		while(UART_recieveByte() != READY_TO_RECEIVE);	/* Wait until Control ECU be ready to receive data */
+		g_commandPayload[COMMAND_PASSWORD_INDEX + counter] = a_password_Ptr[counter];
+		if(a_confirmation_Ptr != NULL_PTR)
+		{
+			g_commandPayload[COMMAND_CONFIRMATION_INDEX + counter] = a_confirmation_Ptr[counter];
+		}
+	}
 
-		UART_sendByte(password_Ptr[counter]);	/* Send 1 byte from the password to Control ECU */
+	if(a_confirmation_Ptr != NULL_PTR)
+	{
+		g_commandLength = COMMAND_MAX_LENGTH;
+	}
+	else
+	{
+		g_commandLength = COMMAND_CONFIRMATION_INDEX;
 	}
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	g_commandPending = TRUE;	/* Sent by the RX ISR as the answer of the next poll */
+#else
+	FRAME_send(FRAME_TYPE_COMMAND, g_commandPayload, g_commandLength);
+#endif
 }
 
 
 
 /********************************************************************************************
+ * [Function Name]: HMI_awaitReply
  *
- * [Function Name]: HMI_openingDoor
- *
- * [Description]:This function is responsible for displaying the Door state on LCD.
+ * [Description]:This function is responsible for waiting the reply of the command sent by the
+ * 				 current state without blocking: the reply state is entered (the screen is
+ * 				 kept) and its timer is started, the reply is given to HMI_replyReceived.
+ * 				 The command is sent again if no reply is received in REPLY_TIMEOUT_MS (the
+ * 				 command or the reply is lost), MAX_COMMAND_TRIALS times. On the multi-drop bus
+ * 				 the reply is received by the RX ISR in BUS_REPLY_TIMEOUT_MS (see
+ * 				 HMI_busFrameCallBack).
  *
  * [Arguments]: None
  *
@@ -389,38 +649,32 @@ void HMI_sendPasswordByUART(uint8 *password_Ptr)
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_openingDoor(void)
+void HMI_awaitReply(void)
 {
-	/* Display message on screen while rotating the motor clockwise for 15 seconds */
-	g_seconds = 0;
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0, 0, "Opening The Door...");
-	while(g_seconds != DOOR_UNLOCKED_PERIOD);
-
-	/* Display message on screen while holding the motor for 3 seconds */
-	g_seconds = 0;
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0, 0, "Holding The Door");
-	while(g_seconds != DOOR_LEFT_OPEN_PERIOD);
-
-	/* Display message on screen while rotating the motor anti-clockwise for 15 seconds */
-	g_seconds = 0;
-
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0, 0, "Closing The Door...");
-	while(g_seconds != DOOR_UNLOCKED_PERIOD);
-
-	_delay_ms(1000);
+	g_replyState = g_hmiState;
+	g_hmiState = HMI_STATE_REPLY;
+	g_replyTrial = 0;
+	g_stateTimeout = FALSE;
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* Every poll before the reply sends the command again (same sequence), the Control ECU
+	 * answers a retransmission from its last reply */
+	Timer_startSoftTimer(&g_stateTimer, BUS_REPLY_TIMEOUT_TICKS, 0, HMI_stateTimerCallBack);
+#else
+	/* The reply is received directly from the RX ISR */
+	UART_receiveFrameInto(g_replyFrame, REPLY_LENGTH, HMI_replyFrameCallBack);
+	Timer_startSoftTimer(&g_stateTimer, REPLY_TIMEOUT_TICKS, 0, HMI_stateTimerCallBack);
+#endif
 }
 
 
 
 /********************************************************************************************
+ * [Function Name]: HMI_checkReply
  *
- * [Function Name]: HMI_countBuzzerRunTime
- *
- * [Description]:This function is responsible for displaying a warning message on the LCD
- * 				 when a thief tries to type wrong password for many times.
+ * [Description]:This function is responsible for taking the reply frame in the reply state,
+ * 				 corrupted frames are dropped by the RX ISR and the replies of older commands
+ * 				 are dropped here.
  *
  * [Arguments]: None
  *
@@ -431,14 +685,170 @@ void HMI_openingDoor(void)
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_countBuzzerRunTime(void)
+void HMI_checkReply(void)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	if(g_commandPending == FALSE)
+	{
+		HMI_replyReceived(g_reply);
+	}
+#else
+	uint8 type;
+	uint8 length;
+
+	if(UART_isFrameReceived(&type, &length) == TRUE)
+	{
+		if((type == FRAME_TYPE_REPLY) && (length == REPLY_LENGTH)
+				&& (g_replyFrame[REPLY_SEQUENCE_INDEX] == g_commandPayload[COMMAND_SEQUENCE_INDEX]))
+		{
+			g_replyTimeouts = 0;
+			HMI_replyReceived(g_replyFrame[REPLY_RESULT_INDEX]);
+		}
+		else
+		{
+			/* Reply of an older command, wait the next frame */
+			UART_receiveFrameInto(g_replyFrame, REPLY_LENGTH, HMI_replyFrameCallBack);
+		}
+	}
+#endif
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_replyReceived
+ *
+ * [Description]:This function is responsible for selecting the next state from the reply of
+ * 				 the command sent by g_replyState. After a reset of the Control ECU alone (no
+ * 				 password) the password is taken again.
+ *
+ * [Arguments]: uint8 a_reply
+ *
+ * [in]: a_reply: The reply (OPEN_DOOR, WRONG_PASSWORD, PASSWORD_MATCHED, ...) or LINK_ERROR
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_replyReceived(uint8 a_reply)
 {
-	/* Display message on screen while rotating the motor clockwise for 15 seconds */
-	g_seconds = 0;
-	LCD_clearScreen();
-	LCD_displayStringRowColumn(0,0,"System Closed");
-	LCD_displayStringRowColumn(1,0,"Catch The Thief!!");
-	while(g_seconds != BUZZER_ACTIVE_PERIOD);
+	if(a_reply == NO_PASSWORD)
+	{
+		HMI_enterState(HMI_STATE_NEW_PASSWORD);
+		return;
+	}
+
+	switch(g_replyState)
+	{
+	case HMI_STATE_MAIN_OPTIONS:
+		/* End of the trace dump of the Control ECU (or no reply), the trace of this ECU follows */
+		UART_traceDump();
+		HMI_enterState(HMI_STATE_MAIN_OPTIONS);
+		break;
+
+	case HMI_STATE_CONFIRM_PASSWORD:
+		if(a_reply == PASSWORD_MATCHED)
+		{
+			HMI_showMessage(HMI_STRING_PASSWORD_SAVED, HMI_NUM_OF_STRINGS, HMI_STATE_MAIN_OPTIONS);
+		}
+		else if(a_reply == PASSWORD_UNMATCHED)
+		{
+			HMI_showMessage(HMI_STRING_PASSWORD_UNMATCHED, HMI_STRING_TRY_AGAIN, HMI_STATE_NEW_PASSWORD);
+		}
+		else if(a_reply == WRONG_PASSWORD)
+		{
+			/* This ECU is reset alone, the Control ECU keeps its saved password */
+			HMI_showMessage(HMI_STRING_WRONG_PASSWORD, HMI_NUM_OF_STRINGS, HMI_STATE_MAIN_OPTIONS);
+		}
+		else
+		{
+			/* No reply from Control ECU, take the passwords again */
+			HMI_showMessage(HMI_STRING_NO_RESPONSE, HMI_STRING_TRY_AGAIN, HMI_STATE_NEW_PASSWORD);
+		}
+		break;
+
+	case HMI_STATE_OPEN_DOOR_PASSWORD:
+		if(a_reply == OPEN_DOOR)
+		{
+			HMI_enterState(HMI_STATE_DOOR);
+		}
+		else if(a_reply == THIEF_IS_DETECTED)
+		{
+			HMI_enterState(HMI_STATE_LOCKOUT); /* The system is closed until the alarm ends */
+		}
+		else if(a_reply == WRONG_PASSWORD)
+		{
+			++g_trialNumber; /* Increment the number of failed trails from the user */
+			if(g_trialNumber == MAX_ALLOWED_TRIALS)
+			{
+				/* The lockout follows the message when the user enter wrong password three times */
+				g_trialNumber = 0; /* Reset the counting of wrong trials */
+				HMI_showMessage(HMI_STRING_WRONG_PASSWORD, HMI_NUM_OF_STRINGS, HMI_STATE_LOCKOUT);
+			}
+			else
+			{
+				HMI_showMessage(HMI_STRING_WRONG_PASSWORD, HMI_NUM_OF_STRINGS, HMI_STATE_MAIN_OPTIONS);
+			}
+		}
+		else
+		{
+			HMI_showMessage(HMI_STRING_NO_RESPONSE, HMI_STRING_TRY_AGAIN, HMI_STATE_MAIN_OPTIONS);
+		}
+		break;
+
+	case HMI_STATE_OLD_PASSWORD:
+		if(a_reply == CHANGING_PASSWORD)
+		{
+			HMI_enterState(HMI_STATE_NEW_PASSWORD);
+		}
+		else if(a_reply == THIEF_IS_DETECTED)
+		{
+			HMI_enterState(HMI_STATE_LOCKOUT); /* The system is closed until the alarm ends */
+		}
+		else if(a_reply == WRONG_PASSWORD)
+		{
+			HMI_showMessage(HMI_STRING_WRONG_PASSWORD, HMI_STRING_TRY_AGAIN, HMI_STATE_MAIN_OPTIONS);
+		}
+		else
+		{
+			HMI_showMessage(HMI_STRING_NO_RESPONSE, HMI_STRING_TRY_AGAIN, HMI_STATE_MAIN_OPTIONS);
+		}
+		break;
+
+	case HMI_STATE_DOOR:
+		if((a_reply == DOOR_CLOSED) || (a_reply == LINK_ERROR))
+		{
+			HMI_enterState(HMI_STATE_MAIN_OPTIONS);
+		}
+		else
+		{
+			/* Display the message of the new door state only */
+			if(a_reply != g_doorState)
+			{
+				SCREEN_clear();
+				if(a_reply == DOOR_OPENING)
+				{
+					SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_DOOR_OPENING));
+				}
+				else if(a_reply == DOOR_HOLDING)
+				{
+					SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_DOOR_HOLDING));
+				}
+				else
+				{
+					SCREEN_displayStringRowColumn_P(0, 0, HMI_getString(HMI_STRING_DOOR_CLOSING));
+				}
+				SCREEN_flush();
+				g_doorState = a_reply;
+			}
+			/* Back to the door state until the next query */
+			g_hmiState = HMI_STATE_DOOR;
+			g_stateTimeout = FALSE;
+			Timer_startSoftTimer(&g_stateTimer, DOOR_STATUS_PERIOD_TICKS, 0, HMI_stateTimerCallBack);
+		}
+		break;
+	}
 }
 
 
@@ -466,7 +876,6 @@ void HMI_clearArray(uint8 *a_Ptr)
 		a_Ptr[counter] = 0;
 		counter++;
 	}
-	a_Ptr[counter] = 0;
 }
 
 
@@ -475,8 +884,9 @@ void HMI_clearArray(uint8 *a_Ptr)
  *
  * [Function Name]: Timer_CallBackFunction
  *
- * [Description]:This function is responsible for incrementing global variable (g_seconds)
- * 				 that indicates the number of counted seconds.
+ * [Description]:This function is responsible for advancing the software timers and for
+ * 				 scanning the keypad every tick, and for making the tasks of the expired timers
+ * 				 and of the new keys ready, it subscribes to the tick after UART_tick.
  *
  * [Arguments]: None
  *
@@ -489,7 +899,112 @@ void HMI_clearArray(uint8 *a_Ptr)
  ********************************************************************************************/
 void Timer_CallBackFunction(void)
 {
-	/* Call back function for the timer (when timer count 1 second)
-	 * the timer increment the global variable g_seconds every second */
-	g_seconds++; /* Increment global second variable each time the interrupt fired */
+	if(KEYPAD_tick() == TRUE)	/* Scan the next column of the keypad */
+	{
+		SCHEDULER_setReady(HMI_TASK_UI);	/* New key event */
+	}
+	if(Timer_tickSoftTimers() == TRUE)
+	{
+		SCHEDULER_setReady(HMI_TASK_TIMERS);	/* Call backs of the expired timers */
+	}
+}
+
+
+
+#if (UART_MULTIDROP_ENABLE == FALSE)
+/********************************************************************************************
+ * [Function Name]: HMI_replyFrameCallBack
+ *
+ * [Description]:This function is called from the RX ISR when a frame is received in the reply
+ * 				 state, the frame is checked by the task of the user interface.
+ *
+ * [Arguments]: uint8 a_type, uint8 a_length
+ *
+ * [in]: - a_type: Type of the received frame
+ * 		 - a_length: Payload length of the received frame
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_replyFrameCallBack(uint8 a_type, uint8 a_length)
+{
+	(void)a_type;
+	(void)a_length;
+	SCHEDULER_setReady(HMI_TASK_UI);
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_linkTimerCallBack
+ *
+ * [Description]:This function is the call back of the periodic software timer of the baud rate
+ * 				 negotiation after a lost link, it runs the next step of the exchange every
+ * 				 tick. At the end the timer is stopped and the task of the user interface takes
+ * 				 the keys typed meanwhile.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_linkTimerCallBack(void)
+{
+	if(FRAME_serviceBaudRate() == FALSE)
+	{
+		Timer_cancelSoftTimer(&g_linkTimer);
+		SCHEDULER_setReady(HMI_TASK_UI);
+	}
+}
+#else
+/********************************************************************************************
+ * [Function Name]: HMI_busFrameCallBack
+ *
+ * [Description]:This function is responsible for answering the polls of the Control ECU on the
+ * 				 multi-drop bus, it is called from the RX ISR for every frame sent to this panel:
+ * 				 - A poll is answered with the pending command, or with an empty poll frame.
+ * 				 - The reply of the pending command (same sequence) completes it, the task
+ * 				   of the user interface is made ready.
+ * 				 The next frame is then received in g_busFrame again.
+ *
+ * [Arguments]: uint8 a_type, uint8 a_length
+ *
+ * [in]: - a_type: Type of the received frame
+ * 		 - a_length: Payload length of the received frame
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_busFrameCallBack(uint8 a_type, uint8 a_length)
+{
+	if(a_type == FRAME_TYPE_POLL)
+	{
+		/* The TX buffer is empty: the last answer is sent before the next poll */
+		if(g_commandPending == TRUE)
+		{
+			FRAME_sendTo(HMI_PANEL_ADDRESS, FRAME_TYPE_COMMAND, g_commandPayload, g_commandLength);
+		}
+		else
+		{
+			FRAME_sendTo(HMI_PANEL_ADDRESS, FRAME_TYPE_POLL, NULL_PTR, 0);
+		}
+	}
+	else if((a_type == FRAME_TYPE_REPLY) && (a_length == REPLY_LENGTH) && (g_commandPending == TRUE)
+			&& (g_busFrame[REPLY_SEQUENCE_INDEX] == g_commandPayload[COMMAND_SEQUENCE_INDEX]))
+	{
+		g_reply = g_busFrame[REPLY_RESULT_INDEX];
+		g_commandPending = FALSE;
+		SCHEDULER_setReady(HMI_TASK_UI);
+	}
+
+	UART_receiveFrameInto(g_busFrame, REPLY_LENGTH, HMI_busFrameCallBack);
 }
+#endif
@@ -36,18 +36,122 @@
 #define PASSWORD_MATCHED			1
 #define PASSWORD_UNMATCHED			0
 
-#define READY_TO_SEND				0x10
-#define READY_TO_RECEIVE			0x20
-
 #define OPEN_DOOR					0x25
 
 #define WRONG_PASSWORD				0x30
 #define CHANGING_PASSWORD			0X31
 #define THIEF_IS_DETECTED			0x32
-
+#define NO_PASSWORD					0x33	/* No password is saved since the Control ECU reset */
+#define LINK_ERROR					0xFF	/* No reply from the Control ECU */
+
+/* Reply waiting time of each command transmission and number of transmissions */
+#define REPLY_TIMEOUT_MS			200
+#define MAX_COMMAND_TRIALS			3
+
+/*
+ * Multi-drop bus (UART_MULTIDROP_ENABLE in uart.h): bus address of this panel (1 to the number
+ * of panels of the Control ECU) and reply waiting time of a command. The command is sent as the
+ * answer of the polls until the reply is received, the Control ECU polls the other panels and
+ * executes their commands (up to the 500 ms of a new password) between two polls of this panel.
+ */
+#define HMI_PANEL_ADDRESS			1
+#define BUS_REPLY_TIMEOUT_MS		2000
 
 #define CHANGE_PASSWORD_OPTION		45 		/* ACII Code for '+' */
 #define DOOR_OPEN_OPTION			43		/* ACII Code for '-' */
+#define NEW_PASSWORD_OPTION			0x40	/* New password and its confirmation */
+#define DOOR_STATUS_OPTION			0x41	/* Reply with the door state */
+#define DOOR_CLOSE_OPTION			0x42	/* Close the door now */
+#define TRACE_DUMP_OPTION			0x43	/* Send the UART link trace, then the reply */
+#define TRACE_DUMP_KEY				'%'		/* Send the UART link traces of both ECUs */
+
+/* Door states (reply of DOOR_STATUS_OPTION) */
+#define DOOR_CLOSED					0x50
+#define DOOR_OPENING				0x51
+#define DOOR_HOLDING				0x52
+#define DOOR_CLOSING				0x53
+
+/* Period of the door state queries while the door is moving */
+#define DOOR_STATUS_PERIOD_MS		250
+
+/* Display time of the messages (wrong password, password saved, ...) */
+#define MESSAGE_PERIOD_MS			3000
+
+/* States of the user interface (HMI_uiTask), the keys are taken in the last ones only */
+#define HMI_STATE_MESSAGE				0	/* Message, then g_nextState */
+#define HMI_STATE_DOOR					1	/* Door state queries until the door is closed */
+#define HMI_STATE_LOCKOUT				2	/* Buzzer alarm of the Control ECU */
+#define HMI_STATE_REPLY					3	/* Reply of the command sent in g_replyState */
+#define HMI_STATE_NEW_PASSWORD			4
+#define HMI_STATE_CONFIRM_PASSWORD		5
+#define HMI_STATE_MAIN_OPTIONS			6
+#define HMI_STATE_OPEN_DOOR_PASSWORD	7
+#define HMI_STATE_OLD_PASSWORD			8
+#define HMI_IS_KEY_STATE(STATE)			((STATE) >= HMI_STATE_NEW_PASSWORD)
+
+/*
+ * Type-ahead: the keys typed while the HMI is busy (LCD, UART, message screens) are used in
+ * order, except the keys older than TYPE_AHEAD_MAX_AGE_MS (typed long before, e.g. at the
+ * beginning of the door cycle) and the keys typed during the alarm lockout.
+ */
+#define TYPE_AHEAD_MAX_AGE_MS		10000
+
+/*
+ * Command frame payload: sequence + option + password (+ confirmation password for new
+ * password). The sequence number is changed for every new command and kept for its
+ * retransmissions, the Control ECU answers a retransmission from its last reply.
+ */
+#define COMMAND_SEQUENCE_INDEX		0
+#define COMMAND_OPTION_INDEX		1
+#define COMMAND_PASSWORD_INDEX		2
+#define COMMAND_CONFIRMATION_INDEX	(COMMAND_PASSWORD_INDEX + PASSWORD_LENGTH)
+#define COMMAND_MAX_LENGTH			(COMMAND_CONFIRMATION_INDEX + PASSWORD_LENGTH)
+
+/* Reply frame payload: sequence of the command + result */
+#define REPLY_SEQUENCE_INDEX		0
+#define REPLY_RESULT_INDEX			1
+#define REPLY_LENGTH				2
+
+/* Timer1 tick (compare match with F_CPU/64 clock) is the UART time base */
+#define TIMER_TICK_COMPARE_VALUE	((uint16)(((F_CPU / 64UL) * UART_TICK_PERIOD_MS) / 1000UL) - 1)
+#define TICKS_PER_SECOND			(1000 / UART_TICK_PERIOD_MS)
+#define DOOR_STATUS_PERIOD_TICKS	(DOOR_STATUS_PERIOD_MS / UART_TICK_PERIOD_MS)
+#define MESSAGE_PERIOD_TICKS		(MESSAGE_PERIOD_MS / UART_TICK_PERIOD_MS)
+#define REPLY_TIMEOUT_TICKS			(REPLY_TIMEOUT_MS / UART_TICK_PERIOD_MS)
+#define BUS_REPLY_TIMEOUT_TICKS		(BUS_REPLY_TIMEOUT_MS / UART_TICK_PERIOD_MS)
+#define TYPE_AHEAD_MAX_AGE_TICKS	(TYPE_AHEAD_MAX_AGE_MS / UART_TICK_PERIOD_MS)	/* KEYPAD_tick is called every tick */
+
+/* Tasks of the scheduler (index in the task table, 0 has the highest priority) */
+#define HMI_TASK_TIMERS				0
+#define HMI_TASK_UI					1
+#define HMI_NUM_OF_TASKS			2
+
+/********************************************************************************************
+ * 									Types Declaration										*
+ ********************************************************************************************/
+/* Messages of the LCD, index of the string table (g_hmiStrings) */
+typedef enum
+{
+	HMI_STRING_WELCOME,
+	HMI_STRING_ENTER_PASSWORD,
+	HMI_STRING_ENTER_OLD_PASSWORD,
+	HMI_STRING_ENTER_NEW_PASSWORD,
+	HMI_STRING_REENTER_PASSWORD,
+	HMI_STRING_SUBMIT,
+	HMI_STRING_WRONG_PASSWORD,
+	HMI_STRING_TRY_AGAIN,
+	HMI_STRING_PASSWORD_SAVED,
+	HMI_STRING_PASSWORD_UNMATCHED,
+	HMI_STRING_OPEN_DOOR,
+	HMI_STRING_CHANGE_PASSWORD,
+	HMI_STRING_NO_RESPONSE,
+	HMI_STRING_DOOR_OPENING,
+	HMI_STRING_DOOR_HOLDING,
+	HMI_STRING_DOOR_CLOSING,
+	HMI_STRING_SYSTEM_CLOSED,
+	HMI_STRING_CATCH_THIEF,
+	HMI_NUM_OF_STRINGS
+}HMI_StringIdType;
 
 /********************************************************************************************
  * 									Global Variables										*
@@ -55,24 +159,226 @@
 /* Global array to store the password */
 uint8 g_userPassword[PASSWORD_LENGTH];
 
-/* Global variable for password status */
-uint8 g_passwordStatus = PASSWORD_UNMATCHED;
+/* Global array to store the confirmation password */
+uint8 g_confirmationPassword[PASSWORD_LENGTH];
+
+/* Global array to keep the last command frame payload to retransmit it */
+uint8 g_commandPayload[COMMAND_MAX_LENGTH];
+uint8 g_commandLength = 0;
+
+/* Global variable for the sequence number of the commands */
+uint8 g_sequence = 0;
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/* Global array to receive the frames of the Control ECU (poll or reply) from the RX ISR */
+uint8 g_busFrame[REPLY_LENGTH];
+
+/* Global variables for the command waiting for a poll and its reply (set by the RX ISR) */
+volatile uint8 g_commandPending = FALSE;
+volatile uint8 g_reply = LINK_ERROR;
+#else
+/* Global array to receive the reply frame of the last command from the RX ISR */
+uint8 g_replyFrame[REPLY_LENGTH];
+
+/* Global variable for the reply timeouts in a row (the baud rate is negotiated again) */
+uint8 g_replyTimeouts = 0;
+#endif
+
+/* State that sent the command waiting for its reply, and number of its transmissions */
+uint8 g_replyState = HMI_STATE_MAIN_OPTIONS;
+uint8 g_replyTrial = 0;
+
+/* State machine of the user interface: current state, state after the message, keys of the
+ * password entry and door state displayed */
+uint8 g_hmiState = HMI_STATE_MESSAGE;
+uint8 g_nextState = HMI_STATE_MAIN_OPTIONS;
+uint8 g_passwordIndex = 0;
+uint8 g_doorState = DOOR_OPENING;
 
-/* Global variable to be incremented every second */
-uint8 g_seconds = 0;
+/* Software timer of the current state (message, door state queries, lockout, reply) and its timeout
+ * waiting for the task of the user interface */
+Timer_SoftTimerType g_stateTimer;
+uint8 g_stateTimeout = FALSE;
+
+/* Periodic software timer of the baud rate negotiation after a lost link (point-to-point link),
+ * no command is sent while it runs */
+Timer_SoftTimerType g_linkTimer;
 
 /* Global variable to store the number of wrong attempts */
 uint8 g_trialNumber = 0;
 
+/* Messages of the LCD in flash (PROGMEM), not copied to the SRAM at startup */
+static const char g_stringWelcome[] PROGMEM = "Welcome to Security Door Lock System";
+static const char g_stringEnterPassword[] PROGMEM = "Enter Password:";
+static const char g_stringEnterOldPassword[] PROGMEM = "Enter old Password:";
+static const char g_stringEnterNewPassword[] PROGMEM = "Enter New Password:";
+static const char g_stringReenterPassword[] PROGMEM = "Re-enter Password:";
+static const char g_stringSubmit[] PROGMEM = "= : To submit";
+static const char g_stringWrongPassword[] PROGMEM = "Wrong Password";
+static const char g_stringTryAgain[] PROGMEM = "Try again!!";
+static const char g_stringPasswordSaved[] PROGMEM = "Password Saved";
+static const char g_stringPasswordUnmatched[] PROGMEM = "Password Unmatched";
+static const char g_stringOpenDoor[] PROGMEM = "+: Open door";
+static const char g_stringChangePassword[] PROGMEM = "-: Change password";
+static const char g_stringNoResponse[] PROGMEM = "No Response";
+static const char g_stringDoorOpening[] PROGMEM = "Opening The Door...";
+static const char g_stringDoorHolding[] PROGMEM = "Holding The Door";
+static const char g_stringDoorClosing[] PROGMEM = "Closing The Door...";
+static const char g_stringSystemClosed[] PROGMEM = "System Closed";
+static const char g_stringCatchThief[] PROGMEM = "Catch The Thief!!";
+
+/* String table in flash, indexed by HMI_StringIdType */
+static PGM_P const g_hmiStrings[HMI_NUM_OF_STRINGS] PROGMEM = {
+	g_stringWelcome,
+	g_stringEnterPassword,
+	g_stringEnterOldPassword,
+	g_stringEnterNewPassword,
+	g_stringReenterPassword,
+	g_stringSubmit,
+	g_stringWrongPassword,
+	g_stringTryAgain,
+	g_stringPasswordSaved,
+	g_stringPasswordUnmatched,
+	g_stringOpenDoor,
+	g_stringChangePassword,
+	g_stringNoResponse,
+	g_stringDoorOpening,
+	g_stringDoorHolding,
+	g_stringDoorClosing,
+	g_stringSystemClosed,
+	g_stringCatchThief
+};
+
 /********************************************************************************************
  * 									Function Prototype										*
  ********************************************************************************************/
 
 /********************************************************************************************
- * [Function Name]: HMI_displayWelcomeScreen
+ * [Function Name]: HMI_getString
+ *
+ * [Description]:This function is responsible for returning the flash address of the message
+ * 				 of the LCD (for the _P display functions).
+ *
+ * [Arguments]: HMI_StringIdType a_stringId
+ *
+ * [in]: a_stringId: Enum to the message
+ *
+ * [out]: Pointer to the string in flash
+ *
+ * [Returns]: PGM_P
+ ********************************************************************************************/
+PGM_P HMI_getString(HMI_StringIdType a_stringId);
+
+/********************************************************************************************
+ * [Function Name]: HMI_timersTask
+ *
+ * [Description]:This function is the task of the software timers, it is made ready by the
+ * 				 timer tick when timers expired and calls their call backs.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_timersTask(void);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_uiTask
+ *
+ * [Description]:This function is the task of the user interface (state machine of the
+ * 				 screens), it is made ready by the new key events, by the timeout of the
+ * 				 current state, by the reply frames, when a state is entered and at the end of a
+ * 				 baud rate negotiation. The keys are taken only in the states that wait for the
+ * 				 user, in the other states (message, door, alarm lockout, reply) and during a
+ * 				 negotiation they are kept for later (type-ahead).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_uiTask(void);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_enterState
+ *
+ * [Description]:This function is responsible for entering a state of the user interface
+ * 				 (except the message state, see HMI_showMessage): its screen is displayed
+ * 				 and its timer is started, the timer of the last state is cancelled.
+ *
+ * [Arguments]: uint8 a_state
+ *
+ * [in]: a_state: The new state (HMI_STATE_...)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_enterState(uint8 a_state);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_showMessage
+ *
+ * [Description]:This function is responsible for displaying a message on the LCD for
+ * 				 MESSAGE_PERIOD_MS (message state), then the next state is entered.
+ *
+ * [Arguments]: HMI_StringIdType a_firstLine, HMI_StringIdType a_secondLine, uint8 a_nextState
+ *
+ * [in]: - a_firstLine: The message of the first row
+ * 		 - a_secondLine: The message of the second row (HMI_NUM_OF_STRINGS: none)
+ * 		 - a_nextState: The state entered at the end of the message
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_showMessage(HMI_StringIdType a_firstLine, HMI_StringIdType a_secondLine, uint8 a_nextState);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_handleKey
+ *
+ * [Description]:This function is responsible for taking one key in the main options (the
+ * 				 selected option) or in a password entry: a digit is stored and displayed as
+ * 				 '*', '=' submits the password, the password is submitted after
+ * 				 PASSWORD_LENGTH keys too.
+ *
+ * [Arguments]: uint8 a_key
+ *
+ * [in]: a_key: The pressed key
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_handleKey(uint8 a_key);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_passwordEntered
  *
- * [Description]:This function is responsible for displaying the welcome message in LCD for
- * 				 the person who use this system for the first time.
+ * [Description]:This function is responsible for the submitted password of the current
+ * 				 state: the command is sent to the Control ECU in one frame and the next
+ * 				 state is selected from its reply.
  *
  * [Arguments]: None
  *
@@ -83,16 +389,17 @@ uint8 g_trialNumber = 0;
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_displayWelcomeScreen(void);
+void HMI_passwordEntered(void);
 
 
 
 /********************************************************************************************
- * [Function Name]: HMI_takeFirstPassword
+ * [Function Name]: HMI_stateTimeout
  *
- * [Description]:This function is responsible for taking the password for the user and
- * 				 store it in global array (g_userPassword) in order to send the password
- * 				 to the other micro-controller.
+ * [Description]:This function is responsible for the timeout of the current state: the end
+ * 				 of a message or of the alarm lockout, the next door state query, or no reply
+ * 				 in time (the command is sent again). After FRAME_RESYNC_TIMEOUTS reply timeouts
+ * 				 in a row the baud rate is negotiated again.
  *
  * [Arguments]: None
  *
@@ -103,32 +410,53 @@ void HMI_displayWelcomeScreen(void);
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_takeFirstPassword(void);
+void HMI_stateTimeout(void);
 
 
 
 /********************************************************************************************
- * [Function Name]: HMI_getPassword
+ * [Function Name]: HMI_stateTimerCallBack
  *
- * [Description]:This function is responsible for displaying the main options in LCD.
+ * [Description]:This function is the call back of the software timer of the current state,
+ * 				 the timeout is served by the task of the user interface.
  *
- * [Arguments]: uint8 *a_password_Ptr
+ * [Arguments]: None
  *
- * [in]: *a_password_Ptr: pointer to unsigned character
+ * [in]: void
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_getPassword(uint8 *a_password_Ptr);
+void HMI_stateTimerCallBack(void);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_pollKey
+ *
+ * [Description]:This function is responsible for taking the next pressed key from the keypad
+ * 				 events in order (type-ahead) without waiting, the keys older than
+ * 				 TYPE_AHEAD_MAX_AGE_MS are dropped.
+ *
+ * [Arguments]: uint8 *a_key_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: *a_key_Ptr: The pressed key
+ *
+ * [Returns]: TRUE if a key is pressed, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 HMI_pollKey(uint8 *a_key_Ptr);
 
 
 
 /********************************************************************************************
- * [Function Name]: HMI_mainOptions
+ * [Function Name]: HMI_discardKeys
  *
- * [Description]:This function is responsible for displaying the main options in LCD.
+ * [Description]:This function is responsible for dropping all the keys typed until now.
  *
  * [Arguments]: None
  *
@@ -139,32 +467,43 @@ void HMI_getPassword(uint8 *a_password_Ptr);
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_mainOptions(void);
+void HMI_discardKeys(void);
 
 
 
 /********************************************************************************************
- * [Function Name]: HMI_sendPasswordByUART
+ * [Function Name]: HMI_sendCommand
  *
- * [Description]:This function is responsible for sending password to other micro-controller.
+ * [Description]:This function is responsible for sending the selected option and the password
+ * 				 (and the confirmation password) to other micro-controller in one frame, with
+ * 				 a new sequence number. The frame is kept to be sent again in the reply state.
+ * 				 On the multi-drop bus the frame is sent as the answer of the next poll.
  *
- * [Arguments]: uint8 *password_Ptr
+ * [Arguments]: uint8 a_option, uint8 *a_password_Ptr, uint8 *a_confirmation_Ptr
  *
- * [in]: *password_Ptr: pointer to unsigned character
+ * [in]: - a_option: The selected option
+ * 		 - *a_password_Ptr: pointer to unsigned character
+ * 		 - *a_confirmation_Ptr: pointer to unsigned character (NULL_PTR if not needed)
  *
  * [out]: void
  *
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_sendPasswordByUART(uint8 *password_Ptr);
+void HMI_sendCommand(uint8 a_option, uint8 *a_password_Ptr, uint8 *a_confirmation_Ptr);
 
 
 
 /********************************************************************************************
- * [Function Name]: HMI_openingDoor
+ * [Function Name]: HMI_awaitReply
  *
- * [Description]:This function is responsible for displaying the Door state in LCD.
+ * [Description]:This function is responsible for waiting the reply of the command sent by the
+ * 				 current state without blocking: the reply state is entered (the screen is
+ * 				 kept) and its timer is started, the reply is given to HMI_replyReceived.
+ * 				 The command is sent again if no reply is received in REPLY_TIMEOUT_MS (the
+ * 				 command or the reply is lost), MAX_COMMAND_TRIALS times. On the multi-drop bus
+ * 				 the reply is received by the RX ISR in BUS_REPLY_TIMEOUT_MS (see
+ * 				 HMI_busFrameCallBack).
  *
  * [Arguments]: None
  *
@@ -175,15 +514,16 @@ void HMI_sendPasswordByUART(uint8 *password_Ptr);
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_openingDoor(void);
+void HMI_awaitReply(void);
 
 
 
 /********************************************************************************************
- * [Function Name]: HMI_countBuzzerRunTime
+ * [Function Name]: HMI_checkReply
  *
- * [Description]:This function is responsible for displaying a warning message on the LCD
- * 				 when a thief tries to type wrong password for many times.
+ * [Description]:This function is responsible for taking the reply frame in the reply state,
+ * 				 corrupted frames are dropped by the RX ISR and the replies of older commands
+ * 				 are dropped here.
  *
  * [Arguments]: None
  *
@@ -194,7 +534,27 @@ void HMI_openingDoor(void);
  * [Returns]: void
  *
  ********************************************************************************************/
-void HMI_countBuzzerRunTime(void);
+void HMI_checkReply(void);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_replyReceived
+ *
+ * [Description]:This function is responsible for selecting the next state from the reply of
+ * 				 the command sent by g_replyState. After a reset of the Control ECU alone (no
+ * 				 password) the password is taken again.
+ *
+ * [Arguments]: uint8 a_reply
+ *
+ * [in]: a_reply: The reply (OPEN_DOOR, WRONG_PASSWORD, PASSWORD_MATCHED, ...) or LINK_ERROR
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_replyReceived(uint8 a_reply);
 
 
 
@@ -219,8 +579,9 @@ void HMI_clearArray(uint8 *a_Ptr);
 /********************************************************************************************
  * [Function Name]: Timer_CallBackFunction
  *
- * [Description]:This function is responsible for incrementing global variable (g_seconds)
- * 				 that indicates the number of counted seconds.
+ * [Description]:This function is responsible for advancing the software timers and for
+ * 				 scanning the keypad every tick, and for making the tasks of the expired timers
+ * 				 and of the new keys ready, it subscribes to the tick after UART_tick.
  *
  * [Arguments]: None
  *
@@ -233,4 +594,69 @@ void HMI_clearArray(uint8 *a_Ptr);
  ********************************************************************************************/
 void Timer_CallBackFunction(void);
 
+
+
+#if (UART_MULTIDROP_ENABLE == FALSE)
+/********************************************************************************************
+ * [Function Name]: HMI_replyFrameCallBack
+ *
+ * [Description]:This function is called from the RX ISR when a frame is received in the reply
+ * 				 state, the frame is checked by the task of the user interface.
+ *
+ * [Arguments]: uint8 a_type, uint8 a_length
+ *
+ * [in]: - a_type: Type of the received frame
+ * 		 - a_length: Payload length of the received frame
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_replyFrameCallBack(uint8 a_type, uint8 a_length);
+
+
+
+/********************************************************************************************
+ * [Function Name]: HMI_linkTimerCallBack
+ *
+ * [Description]:This function is the call back of the periodic software timer of the baud rate
+ * 				 negotiation after a lost link, it runs the next step of the exchange every
+ * 				 tick. At the end the timer is stopped and the task of the user interface takes
+ * 				 the keys typed meanwhile.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_linkTimerCallBack(void);
+#else
+/********************************************************************************************
+ * [Function Name]: HMI_busFrameCallBack
+ *
+ * [Description]:This function is responsible for answering the polls of the Control ECU on the
+ * 				 multi-drop bus, it is called from the RX ISR for every frame sent to this panel:
+ * 				 - A poll is answered with the pending command, or with an empty poll frame.
+ * 				 - The reply of the pending command (same sequence) completes it, the task
+ * 				   of the user interface is made ready.
+ * 				 The next frame is then received in g_busFrame again.
+ *
+ * [Arguments]: uint8 a_type, uint8 a_length
+ *
+ * [in]: - a_type: Type of the received frame
+ * 		 - a_length: Payload length of the received frame
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void HMI_busFrameCallBack(uint8 a_type, uint8 a_length);
+#endif
+
 #endif /* HMI_ECU_H_ */
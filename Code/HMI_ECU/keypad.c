@@ -12,138 +12,247 @@
 #include "common_macros.h" /* To use the macros like SET_BIT */
 #include "keypad.h"
 #include "gpio.h"
+#include "port.h" /* To use the critical sections */
 
 /*******************************************************************************
- *                      Functions Prototypes(Private)                          *
+ *                                Definitions                                  *
  *******************************************************************************/
 
-#if (KEYPAD_NUM_COLS == 3)
+/* State of a key: debounced state flag + integrator (0 to KEYPAD_DEBOUNCE_SAMPLES) */
+#define KEYPAD_STATE_PRESSED             0x80
+#define KEYPAD_STATE_INTEGRATOR_MASK     0x7F
+
+/* Pins of the keypad port */
+#define KEYPAD_COLUMN_PIN_MASK(COL)      (1<<(KEYPAD_FIRST_COLUMN_PIN_ID+(COL)))
+#define KEYPAD_ROWS_MASK                 (((1<<KEYPAD_NUM_ROWS)-1)<<KEYPAD_FIRST_ROW_PIN_ID)
+
 /*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x3 keypad
+ * PORT value of the scan, written once: the rows have their pull-ups and the column pins are
+ * low, so a column is driven by making its pin an output and released by making it an input
+ * again (never two outputs against each other when two keys of one row are pressed).
+ * With external pull-downs (pressed = high), the driven column pin is also set high.
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+#define KEYPAD_PORT_VALUE                KEYPAD_ROWS_MASK
+#define KEYPAD_ROWS_RELEASED_VALUE       KEYPAD_ROWS_MASK
+#else
+#define KEYPAD_PORT_VALUE                0
+#define KEYPAD_ROWS_RELEASED_VALUE       0
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* DDR value driving every column, one store per column */
+static const uint8 g_columnDirection[KEYPAD_NUM_COLS] = {
+	KEYPAD_COLUMN_PIN_MASK(0), KEYPAD_COLUMN_PIN_MASK(1), KEYPAD_COLUMN_PIN_MASK(2),
+#if (KEYPAD_NUM_COLS == 4)
+	KEYPAD_COLUMN_PIN_MASK(3)
+#endif
+};
+
+/* Key value of every key number (row * KEYPAD_NUM_COLS + column), as printed on the keypad */
+#if (KEYPAD_NUM_COLS == 3)
+static const uint8 g_keyValue[KEYPAD_NUM_KEYS] = {
+	1,   2, 3,
+	4,   5, 6,
+	7,   8, 9,
+	'*', 0, '#'
+};
 #elif (KEYPAD_NUM_COLS == 4)
+static const uint8 g_keyValue[KEYPAD_NUM_KEYS] = {
+	7,  8, 9,   '%',
+	4,  5, 6,   '*',
+	1,  2, 3,   '-',
+	13, 0, '=', '+'		/* 13: ASCII of Enter */
+};
+#endif
+
+/* Column driven since the last KEYPAD_tick (its rows are read at the next one) */
+static uint8 g_column = 0;
+
+/* Number of KEYPAD_tick calls, the time stamp of the events */
+static volatile uint16 g_time = 0;
+
+/* Debouncing state of every key, indexed by row * KEYPAD_NUM_COLS + column */
+static uint8 g_keyState[KEYPAD_NUM_KEYS];
+
+/* Rows of every column with a key not at rest (pressed or integrator not 0) */
+static uint8 g_columnActiveRows[KEYPAD_NUM_COLS];
+
 /*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x4 keypad
+ * Single-producer/single-consumer event queue: KEYPAD_tick (timer ISR) is the only writer of
+ * g_eventHead and the application is the only writer of g_eventTail, as the UART ring buffers.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
-#endif
+static volatile KEYPAD_KeyEventType g_events[KEYPAD_EVENT_QUEUE_SIZE];
+static volatile uint8 g_eventHead = 0;
+static volatile uint8 g_eventTail = 0;
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
  *******************************************************************************/
-uint8 KEYPAD_getPressedKey(void)
+/*
+ * Description :
+ * Drive the column: its pin is the only output of the keypad port.
+ */
+static void KEYPAD_driveColumn(uint8 col)
 {
-	uint8 col,row;
-	uint8 keypad_port_value = 0;
-	while(1)
-	{
-		for(col=0;col<KEYPAD_NUM_COLS;col++) /* loop for columns */
-		{
-			/* 
-			 * Each time setup the direction for all keypad port as input pins,
-			 * except this column will be output pin
-			 */
-			GPIO_setupPortDirection(KEYPAD_PORT_ID,PORT_INPUT);
-			GPIO_setupPinDirection(KEYPAD_PORT_ID,KEYPAD_FIRST_COLUMN_PIN_ID+col,PIN_OUTPUT);
-			
-#if(KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
-			/* Clear the column output pin and set the rest pins value */
-			keypad_port_value = ~(1<<(KEYPAD_FIRST_COLUMN_PIN_ID+col));
-#else
-			/* Set the column output pin and clear the rest pins value */
-			keypad_port_value = (1<<(KEYPAD_FIRST_COLUMN_PIN_ID+col));
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_HIGH)
+	GPIO_WRITE_PORT(KEYPAD_PORT_ID,g_columnDirection[col]);	/* No pull-up on the other pins */
 #endif
-			GPIO_writePort(KEYPAD_PORT_ID,keypad_port_value);
-
-			for(row=0;row<KEYPAD_NUM_ROWS;row++) /* loop for rows */
-			{
-				/* Check if the switch is pressed in this row */
-				if(GPIO_readPin(KEYPAD_PORT_ID,row+KEYPAD_FIRST_ROW_PIN_ID) == KEYPAD_BUTTON_PRESSED)
-				{
-					#if (KEYPAD_NUM_COLS == 3)
-						return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-					#elif (KEYPAD_NUM_COLS == 4)
-						return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-					#endif
-				}
-			}
-		}
-	}	
+	GPIO_SETUP_PORT_DIRECTION(KEYPAD_PORT_ID,g_columnDirection[col]);
 }
 
-#if (KEYPAD_NUM_COLS == 3)
-
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x3 shape
+ * Queue a key event (called from KEYPAD_tick), it is dropped if the queue is full.
  */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number)
+static void KEYPAD_queueEvent(uint8 key_number, KEYPAD_EventType event)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	uint8 nextHead = (g_eventHead + 1) & (KEYPAD_EVENT_QUEUE_SIZE - 1);
+
+	if(nextHead != g_eventTail)
 	{
-		case 10: keypad_button = '*'; // ASCII Code of *
-				 break;
-		case 11: keypad_button = 0;
-				 break;		
-		case 12: keypad_button = '#'; // ASCII Code of #
-				 break;
-		default: keypad_button = button_number;
-				break;
+		g_events[g_eventHead].key = g_keyValue[key_number];
+		g_events[g_eventHead].event = event;
+		g_events[g_eventHead].time = g_time;
+		g_eventHead = nextHead;
 	}
-	return keypad_button;
-} 
-
-#elif (KEYPAD_NUM_COLS == 4)
+}
 
 /*
  * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x4 shape
+ * Integrate one sample of the key and queue an event when its debounced state changes.
+ * Return TRUE while the key is not at rest.
  */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number)
+static uint8 KEYPAD_debounce(uint8 key_number, uint8 isPressed)
 {
-	uint8 keypad_button = 0;
-	switch(button_number)
+	uint8 state = g_keyState[key_number];
+	uint8 integrator = state & KEYPAD_STATE_INTEGRATOR_MASK;
+
+	if(isPressed == TRUE)
 	{
-		case 1: keypad_button = 7;
-				break;
-		case 2: keypad_button = 8;
-				break;
-		case 3: keypad_button = 9;
-				break;
-		case 4: keypad_button = '%'; // ASCII Code of %
-				break;
-		case 5: keypad_button = 4;
-				break;
-		case 6: keypad_button = 5;
-				break;
-		case 7: keypad_button = 6;
-				break;
-		case 8: keypad_button = '*'; /* ASCII Code of '*' */
-				break;		
-		case 9: keypad_button = 1;
-				break;
-		case 10: keypad_button = 2;
-				break;
-		case 11: keypad_button = 3;
-				break;
-		case 12: keypad_button = '-'; /* ASCII Code of '-' */
-				break;
-		case 13: keypad_button = 13;  /* ASCII of Enter */
-				break;			
-		case 14: keypad_button = 0;
-				break;
-		case 15: keypad_button = '='; /* ASCII Code of '=' */
-				break;
-		case 16: keypad_button = '+'; /* ASCII Code of '+' */
-				break;
-		default: keypad_button = button_number;
-				break;
+		if(integrator < KEYPAD_DEBOUNCE_SAMPLES)
+		{
+			integrator++;
+		}
+		if((integrator == KEYPAD_DEBOUNCE_SAMPLES) && !(state & KEYPAD_STATE_PRESSED))
+		{
+			state |= KEYPAD_STATE_PRESSED;
+			KEYPAD_queueEvent(key_number, KEYPAD_KEY_PRESSED);
+		}
+	}
+	else
+	{
+		if(integrator > 0)
+		{
+			integrator--;
+		}
+		if((integrator == 0) && (state & KEYPAD_STATE_PRESSED))
+		{
+			state &= ~KEYPAD_STATE_PRESSED;
+			KEYPAD_queueEvent(key_number, KEYPAD_KEY_RELEASED);
+		}
 	}
-	return keypad_button;
-} 
 
-#endif
+	state = (state & KEYPAD_STATE_PRESSED) | integrator;
+	g_keyState[key_number] = state;
+	return (state != 0) ? TRUE : FALSE;
+}
+
+void KEYPAD_init(void)
+{
+	/* Pull-ups and column level once, then only the direction of the columns changes */
+	g_column = 0;
+	GPIO_WRITE_PORT(KEYPAD_PORT_ID,KEYPAD_PORT_VALUE);
+	KEYPAD_driveColumn(g_column);
+}
+
+uint8 KEYPAD_tick(void)
+{
+	uint8 row;
+	uint8 rows;
+	uint8 key_number;
+	uint8 activeRows;
+	uint8 pendingRows;
+	uint8 eventHead = g_eventHead;
+
+	g_time++;
+
+	/*
+	 * The column was driven one tick ago, its rows had all this time to settle: one read of
+	 * the port gives the pressed rows (bit 0 = first row)
+	 */
+	rows = ((GPIO_READ_PORT(KEYPAD_PORT_ID) ^ KEYPAD_ROWS_RELEASED_VALUE) & KEYPAD_ROWS_MASK)
+			>> KEYPAD_FIRST_ROW_PIN_ID;
+
+	/*
+	 * Only the keys pressed or not at rest are debounced, nothing to do in a column without
+	 * them (the usual case)
+	 */
+	pendingRows = rows | g_columnActiveRows[g_column];
+	if(pendingRows != 0)
+	{
+		activeRows = 0;
+		key_number = g_column;	/* Key of the first row in this column */
+		for(row=0;pendingRows!=0;row++) /* loop for rows */
+		{
+			if((pendingRows & 1) && (KEYPAD_debounce(key_number, (rows & 1) ? TRUE : FALSE) == TRUE))
+			{
+				activeRows |= (1<<row);
+			}
+			pendingRows >>= 1;
+			rows >>= 1;
+			key_number += KEYPAD_NUM_COLS;
+		}
+		g_columnActiveRows[g_column] = activeRows;
+	}
+
+	/* Drive the next column, read at the next tick */
+	g_column++;
+	if(g_column == KEYPAD_NUM_COLS)
+	{
+		g_column = 0;
+	}
+	KEYPAD_driveColumn(g_column);
+
+	return (g_eventHead != eventHead) ? TRUE : FALSE;
+}
+
+uint16 KEYPAD_getTime(void)
+{
+	uint16 time;
+	uint8 sreg;
+
+	/* 16-bit variable written by the timer ISR */
+	PORT_ENTER_CRITICAL(sreg);
+	time = g_time;
+	PORT_EXIT_CRITICAL(sreg);
+	return time;
+}
+
+uint8 KEYPAD_getEvent(KEYPAD_KeyEventType *Event_Ptr)
+{
+	if(g_eventHead == g_eventTail)
+	{
+		return FALSE;
+	}
+
+	Event_Ptr->key = g_events[g_eventTail].key;
+	Event_Ptr->event = g_events[g_eventTail].event;
+	Event_Ptr->time = g_events[g_eventTail].time;
+	g_eventTail = (g_eventTail + 1) & (KEYPAD_EVENT_QUEUE_SIZE - 1);
+	return TRUE;
+}
+
+uint8 KEYPAD_getPressedKey(void)
+{
+	KEYPAD_KeyEventType keyEvent;
+
+	while((KEYPAD_getEvent(&keyEvent) == FALSE) || (keyEvent.event != KEYPAD_KEY_PRESSED))
+	{
+		/* Wait for the timer ISR to queue a key press */
+	}
+	return keyEvent.key;
+}
@@ -33,13 +33,72 @@
 #define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
 #define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
 
+#define KEYPAD_NUM_KEYS                  (KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS)
+
+/*
+ * Debouncing: KEYPAD_tick scans one column, so a key is sampled every KEYPAD_NUM_COLS ticks.
+ * The integrator of a key counts up on the pressed samples and down on the released ones, the
+ * key is pressed when it reaches KEYPAD_DEBOUNCE_SAMPLES and released when it is back to 0
+ * (with 10 ms ticks and 4 columns: a press or a release is reported after 40 to 80 ms).
+ */
+#define KEYPAD_DEBOUNCE_SAMPLES          2
+
+/*
+ * Size of the key event queue, must be a power of 2 (2, 4, 8 ... 128). The keys typed while
+ * the application is busy (LCD, UART, message screens) wait in the queue: 16 events keep
+ * 8 keys (press + release), an option, a password and the submit key.
+ */
+#define KEYPAD_EVENT_QUEUE_SIZE          16
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef enum
+{
+	KEYPAD_KEY_PRESSED, KEYPAD_KEY_RELEASED
+}KEYPAD_EventType;
+
+typedef struct
+{
+	uint8 key;					/* Key value (0 to 9 for the digits, ASCII for the others) */
+	KEYPAD_EventType event;
+	uint16 time;				/* KEYPAD_tick count of the event (KEYPAD_getTime) */
+}KEYPAD_KeyEventType;
+
 /*******************************************************************************
  *                      Functions Prototypes                                   *
  *******************************************************************************/
 
 /*
  * Description :
- * Get the Keypad pressed button
+ * Setup the keypad port (rows input, columns driven by the scan) and drive the first column.
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Scan step, called by the application from its timer ISR: debounce the keys of the column
+ * driven since the last call, queue their press/release events and drive the next column.
+ * Return TRUE if an event is queued by this step.
+ */
+uint8 KEYPAD_tick(void);
+
+/*
+ * Description :
+ * Return the number of KEYPAD_tick calls (wraps at 65536), the time base of the events.
+ */
+uint16 KEYPAD_getTime(void);
+
+/*
+ * Description :
+ * Take the oldest key event without waiting, FALSE if there is no event. When the queue is
+ * full the new events are dropped.
+ */
+uint8 KEYPAD_getEvent(KEYPAD_KeyEventType *Event_Ptr);
+
+/*
+ * Description :
+ * Wait for the next key press (the release events are skipped) and return the key.
  */
 uint8 KEYPAD_getPressedKey(void);
 
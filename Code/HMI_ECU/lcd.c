@@ -14,11 +14,277 @@
 #include "common_macros.h" /* To use the macros like SET_BIT */
 #include "lcd.h"
 #include "gpio.h"
+#if (LCD_QUEUE_ENABLE == TRUE)
+#include "timer.h"
+#include "port.h" /* To use the critical sections */
+#endif
+
+#if (LCD_RS_PORT_ID != LCD_RW_PORT_ID) || (LCD_RS_PORT_ID != LCD_E_PORT_ID)
+#error "LCD RS, RW and E must be on the same port"
+#endif
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Bus timing of the HD44780 (ns), rounded up to whole CPU cycles by _delay_us */
+#define LCD_DELAY_NS(NS)               _delay_us((NS)/1000.0)
+#define LCD_ADDRESS_SETUP_NS           40    /* tAS: RS/RW to E rise */
+#define LCD_ENABLE_PULSE_NS            230   /* PWEH, also covers tDDR (160ns) of a read */
+#define LCD_ENABLE_LOW_NS              270   /* tcycE (500ns) - PWEH */
+
+#if (LCD_DATA_BITS_MODE == 4)
+#define LCD_FUNCTION_SET               LCD_TWO_LINES_FOUR_BITS_MODE
+/* Data pins only, the other pins of the data port are not touched */
+#define LCD_SETUP_DATA_DIRECTION(DIRECTION)  GPIO_SETUP_PORT_DIRECTION_MASKED(LCD_DATA_PORT_ID,LCD_DATA_MASK,DIRECTION)
+/* Reset by instruction to the 4-bit interface (the busy flag can't be read before) */
+#define LCD_EIGHT_BITS_NIBBLE          (LCD_TWO_LINES_EIGHT_BITS_MODE>>4)
+#define LCD_FOUR_BITS_NIBBLE           (LCD_TWO_LINES_FOUR_BITS_MODE>>4)
+#define LCD_FIRST_RESET_DELAY_US       4100
+#define LCD_RESET_DELAY_US             100
+#else
+#define LCD_FUNCTION_SET               LCD_TWO_LINES_EIGHT_BITS_MODE
+#define LCD_SETUP_DATA_DIRECTION(DIRECTION)  GPIO_SETUP_PORT_DIRECTION(LCD_DATA_PORT_ID,DIRECTION)
+#endif
+
+/* Clear display (0x01) and return home (0x02, 0x03) are the slow instructions */
+#define LCD_IS_HOME_INSTRUCTION(RS,VALUE)   (((RS) == LCD_INSTRUCTION_WRITE) && ((VALUE) <= (LCD_GO_TO_HOME | 1)))
+
+#define LCD_POWER_ON_DELAY_MS          15    /* Before the first instruction without the busy flag */
+
+#if (LCD_BUSY_FLAG_POLLING == TRUE)
+/* Reads of the busy flag before giving up (no LCD), each one is more than 1us */
+#define LCD_BUSY_FLAG_MAX_POLLS        5000
+#else
+/* Worst execution times (fosc = 190KHz), waited after every write */
+#define LCD_EXECUTION_TIME_US          40
+#define LCD_HOME_EXECUTION_TIME_US     1600  /* Clear display and return home */
+#endif
+
+#if (LCD_QUEUE_ENABLE == TRUE)
+/* Timer of the queue in compare mode, F_CPU/8 */
+#define LCD_TICK_COMPARE_VALUE         ((uint16)((((F_CPU / 8UL) * LCD_TICK_PERIOD_US) / 1000000UL) - 1))
+#if (LCD_BUSY_FLAG_POLLING == FALSE)
+#if (LCD_EXECUTION_TIME_US > LCD_TICK_PERIOD_US)
+#error "LCD_TICK_PERIOD_US must cover the execution time of a write"
+#endif
+/* Ticks to skip after a clear or return home */
+#define LCD_HOME_EXECUTION_TICKS       ((LCD_HOME_EXECUTION_TIME_US + LCD_TICK_PERIOD_US - 1) / LCD_TICK_PERIOD_US)
+#endif
+#endif
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+#if (LCD_QUEUE_ENABLE == TRUE)
+/* Write of the queue: LCD_INSTRUCTION_WRITE or LCD_DATA_WRITE and the byte */
+typedef struct
+{
+	uint8 registerSelect;
+	uint8 value;
+} LCD_WriteType;
+
+/*
+ * Single-producer/single-consumer queue of the writes: the application is the only writer of
+ * g_lcdQueueHead and LCD_tick (timer ISR) is the only writer of g_lcdQueueTail. The timer
+ * runs only while the queue is not empty (g_lcdQueueRunning).
+ */
+static volatile LCD_WriteType g_lcdQueue[LCD_QUEUE_SIZE];
+static volatile uint8 g_lcdQueueHead = 0;
+static volatile uint8 g_lcdQueueTail = 0;
+static volatile uint8 g_lcdQueueRunning = FALSE;
+
+static const Timer_ConfigType g_lcdTimerConfig = {LCD_QUEUE_TIMER_ID, COMPARE, 0, LCD_TICK_COMPARE_VALUE, CLK_8};
+
+#if (LCD_BUSY_FLAG_POLLING == FALSE)
+/* Ticks left before the LCD is ready again */
+static uint8 g_lcdWaitTicks = 0;
+#endif
+#endif
 
 /*******************************************************************************
  *                      Functions Definitions                                  *
  *******************************************************************************/
 
+/*
+ * Description :
+ * One E pulse with the datasheet timing, RS/RW and the data bus (write) are already set.
+ * Return the data port (pins of the read) while E is high.
+ */
+static uint8 LCD_pulseEnable(void)
+{
+	uint8 data;
+
+	LCD_DELAY_NS(LCD_ADDRESS_SETUP_NS);
+	GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+	LCD_DELAY_NS(LCD_ENABLE_PULSE_NS); /* Also covers tDSW (80ns) of a write and tDDR (160ns) of a read */
+	data = GPIO_READ_PORT(LCD_DATA_PORT_ID);
+	GPIO_WRITE_PIN(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
+	LCD_DELAY_NS(LCD_ENABLE_LOW_NS); /* Covers tH/tAH and the E cycle time of the next pulse */
+	return data;
+}
+
+#if (LCD_DATA_BITS_MODE == 4)
+/*
+ * Description :
+ * Write the low nibble of the value on D4-D7 in one masked store and pulse E.
+ */
+static void LCD_writeNibble(uint8 nibble)
+{
+	GPIO_WRITE_PORT_MASKED(LCD_DATA_PORT_ID,LCD_DATA_MASK,(uint8)(nibble<<LCD_FIRST_DATA_PIN_ID));
+	(void)LCD_pulseEnable();
+}
+#endif
+
+#if (LCD_BUSY_FLAG_POLLING == TRUE)
+/*
+ * Description :
+ * Read the busy flag (D7) of the LCD. The data pins are inputs during the read and outputs
+ * again at the end.
+ */
+static uint8 LCD_isBusy(void)
+{
+	uint8 data;
+
+	LCD_SETUP_DATA_DIRECTION(PORT_INPUT); /* The LCD drives the data bus */
+	GPIO_WRITE_PORT_MASKED(LCD_CONTROL_PORT_ID,LCD_RS_RW_MASK,LCD_INSTRUCTION_READ);
+	data = LCD_pulseEnable();
+#if (LCD_DATA_BITS_MODE == 4)
+	(void)LCD_pulseEnable(); /* Low nibble of the address counter, not used */
+#endif
+	LCD_SETUP_DATA_DIRECTION(PORT_OUTPUT);
+
+	return BIT_IS_SET(data,LCD_BUSY_FLAG_PIN_ID) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Wait until the LCD is ready for the next write: read the busy flag until it is cleared.
+ */
+static void LCD_waitReady(void)
+{
+	uint16 polls = 0;
+
+	while((LCD_isBusy() == TRUE) && (polls < LCD_BUSY_FLAG_MAX_POLLS))
+	{
+		polls++;
+	}
+}
+#endif
+
+/*
+ * Description :
+ * Write an instruction (LCD_INSTRUCTION_WRITE) or a data (LCD_DATA_WRITE) byte to the LCD:
+ * one E pulse (two in 4-bit mode, high nibble first), the LCD must be ready.
+ */
+static void LCD_write(uint8 registerSelect,uint8 value)
+{
+	/* RS and RW=0 in one store */
+	GPIO_WRITE_PORT_MASKED(LCD_CONTROL_PORT_ID,LCD_RS_RW_MASK,registerSelect);
+#if (LCD_DATA_BITS_MODE == 4)
+	LCD_writeNibble(value>>4);
+	LCD_writeNibble(value);
+#else
+	GPIO_WRITE_PORT(LCD_DATA_PORT_ID,value); /* out the byte to the data bus D0 --> D7 */
+	(void)LCD_pulseEnable();
+#endif
+}
+
+/*
+ * Description :
+ * Write a byte to the LCD and wait for it: the busy flag is read before the write, or the
+ * execution time is waited after it.
+ */
+static void LCD_writeNow(uint8 registerSelect,uint8 value)
+{
+#if (LCD_BUSY_FLAG_POLLING == TRUE)
+	LCD_waitReady(); /* Wait for the previous instruction instead of after it */
+	LCD_write(registerSelect,value);
+#else
+	LCD_write(registerSelect,value);
+	if(LCD_IS_HOME_INSTRUCTION(registerSelect,value))
+	{
+		_delay_us(LCD_HOME_EXECUTION_TIME_US);
+	}
+	else
+	{
+		_delay_us(LCD_EXECUTION_TIME_US);
+	}
+#endif
+}
+
+#if (LCD_QUEUE_ENABLE == TRUE)
+/*
+ * Description :
+ * Call back of the queue timer (every LCD_TICK_PERIOD_US): write the next queued byte if the
+ * LCD is ready, stop the timer when the queue is empty.
+ */
+static void LCD_tick(void)
+{
+	uint8 tail;
+
+#if (LCD_BUSY_FLAG_POLLING == TRUE)
+	if(LCD_isBusy() == TRUE)
+	{
+		return; /* Still executing the last write, try at the next tick */
+	}
+#else
+	if(g_lcdWaitTicks != 0)
+	{
+		g_lcdWaitTicks--;
+		return;
+	}
+#endif
+
+	tail = g_lcdQueueTail;
+	if(tail == g_lcdQueueHead)
+	{
+		/* All the writes are done, nothing to do until the next one is queued */
+		Timer_DeInit(LCD_QUEUE_TIMER_ID);
+		g_lcdQueueRunning = FALSE;
+		return;
+	}
+
+	LCD_write(g_lcdQueue[tail].registerSelect,g_lcdQueue[tail].value);
+#if (LCD_BUSY_FLAG_POLLING == FALSE)
+	if(LCD_IS_HOME_INSTRUCTION(g_lcdQueue[tail].registerSelect,g_lcdQueue[tail].value))
+	{
+		g_lcdWaitTicks = LCD_HOME_EXECUTION_TICKS;
+	}
+#endif
+	g_lcdQueueTail = (tail + 1) & (LCD_QUEUE_SIZE - 1);
+}
+
+/*
+ * Description :
+ * Queue a byte for the LCD and start the queue timer if it is stopped. It waits only when the
+ * queue is full.
+ */
+static void LCD_queueWrite(uint8 registerSelect,uint8 value)
+{
+	uint8 head = g_lcdQueueHead;
+	uint8 nextHead = (head + 1) & (LCD_QUEUE_SIZE - 1);
+	uint8 sreg;
+
+	while(nextHead == g_lcdQueueTail)
+	{
+		/* Queue full: wait for the timer ISR to write the oldest byte */
+	}
+	g_lcdQueue[head].registerSelect = registerSelect;
+	g_lcdQueue[head].value = value;
+
+	/* The timer ISR must not stop the timer between the new head and the test */
+	PORT_ENTER_CRITICAL(sreg);
+	g_lcdQueueHead = nextHead;
+	if(g_lcdQueueRunning == FALSE)
+	{
+		g_lcdQueueRunning = TRUE;
+		Timer_init(&g_lcdTimerConfig);
+	}
+	PORT_EXIT_CRITICAL(sreg);
+}
+#endif
+
 /*
  * Description :
  * Initialize the LCD:
@@ -27,19 +293,42 @@
  */
 void LCD_init(void)
 {
-	/* Configure the direction for RS, RW and E pins as output pins */
-	GPIO_setupPinDirection(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_RW_PORT_ID,LCD_RW_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
+	/* Configure the direction for RS, RW and E pins as output pins (E=0) */
+	GPIO_WRITE_PORT_MASKED(LCD_CONTROL_PORT_ID,LCD_CONTROL_MASK,LCD_INSTRUCTION_WRITE);
+	GPIO_SETUP_PORT_DIRECTION_MASKED(LCD_CONTROL_PORT_ID,LCD_CONTROL_MASK,PORT_OUTPUT);
 
-	/* Configure the data port as output port */
-	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
+	/* Configure the data pins as output pins */
+	LCD_SETUP_DATA_DIRECTION(PORT_OUTPUT);
 
-	LCD_sendCommand(LCD_TWO_LINES_EIGHT_BITS_MODE); /* use 2-line lcd + 8-bit Data Mode + 5*7 dot display Mode */
+#if (LCD_DATA_BITS_MODE == 4)
+	/*
+	 * The LCD starts with the 8-bit interface and the high nibble of the bus is read alone:
+	 * reset it by instruction (whatever its interface was) and switch it to 4 bits
+	 */
+	_delay_ms(LCD_POWER_ON_DELAY_MS);
+	GPIO_WRITE_PORT_MASKED(LCD_CONTROL_PORT_ID,LCD_RS_RW_MASK,LCD_INSTRUCTION_WRITE);
+	LCD_writeNibble(LCD_EIGHT_BITS_NIBBLE);
+	_delay_us(LCD_FIRST_RESET_DELAY_US);
+	LCD_writeNibble(LCD_EIGHT_BITS_NIBBLE);
+	_delay_us(LCD_RESET_DELAY_US);
+	LCD_writeNibble(LCD_EIGHT_BITS_NIBBLE);
+	_delay_us(LCD_RESET_DELAY_US);
+	LCD_writeNibble(LCD_FOUR_BITS_NIBBLE);
+	_delay_us(LCD_RESET_DELAY_US);
+#elif (LCD_BUSY_FLAG_POLLING == FALSE)
+	_delay_ms(LCD_POWER_ON_DELAY_MS); /* The busy flag would cover the internal reset */
+#endif
+
+	/* Written at once, the queue (if enabled) is for the writes of the application */
+	LCD_writeNow(LCD_INSTRUCTION_WRITE,LCD_FUNCTION_SET); /* use 2-line lcd + 4/8-bit Data Mode + 5*7 dot display Mode */
 	
-	LCD_sendCommand(LCD_CURSOR_OFF); /* cursor off */
+	LCD_writeNow(LCD_INSTRUCTION_WRITE,LCD_CURSOR_OFF); /* cursor off */
 	
-	LCD_sendCommand(LCD_CLEAR_COMMAND); /* clear LCD at the beginning */
+	LCD_writeNow(LCD_INSTRUCTION_WRITE,LCD_CLEAR_COMMAND); /* clear LCD at the beginning */
+
+#if (LCD_QUEUE_ENABLE == TRUE)
+	Timer_setCallBack(LCD_tick,LCD_QUEUE_TIMER_ID);	/* The timer is started by the first write */
+#endif
 }
 
 /*
@@ -48,15 +337,11 @@ void LCD_init(void)
  */
 void LCD_sendCommand(uint8 command)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
-	GPIO_writePin(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW); /* write data to LCD so RW=0 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-	GPIO_writePort(LCD_DATA_PORT_ID,command); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
+#if (LCD_QUEUE_ENABLE == TRUE)
+	LCD_queueWrite(LCD_INSTRUCTION_WRITE,command);
+#else
+	LCD_writeNow(LCD_INSTRUCTION_WRITE,command);
+#endif
 }
 
 /*
@@ -65,15 +350,25 @@ void LCD_sendCommand(uint8 command)
  */
 void LCD_displayCharacter(uint8 data)
 {
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH); /* Data Mode RS=1 */
-	GPIO_writePin(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW); /* write data to LCD so RW=0 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-	GPIO_writePort(LCD_DATA_PORT_ID,data); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
+#if (LCD_QUEUE_ENABLE == TRUE)
+	LCD_queueWrite(LCD_DATA_WRITE,data);
+#else
+	LCD_writeNow(LCD_DATA_WRITE,data);
+#endif
+}
+
+/*
+ * Description :
+ * Wait until all the queued writes are done by the LCD (nothing to wait without the queue)
+ */
+void LCD_waitQueue(void)
+{
+#if (LCD_QUEUE_ENABLE == TRUE)
+	while(g_lcdQueueRunning == TRUE)
+	{
+		/* The timer ISR stops when the queue is empty and the LCD is ready */
+	}
+#endif
 }
 
 /*
@@ -90,6 +385,21 @@ void LCD_displayString(const char *Str)
 	}
 }
 
+/*
+ * Description :
+ * Display the required string, stored in flash (PROGMEM), on the screen
+ */
+void LCD_displayString_P(PGM_P Str)
+{
+	uint8 character = pgm_read_byte(Str);
+	while(character != '\0')
+	{
+		LCD_displayCharacter(character);
+		Str++;
+		character = pgm_read_byte(Str);
+	}
+}
+
 /*
  * Description :
  * Move the cursor to a specified row and column index on the screen
@@ -108,10 +418,10 @@ void LCD_moveCursor(uint8 row,uint8 col)
 			lcd_memory_address=col+0x40;
 				break;
 		case 2:
-			lcd_memory_address=col+0x10;
+			lcd_memory_address=col+LCD_COLUMNS;
 				break;
 		case 3:
-			lcd_memory_address=col+0x50;
+			lcd_memory_address=col+0x40+LCD_COLUMNS;
 				break;
 	}					
 	/* Move the LCD cursor to this specific address */
@@ -128,6 +438,17 @@ void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
 	LCD_displayString(Str); /* display the string */
 }
 
+/*
+ * Description :
+ * Display the required string, stored in flash (PROGMEM), in a specified row and column index
+ * on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col,PGM_P Str)
+{
+	LCD_moveCursor(row,col); /* go to to the required LCD position */
+	LCD_displayString_P(Str); /* display the string */
+}
+
 /*
  * Description :
  * Display the required decimal value on the screen
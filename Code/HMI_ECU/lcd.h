@@ -13,6 +13,7 @@
 #define LCD_H_
 
 #include "std_types.h"
+#include <avr/pgmspace.h> /* For the strings in flash */
 
 /*******************************************************************************
  *                                Definitions                                  *
@@ -27,8 +28,54 @@
 #define LCD_E_PORT_ID                  PORTA_ID
 #define LCD_E_PIN_ID                   PIN2_ID
 
+/* RS, RW and E are written together (one store), they must be on the same port */
+#define LCD_CONTROL_PORT_ID            LCD_RS_PORT_ID
+#define LCD_RS_RW_MASK                 ((1<<LCD_RS_PIN_ID) | (1<<LCD_RW_PIN_ID))
+#define LCD_CONTROL_MASK               (LCD_RS_RW_MASK | (1<<LCD_E_PIN_ID))
+#define LCD_INSTRUCTION_WRITE          0                    /* RS=0, RW=0 */
+#define LCD_DATA_WRITE                 (1<<LCD_RS_PIN_ID)   /* RS=1, RW=0 */
+#define LCD_INSTRUCTION_READ           (1<<LCD_RW_PIN_ID)   /* RS=0, RW=1 */
+
+/*
+ * Data bus: 8 bits (D0-D7 on the whole data port) or 4 bits (D4-D7 on 4 pins of the data port
+ * from LCD_FIRST_DATA_PIN_ID, the other pins are free for other uses)
+ */
+#define LCD_DATA_BITS_MODE             8
+
 #define LCD_DATA_PORT_ID               PORTC_ID
 
+#if (LCD_DATA_BITS_MODE == 4)
+#define LCD_FIRST_DATA_PIN_ID          PIN4_ID              /* D4 */
+#define LCD_DATA_MASK                  (0x0F<<LCD_FIRST_DATA_PIN_ID)
+#define LCD_BUSY_FLAG_PIN_ID           (LCD_FIRST_DATA_PIN_ID+3)    /* D7 */
+#elif (LCD_DATA_BITS_MODE == 8)
+#define LCD_DATA_MASK                  0xFF
+#define LCD_BUSY_FLAG_PIN_ID           PIN7_ID              /* D7 */
+#else
+#error "Number of Data bits should be equal to 4 or 8"
+#endif
+
+/*
+ * TRUE: the busy flag is read over RW before every write, the LCD is written as soon as it is
+ * ready. FALSE: the worst execution time of every instruction is waited (RW may be tied low).
+ */
+#define LCD_BUSY_FLAG_POLLING          TRUE
+
+/*
+ * TRUE: the commands and characters are queued and written by the compare ISR of
+ * LCD_QUEUE_TIMER_ID, one byte every LCD_TICK_PERIOD_US when the LCD is ready, the display
+ * functions return at once (they wait only when the queue is full). The timer runs only while
+ * there are queued writes. FALSE: every function waits for its writes.
+ */
+#define LCD_QUEUE_ENABLE               TRUE
+#define LCD_QUEUE_TIMER_ID             TIMER2
+#define LCD_QUEUE_SIZE                 32     /* Power of 2 */
+#define LCD_TICK_PERIOD_US             100
+
+/* LCD size (LM044L 4x20 of the simulation), rows 2 and 3 continue the DDRAM lines of rows 0 and 1 */
+#define LCD_ROWS                       4
+#define LCD_COLUMNS                    20
+
 /* LCD Commands */
 #define LCD_CLEAR_COMMAND              0x01
 #define LCD_GO_TO_HOME                 0x02
@@ -68,6 +115,12 @@ void LCD_displayCharacter(uint8 data);
  */
 void LCD_displayString(const char *Str);
 
+/*
+ * Description :
+ * Display the required string, stored in flash (PROGMEM), on the screen
+ */
+void LCD_displayString_P(PGM_P Str);
+
 /*
  * Description :
  * Move the cursor to a specified row and column index on the screen
@@ -80,6 +133,13 @@ void LCD_moveCursor(uint8 row,uint8 col);
  */
 void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str);
 
+/*
+ * Description :
+ * Display the required string, stored in flash (PROGMEM), in a specified row and column index
+ * on the screen
+ */
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col,PGM_P Str);
+
 /*
  * Description :
  * Display the required decimal value on the screen
@@ -92,4 +152,10 @@ void LCD_intgerToString(int data);
  */
 void LCD_clearScreen(void);
 
+/*
+ * Description :
+ * Wait until all the queued writes are done by the LCD (nothing to wait without the queue)
+ */
+void LCD_waitQueue(void);
+
 #endif /* LCD_H_ */
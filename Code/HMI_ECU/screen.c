@@ -0,0 +1,198 @@
+ /******************************************************************************
+ *
+ * [Module]: SCREEN
+ *
+ * [File Name]: screen.c
+ *
+ * [Description]: Source file for the shadow framebuffer of the LCD
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include "screen.h"
+#include "lcd.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SCREEN_BLANK                   ' '
+#define SCREEN_NO_CELL                 0xFF	/* Address of the LCD not known */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/* Cells drawn by the application, indexed by row * SCREEN_COLUMNS + column */
+static uint8 g_screenBuffer[SCREEN_CELLS];
+
+/* Cells displayed on the LCD */
+static uint8 g_screenShadow[SCREEN_CELLS];
+
+/* Cell of the framebuffer cursor */
+static uint8 g_screenCursor = 0;
+
+/* Set when the cursor is moved after the last character, the flush places the cursor of the LCD
+ * there (the next character, e.g. a typed key, then needs no cursor move) */
+static uint8 g_screenCursorMoved = FALSE;
+
+/* Cell at the address counter of the LCD (the next character goes there) */
+static uint8 g_lcdCell = SCREEN_NO_CELL;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the framebuffer of a cleared LCD (after LCD_init). From now on the LCD must be
+ * written through this module only.
+ */
+void SCREEN_init(void)
+{
+	uint8 cell;
+
+	for(cell = 0; cell < SCREEN_CELLS; cell++)
+	{
+		g_screenShadow[cell] = SCREEN_BLANK;
+	}
+	SCREEN_clear();
+	g_lcdCell = 0; /* The clear command returns the LCD address to 0 */
+}
+
+/*
+ * Description :
+ * Clear the framebuffer and move its cursor to the first cell (nothing is sent to the LCD)
+ */
+void SCREEN_clear(void)
+{
+	uint8 cell;
+
+	for(cell = 0; cell < SCREEN_CELLS; cell++)
+	{
+		g_screenBuffer[cell] = SCREEN_BLANK;
+	}
+	g_screenCursor = 0;
+	g_screenCursorMoved = FALSE;
+}
+
+/*
+ * Description :
+ * Move the cursor of the framebuffer to a specified row and column index
+ */
+void SCREEN_moveCursor(uint8 row,uint8 col)
+{
+	g_screenCursor = (row * SCREEN_COLUMNS) + col;
+	g_screenCursorMoved = TRUE;
+}
+
+/*
+ * Description :
+ * Write the character at the cursor of the framebuffer, the cursor goes to the next cell
+ * (the first cell of the next row after the last column)
+ */
+void SCREEN_displayCharacter(uint8 data)
+{
+	if(g_screenCursor >= SCREEN_CELLS)
+	{
+		g_screenCursor = 0; /* After the last cell of the last row */
+	}
+	g_screenBuffer[g_screenCursor] = data;
+	g_screenCursor++;
+	g_screenCursorMoved = FALSE;
+}
+
+/*
+ * Description :
+ * Write the string at the cursor of the framebuffer
+ */
+void SCREEN_displayString(const char *Str)
+{
+	uint8 i = 0;
+	while(Str[i] != '\0')
+	{
+		SCREEN_displayCharacter(Str[i]);
+		i++;
+	}
+}
+
+/*
+ * Description :
+ * Write the string, stored in flash (PROGMEM), at the cursor of the framebuffer
+ */
+void SCREEN_displayString_P(PGM_P Str)
+{
+	uint8 character = pgm_read_byte(Str);
+	while(character != '\0')
+	{
+		SCREEN_displayCharacter(character);
+		Str++;
+		character = pgm_read_byte(Str);
+	}
+}
+
+/*
+ * Description :
+ * Write the string in a specified row and column index of the framebuffer
+ */
+void SCREEN_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
+{
+	SCREEN_moveCursor(row,col); /* go to to the required position */
+	SCREEN_displayString(Str); /* write the string */
+}
+
+/*
+ * Description :
+ * Write the string, stored in flash (PROGMEM), in a specified row and column index of the
+ * framebuffer
+ */
+void SCREEN_displayStringRowColumn_P(uint8 row,uint8 col,PGM_P Str)
+{
+	SCREEN_moveCursor(row,col); /* go to to the required position */
+	SCREEN_displayString_P(Str); /* write the string */
+}
+
+/*
+ * Description :
+ * Send the cells changed since the last flush to the LCD, the cursor of the LCD is moved only
+ * when the next changed cell doesn't follow the last written one. A cursor moved after the last
+ * character (SCREEN_moveCursor) is placed on the LCD too, the characters written there next
+ * (one per flush) cost one LCD write each
+ */
+void SCREEN_flush(void)
+{
+	uint8 cell;
+	uint8 col = 0;
+	uint8 row = 0;
+
+	for(cell = 0; cell < SCREEN_CELLS; cell++)
+	{
+		if(g_screenBuffer[cell] != g_screenShadow[cell])
+		{
+			if(cell != g_lcdCell)
+			{
+				LCD_moveCursor(row,col);
+			}
+			LCD_displayCharacter(g_screenBuffer[cell]);
+			g_screenShadow[cell] = g_screenBuffer[cell];
+
+			/* The address counter of the LCD goes to the next column, not to the next row */
+			g_lcdCell = (col == (SCREEN_COLUMNS - 1)) ? SCREEN_NO_CELL : (cell + 1);
+		}
+
+		col++;
+		if(col == SCREEN_COLUMNS)
+		{
+			col = 0;
+			row++;
+		}
+	}
+
+	/* Place the cursor of the LCD at the cursor moved by the application */
+	if((g_screenCursorMoved == TRUE) && (g_screenCursor != g_lcdCell)
+			&& (g_screenCursor < SCREEN_CELLS))
+	{
+		LCD_moveCursor(g_screenCursor / SCREEN_COLUMNS, g_screenCursor % SCREEN_COLUMNS);
+		g_lcdCell = g_screenCursor;
+	}
+}
@@ -0,0 +1,91 @@
+ /******************************************************************************
+ *
+ * [Module]: SCREEN
+ *
+ * [File Name]: screen.h
+ *
+ * [Description]: Header file for the shadow framebuffer of the LCD. The application draws
+ * 				  in RAM, SCREEN_flush sends only the changed cells to the LCD.
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+#ifndef SCREEN_H_
+#define SCREEN_H_
+
+#include "std_types.h"
+#include "lcd.h"
+#include <avr/pgmspace.h> /* For the strings in flash */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SCREEN_ROWS                    LCD_ROWS
+#define SCREEN_COLUMNS                 LCD_COLUMNS
+#define SCREEN_CELLS                   (SCREEN_ROWS * SCREEN_COLUMNS)
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the framebuffer of a cleared LCD (after LCD_init). From now on the LCD must be
+ * written through this module only.
+ */
+void SCREEN_init(void);
+
+/*
+ * Description :
+ * Clear the framebuffer and move its cursor to the first cell (nothing is sent to the LCD)
+ */
+void SCREEN_clear(void);
+
+/*
+ * Description :
+ * Move the cursor of the framebuffer to a specified row and column index
+ */
+void SCREEN_moveCursor(uint8 row,uint8 col);
+
+/*
+ * Description :
+ * Write the character at the cursor of the framebuffer, the cursor goes to the next cell
+ * (the first cell of the next row after the last column)
+ */
+void SCREEN_displayCharacter(uint8 data);
+
+/*
+ * Description :
+ * Write the string at the cursor of the framebuffer
+ */
+void SCREEN_displayString(const char *Str);
+
+/*
+ * Description :
+ * Write the string, stored in flash (PROGMEM), at the cursor of the framebuffer
+ */
+void SCREEN_displayString_P(PGM_P Str);
+
+/*
+ * Description :
+ * Write the string in a specified row and column index of the framebuffer
+ */
+void SCREEN_displayStringRowColumn(uint8 row,uint8 col,const char *Str);
+
+/*
+ * Description :
+ * Write the string, stored in flash (PROGMEM), in a specified row and column index of the
+ * framebuffer
+ */
+void SCREEN_displayStringRowColumn_P(uint8 row,uint8 col,PGM_P Str);
+
+/*
+ * Description :
+ * Send the cells changed since the last flush to the LCD, the cursor of the LCD is moved only
+ * when the next changed cell doesn't follow the last written one. A cursor moved after the last
+ * character (SCREEN_moveCursor) is placed on the LCD too, the characters written there next
+ * (one per flush) cost one LCD write each
+ */
+void SCREEN_flush(void);
+
+#endif /* SCREEN_H_ */
@@ -15,26 +15,75 @@
 
 #include "timer.h"
 #include "common_macros.h"	/* To use the macros like SET_BIT */
-#include <avr/interrupt.h> /* For ICU ISR */
-#include <avr/io.h> /* To use Timer0, Timer1 and Timer2 Registers */
+#include "port.h" /* To use Timer0, Timer1 and Timer2 Registers and ISRs */
 
 /****************************************************************************************
  *                           		Global Variables                                    *
  ****************************************************************************************/
-/* Global variables to hold the address of the call back function in the application
- * for Timer0
- */
-static volatile void (*g_callBackPtrTimer0)(void) = NULL_PTR;
+/* Call backs of the subscribers of every hardware timer (indexed by TIMER_ID), called by its
+ * ISR in their subscription order. An entry is written before the count includes it. */
+#define TIMER_NUM_OF_TIMERS	3
+static void (*g_subscribers[TIMER_NUM_OF_TIMERS][TIMER_MAX_SUBSCRIBERS])(void);
+static volatile uint8 g_subscribersCount[TIMER_NUM_OF_TIMERS];
 
-/* Global variables to hold the address of the call back function in the application
- * for Timer1
- */
-static volatile void (*g_callBackPtrTimer1)(void) = NULL_PTR;
+/* Software timer wheel: the running timers of every slot, in a doubly linked list */
+#define TIMER_WHEEL_MASK	(TIMER_WHEEL_SIZE - 1)
+static Timer_SoftTimerType *g_wheelSlots[TIMER_WHEEL_SIZE];
 
-/* Global variables to hold the address of the call back function in the application
- * for Timer2
- */
-static volatile void (*g_callBackPtrTimer2)(void) = NULL_PTR;
+/* Slot of the current tick */
+static uint8 g_wheelSlot = 0;
+
+/* Expired timers waiting for Timer_dispatchSoftTimers, in their expiry order */
+static Timer_SoftTimerType *volatile g_expiredHead = NULL_PTR;
+static Timer_SoftTimerType *g_expiredTail = NULL_PTR;
+
+/* Tickless idle: counts of one tick of Timer1 (compare value + 1, 0: not in compare mode),
+ * ticks of its running period, ticks of this period given to the wheel already (catch up
+ * after a wake up) and ticks for the wheel at the end of the last period */
+static uint16 g_tickCounts = 0;
+static volatile uint16 g_periodTicks = 1;
+static volatile uint16 g_periodTicksDone = 0;
+static volatile uint16 g_ticksDue = 1;
+
+/* Monotonic clock of the Timer1 tick: ticks and milliseconds at the end of the last period and
+ * CPU cycles counted after these milliseconds. One tick is g_tickMillis milliseconds and
+ * g_tickCycles CPU cycles, one count of the counter is g_countCycles CPU cycles. */
+#define TIMER_CYCLES_PER_MS	((uint16)(F_CPU / 1000UL))
+static volatile uint32 g_clockTicks = 0;
+static volatile uint32 g_clockMillis = 0;
+static volatile uint16 g_clockCycles = 0;
+static uint16 g_tickMillis = 0;
+static uint16 g_tickCycles = 0;
+static uint16 g_countCycles = 0;
+
+/* CPU cycles of one count of the counter for every clock of Timer_Prescaler */
+static const uint16 g_prescalerCycles[] = {0, 1, 8, 64, 256, 1024};
+
+
+
+/****************************************************************************************
+ *                       		Private Functions                              			*
+ ****************************************************************************************/
+
+/********************************************************************************************
+ * [Function Name]: Timer_callSubscribers
+ *
+ * [Description]: Private Function to call the subscribers of a hardware timer from its ISR,
+ * 				  once per interrupt (once for all the ticks of a stretched Timer1 period).
+ *
+ ********************************************************************************************/
+static void Timer_callSubscribers(TIMER_ID a_timerID)
+{
+	void (**callBack_Ptr)(void) = g_subscribers[a_timerID];
+	uint8 count = g_subscribersCount[a_timerID];
+
+	while(count != 0)
+	{
+		(**callBack_Ptr)();
+		callBack_Ptr++;
+		count--;
+	}
+}
 
 
 
@@ -45,20 +94,14 @@ static volatile void (*g_callBackPtrTimer2)(void) = NULL_PTR;
 /*------------------------------------ Timer 0 ISR -------------------------------------*/
 ISR(TIMER0_OVF_vect)
 {
-	if(g_callBackPtrTimer0 != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the overflow has been done */
-		(*g_callBackPtrTimer0)();
-	}
+	/* Call the subscribers in the application after the overflow has been done */
+	Timer_callSubscribers(TIMER0);
 }
 
 ISR(TIMER0_COMP_vect)
 {
-	if(g_callBackPtrTimer0 != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the compare match has been occurred */
-		(*g_callBackPtrTimer0)();
-	}
+	/* Call the subscribers in the application after the compare match has been occurred */
+	Timer_callSubscribers(TIMER0);
 }
 
 
@@ -66,20 +109,37 @@ ISR(TIMER0_COMP_vect)
 
 ISR(TIMER1_OVF_vect)
 {
-	if(g_callBackPtrTimer1 != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the overflow has been done */
-		(g_callBackPtrTimer1)();
-	}
+	/* Call the subscribers in the application after the overflow has been done */
+	Timer_callSubscribers(TIMER1);
 }
 
 ISR(TIMER1_COMPA_vect)
 {
-	if(g_callBackPtrTimer1 != NULL_PTR)
+	uint32 cycles;
+
+	/* The clock counts all the ticks of the period */
+	g_clockTicks += g_periodTicks;
+	g_clockMillis += (uint32)g_periodTicks * g_tickMillis;
+	if(g_tickCycles != 0)
+	{
+		/* The tick is not a whole number of milliseconds */
+		cycles = g_clockCycles + ((uint32)g_periodTicks * g_tickCycles);
+		g_clockMillis += cycles / TIMER_CYCLES_PER_MS;
+		g_clockCycles = (uint16)(cycles % TIMER_CYCLES_PER_MS);
+	}
+
+	/* End of the period: a stretched one (tickless idle) gives its other ticks to the wheel
+	 * and the next period is one tick again */
+	g_ticksDue = g_periodTicks - g_periodTicksDone;
+	if(g_periodTicks != 1)
 	{
-		/* Call the Call Back function in the application after the compare match has been occurred */
-		(g_callBackPtrTimer1)();
+		OCR1A = g_tickCounts - 1;
+		g_periodTicks = 1;
 	}
+	g_periodTicksDone = 0;
+
+	/* Call the subscribers in the application after the compare match has been occurred */
+	Timer_callSubscribers(TIMER1);
 }
 
 
@@ -87,20 +147,14 @@ ISR(TIMER1_COMPA_vect)
 
 ISR(TIMER2_OVF_vect)
 {
-	if(g_callBackPtrTimer2 != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the overflow has been done */
-		(g_callBackPtrTimer2)();
-	}
+	/* Call the subscribers in the application after the overflow has been done */
+	Timer_callSubscribers(TIMER2);
 }
 
 ISR(TIMER2_COMP_vect)
 {
-	if(g_callBackPtrTimer2 != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the compare match has been occurred */
-		(g_callBackPtrTimer2)();
-	}
+	/* Call the subscribers in the application after the compare match has been occurred */
+	Timer_callSubscribers(TIMER2);
 }
 
 
@@ -218,6 +272,10 @@ void Timer_init(const Timer_ConfigType *Config_Ptr)
 			TCNT1 = (Config_Ptr->intialValue) & 0xFFFF;	/* In order to ensure that the register not exceeding his maximum value (255) */
 			OCR1A = (Config_Ptr->compareValue) & 0xFFFF;
 			TIMSK |= (1<<OCIE1A);
+			g_tickCounts = OCR1A + 1;	/* One tick of the tickless idle and of the clock */
+			g_countCycles = g_prescalerCycles[Config_Ptr->timer_Prescaler];
+			g_tickMillis = (uint16)(((uint32)g_tickCounts * g_countCycles) / TIMER_CYCLES_PER_MS);
+			g_tickCycles = (uint16)(((uint32)g_tickCounts * g_countCycles) % TIMER_CYCLES_PER_MS);
 		}	/* End of Timer 1 Compare Mode */
 		break;		/* End of Timer 1 */
 
@@ -270,11 +328,12 @@ void Timer_init(const Timer_ConfigType *Config_Ptr)
 /********************************************************************************************
  * [Function Name]: Timer_setCallBack
  *
- * [Description]: Function to set the Call Back function address.
+ * [Description]: Function to set the Call Back function address, it replaces all the
+ * 				  subscribers of the timer by this function called at every interrupt.
  *
  * [Arguments]:
  *
- * [in]: *a_ptr: Pointer to Function
+ * [in]: *a_ptr: Pointer to Function (NULL_PTR: no call back)
  * 		  a_timerID: Enum to Timer ID
  *
  * [out]: void
@@ -284,24 +343,51 @@ void Timer_init(const Timer_ConfigType *Config_Ptr)
  ********************************************************************************************/
 void Timer_setCallBack(void(*a_ptr)(void), TIMER_ID a_timerID)
 {
-	switch(a_timerID)
+	g_subscribersCount[a_timerID] = 0;	/* The ISR sees no subscriber from now on */
+	if(a_ptr != NULL_PTR)
 	{
-	/*---------------------------------------Timer 0--------------------------------------*/
-	case TIMER0:
-		/* Save the address of the Call back function in a global variable */
-		g_callBackPtrTimer0 = a_ptr;
-		break;
-	/*---------------------------------------Timer 1--------------------------------------*/
-	case TIMER1:
-		/* Save the address of the Call back function in a global variable */
-		g_callBackPtrTimer1 = a_ptr;
-		break;
-	/*---------------------------------------Timer 2--------------------------------------*/
-	case TIMER2:
-		/* Save the address of the Call back function in a global variable */
-		g_callBackPtrTimer2 = a_ptr;
-		break;
+		(void)Timer_subscribe(a_timerID, a_ptr);
+	}
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_subscribe
+ *
+ * [Description]: This Function adds a call back to the subscribers of a hardware timer, so
+ * 				  several modules share the timer: the call back is called from the ISR at
+ * 				  every interrupt, in the subscription order. With the tickless idle of Timer1
+ * 				  the calls of the skipped ticks are merged at the end of the stretched period
+ * 				  (deadlines and slower rates must use the software timers).
+ *
+ * [Arguments]:
+ *
+ * [in]: a_timerID: Enum to Timer ID
+ * 		  *a_ptr: Pointer to the call back function
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE, or FALSE when the timer has TIMER_MAX_SUBSCRIBERS subscribers already
+ *
+ ********************************************************************************************/
+uint8 Timer_subscribe(TIMER_ID a_timerID, void(*a_ptr)(void))
+{
+	uint8 subscribed = FALSE;
+	uint8 count;
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	count = g_subscribersCount[a_timerID];
+	if(count < TIMER_MAX_SUBSCRIBERS)
+	{
+		g_subscribers[a_timerID][count] = a_ptr;
+		g_subscribersCount[a_timerID] = count + 1;
+		subscribed = TRUE;
 	}
+	PORT_EXIT_CRITICAL(sreg);
+
+	return subscribed;
 }
 
 
@@ -332,12 +418,12 @@ void Timer_stop(const TIMER_ID a_timerID)
 	/*---------------------------------------Timer 1--------------------------------------*/
 	case TIMER1:
 		/* Clear the bits of the clock in TIMER1 */
-		TCCR1B = TCCR0 & 0xF8;
+		TCCR1B = TCCR1B & 0xF8;
 		break;
 	/*---------------------------------------Timer 2--------------------------------------*/
 	case TIMER2:
 		/* Clear the bits of the clock in TIMER2 */
-		TCCR2 = TCCR0 & 0xF8;
+		TCCR2 = TCCR2 & 0xF8;
 		break;
 	}
 }
@@ -382,6 +468,9 @@ void Timer_DeInit(const TIMER_ID a_timerID)
 		OCR1A = 0;
 		TCCR1A = 0;
 		TCCR1B = 0;
+		g_tickCounts = 0;	/* The clock stops, it keeps its time */
+		g_periodTicks = 1;
+		g_periodTicksDone = 0;
 
 		/* Disable the Timer 1 interrupt */
 		TIMSK &= ~(1<<OCIE1A) & ~(1<<TOIE1);
@@ -392,10 +481,9 @@ void Timer_DeInit(const TIMER_ID a_timerID)
 	/*---------------------------------------Timer 2--------------------------------------*/
 	case TIMER2:
 		/* Clear All Timer 2 Registers */
-		TCNT1 = 0;
-		OCR1A = 0;
-		TCCR1A = 0;
-		TCCR1B = 0;
+		TCNT2 = 0;
+		OCR2 = 0;
+		TCCR2 = 0;
 
 		/* Disable the Timer 2 interrupt */
 		TIMSK &= ~(1<<OCIE2) & ~(1<<TOIE2);
@@ -405,3 +493,643 @@ void Timer_DeInit(const TIMER_ID a_timerID)
 		break;
 	}
 }
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_linkSoftTimer
+ *
+ * [Description]: Private Function to put a software timer in the wheel slot of its expiry,
+ * 				  a_ticks ticks later (interrupts disabled).
+ *
+ ********************************************************************************************/
+static void Timer_linkSoftTimer(Timer_SoftTimerType *Timer_Ptr, uint16 a_ticks)
+{
+	/* The slot is visited every TIMER_WHEEL_SIZE ticks, the first visit after the current one
+	 * is the ((a_ticks - 1) % TIMER_WHEEL_SIZE + 1)th tick */
+	Timer_Ptr->slot = (uint8)((g_wheelSlot + a_ticks) & TIMER_WHEEL_MASK);
+	Timer_Ptr->rounds = (a_ticks - 1) / TIMER_WHEEL_SIZE;
+	Timer_Ptr->prev_Ptr = NULL_PTR;
+	Timer_Ptr->next_Ptr = g_wheelSlots[Timer_Ptr->slot];
+	if(Timer_Ptr->next_Ptr != NULL_PTR)
+	{
+		Timer_Ptr->next_Ptr->prev_Ptr = Timer_Ptr;
+	}
+	g_wheelSlots[Timer_Ptr->slot] = Timer_Ptr;
+	Timer_Ptr->armed = TRUE;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_unlinkSoftTimer
+ *
+ * [Description]: Private Function to take a running software timer out of its wheel slot
+ * 				  (interrupts disabled).
+ *
+ ********************************************************************************************/
+static void Timer_unlinkSoftTimer(Timer_SoftTimerType *Timer_Ptr)
+{
+	if(Timer_Ptr->prev_Ptr != NULL_PTR)
+	{
+		Timer_Ptr->prev_Ptr->next_Ptr = Timer_Ptr->next_Ptr;
+	}
+	else
+	{
+		g_wheelSlots[Timer_Ptr->slot] = Timer_Ptr->next_Ptr;
+	}
+	if(Timer_Ptr->next_Ptr != NULL_PTR)
+	{
+		Timer_Ptr->next_Ptr->prev_Ptr = Timer_Ptr->prev_Ptr;
+	}
+	Timer_Ptr->armed = FALSE;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_unlinkExpired
+ *
+ * [Description]: Private Function to take an expired software timer out of the timers waiting
+ * 				  for their call back (interrupts disabled).
+ *
+ ********************************************************************************************/
+static void Timer_unlinkExpired(Timer_SoftTimerType *Timer_Ptr)
+{
+	if(Timer_Ptr->prevExpired_Ptr != NULL_PTR)
+	{
+		Timer_Ptr->prevExpired_Ptr->nextExpired_Ptr = Timer_Ptr->nextExpired_Ptr;
+	}
+	else
+	{
+		g_expiredHead = Timer_Ptr->nextExpired_Ptr;
+	}
+	if(Timer_Ptr->nextExpired_Ptr != NULL_PTR)
+	{
+		Timer_Ptr->nextExpired_Ptr->prevExpired_Ptr = Timer_Ptr->prevExpired_Ptr;
+	}
+	else
+	{
+		g_expiredTail = Timer_Ptr->prevExpired_Ptr;
+	}
+	Timer_Ptr->expired = FALSE;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_stopSoftTimer
+ *
+ * [Description]: Private Function to stop a software timer and drop its waiting call back
+ * 				  (interrupts disabled).
+ *
+ ********************************************************************************************/
+static void Timer_stopSoftTimer(Timer_SoftTimerType *Timer_Ptr)
+{
+	if(Timer_Ptr->armed == TRUE)
+	{
+		Timer_unlinkSoftTimer(Timer_Ptr);
+	}
+	if(Timer_Ptr->expired == TRUE)
+	{
+		Timer_unlinkExpired(Timer_Ptr);
+	}
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_advanceWheel
+ *
+ * [Description]: Private Function to advance the timer wheel by one tick: the expired timers
+ * 				  are queued for Timer_dispatchSoftTimers (interrupts disabled).
+ *
+ ********************************************************************************************/
+static void Timer_advanceWheel(void)
+{
+	Timer_SoftTimerType *timer_Ptr;
+	Timer_SoftTimerType *next_Ptr;
+
+	g_wheelSlot = (g_wheelSlot + 1) & TIMER_WHEEL_MASK;
+
+	timer_Ptr = g_wheelSlots[g_wheelSlot];
+	while(timer_Ptr != NULL_PTR)
+	{
+		/* Saved first: an expired timer leaves the list (a periodic one may come back at its
+		 * head, it is not visited again in this tick) */
+		next_Ptr = timer_Ptr->next_Ptr;
+
+		if(timer_Ptr->rounds != 0)
+		{
+			timer_Ptr->rounds--;	/* Expires in a next turn of the wheel */
+		}
+		else
+		{
+			/* Expired: out of the wheel, back in it for the next period */
+			Timer_unlinkSoftTimer(timer_Ptr);
+			if(timer_Ptr->period != 0)
+			{
+				Timer_linkSoftTimer(timer_Ptr, timer_Ptr->period);
+			}
+
+			/* Queue the call back (once, if the previous expiry is not dispatched yet) */
+			if((timer_Ptr->callBack_Ptr != NULL_PTR) && (timer_Ptr->expired == FALSE))
+			{
+				timer_Ptr->nextExpired_Ptr = NULL_PTR;
+				timer_Ptr->prevExpired_Ptr = g_expiredTail;
+				if(g_expiredTail != NULL_PTR)
+				{
+					g_expiredTail->nextExpired_Ptr = timer_Ptr;
+				}
+				else
+				{
+					g_expiredHead = timer_Ptr;
+				}
+				g_expiredTail = timer_Ptr;
+				timer_Ptr->expired = TRUE;
+			}
+		}
+
+		timer_Ptr = next_Ptr;
+	}
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getFirstExpiry
+ *
+ * [Description]: Private Function to find the ticks left before the first expiry of the
+ * 				  running software timers, 0xFFFF if none is running (interrupts disabled).
+ *
+ ********************************************************************************************/
+static uint16 Timer_getFirstExpiry(void)
+{
+	const Timer_SoftTimerType *timer_Ptr;
+	uint16 first = 0xFFFF;
+	uint16 ticks;
+	uint8 slot;
+
+	for(slot = 0; slot < TIMER_WHEEL_SIZE; slot++)
+	{
+		for(timer_Ptr = g_wheelSlots[slot]; timer_Ptr != NULL_PTR; timer_Ptr = timer_Ptr->next_Ptr)
+		{
+			/* Ticks to the next visit of the slot plus the full turns */
+			ticks = ((slot - g_wheelSlot - 1) & TIMER_WHEEL_MASK) + 1
+					+ (timer_Ptr->rounds * TIMER_WHEEL_SIZE);
+			if(ticks < first)
+			{
+				first = ticks;
+			}
+		}
+	}
+	return first;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getPeriodCounts
+ *
+ * [Description]: Private Function to read the counts of Timer1 since the start of its running
+ * 				  period, with the period ended but not counted by its ISR yet (interrupts
+ * 				  disabled).
+ *
+ ********************************************************************************************/
+static uint32 Timer_getPeriodCounts(void)
+{
+	uint32 counts = TCNT1;
+
+	if(BIT_IS_SET(TIFR,OCF1A))
+	{
+		/* The counter restarted (read again, it may restart after the first read), the ISR
+		 * waits for the end of the critical section */
+		counts = (uint32)OCR1A + 1 + TCNT1;
+	}
+	return counts;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_startSoftTimer
+ *
+ * [Description]: This Function starts (or restarts) a software timer of the timer wheel in
+ * 				  O(1). The call back is called by Timer_dispatchSoftTimers, out of the ISR,
+ * 				  after a_ticks ticks then every a_period ticks for a periodic timer.
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ * 		  a_ticks: Ticks before the first expiry (0 is taken as 1)
+ * 		  a_period: Ticks between the next expiries, 0 for a one-shot timer
+ * 		  *a_ptr: Pointer to the call back function (NULL_PTR: no call back, the timer is only
+ * 		  		  polled with Timer_isSoftTimerActive)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_startSoftTimer(Timer_SoftTimerType *Timer_Ptr, uint16 a_ticks, uint16 a_period,
+		void(*a_ptr)(void))
+{
+	uint8 sreg;
+
+	if(a_ticks == 0)
+	{
+		a_ticks = 1;	/* The earliest expiry is the next tick */
+	}
+
+	PORT_ENTER_CRITICAL(sreg);
+	Timer_stopSoftTimer(Timer_Ptr);
+	Timer_Ptr->callBack_Ptr = a_ptr;
+	Timer_Ptr->period = a_period;
+	Timer_linkSoftTimer(Timer_Ptr, a_ticks);
+	PORT_EXIT_CRITICAL(sreg);
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_cancelSoftTimer
+ *
+ * [Description]: This Function stops a software timer in O(1), its waiting call back (expiry
+ * 				  not dispatched yet) is dropped too.
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_cancelSoftTimer(Timer_SoftTimerType *Timer_Ptr)
+{
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	Timer_stopSoftTimer(Timer_Ptr);
+	PORT_EXIT_CRITICAL(sreg);
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_isSoftTimerActive
+ *
+ * [Description]: This Function checks if a software timer is running or if its call back
+ * 				  is waiting to be dispatched.
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE or FALSE
+ *
+ ********************************************************************************************/
+uint8 Timer_isSoftTimerActive(const Timer_SoftTimerType *Timer_Ptr)
+{
+	uint8 active;
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	active = ((Timer_Ptr->armed == TRUE) || (Timer_Ptr->expired == TRUE)) ? TRUE : FALSE;
+	PORT_EXIT_CRITICAL(sreg);
+	return active;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getSoftTimerRemaining
+ *
+ * [Description]: This Function returns the ticks left before the next expiry of a software
+ * 				  timer (0 when it is not running).
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ *
+ * [out]: void
+ *
+ * [Returns]: Remaining ticks
+ *
+ ********************************************************************************************/
+uint16 Timer_getSoftTimerRemaining(const Timer_SoftTimerType *Timer_Ptr)
+{
+	uint16 remaining = 0;
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	if(Timer_Ptr->armed == TRUE)
+	{
+		/* Ticks to the next visit of the slot (1 to TIMER_WHEEL_SIZE) plus the full turns */
+		remaining = ((Timer_Ptr->slot - g_wheelSlot - 1) & TIMER_WHEEL_MASK) + 1
+				+ (Timer_Ptr->rounds * TIMER_WHEEL_SIZE);
+	}
+	PORT_EXIT_CRITICAL(sreg);
+	return remaining;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_tickSoftTimers
+ *
+ * [Description]: This Function advances the timer wheel by one tick, it is called by the
+ * 				  application from the call back of its periodic hardware timer (ISR). The
+ * 				  expired timers are queued for Timer_dispatchSoftTimers, the periodic ones
+ * 				  are started again without drift.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if call backs are waiting for Timer_dispatchSoftTimers, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 Timer_tickSoftTimers(void)
+{
+	uint16 ticks = g_ticksDue;
+
+	/* One tick, or the ticks left of a stretched Timer1 period */
+	g_ticksDue = 1;
+	while(ticks != 0)
+	{
+		Timer_advanceWheel();
+		ticks--;
+	}
+
+	return (g_expiredHead != NULL_PTR) ? TRUE : FALSE;
+}
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_dispatchSoftTimers
+ *
+ * [Description]: This Function calls the call backs of the expired software timers in their
+ * 				  expiry order, it is called by the application from its main loop (out of
+ * 				  the ISR). The expiries of a periodic timer not dispatched yet are merged.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_dispatchSoftTimers(void)
+{
+	Timer_SoftTimerType *timer_Ptr;
+	void (*callBack_Ptr)(void) = NULL_PTR;
+	uint8 sreg;
+
+	do
+	{
+		/* Take the first expired timer, the ISR may add others meanwhile */
+		PORT_ENTER_CRITICAL(sreg);
+		timer_Ptr = g_expiredHead;
+		if(timer_Ptr != NULL_PTR)
+		{
+			callBack_Ptr = timer_Ptr->callBack_Ptr;
+			Timer_unlinkExpired(timer_Ptr);	/* A periodic timer stays in the wheel */
+		}
+		PORT_EXIT_CRITICAL(sreg);
+
+		if(timer_Ptr != NULL_PTR)
+		{
+			(*callBack_Ptr)();	/* The call back may start or cancel any timer */
+		}
+	}while(timer_Ptr != NULL_PTR);
+}
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_startTickless
+ *
+ * [Description]: This Function stretches the running one tick period of Timer1 up to the first
+ * 				  expiry of the software timers (at most the range of the counter), the ticks
+ * 				  between are skipped. It is called with the interrupts disabled just before
+ * 				  the CPU sleeps, Timer1 must be the tick of the software timers in compare
+ * 				  mode.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_startTickless(void)
+{
+	uint16 ticks;
+	uint16 maxTicks;
+
+	/* A one tick period of the tick timer only, its end is not waiting for the ISR */
+	if((g_tickCounts == 0) || (g_periodTicks != 1) || BIT_IS_SET(TIFR,OCF1A))
+	{
+		return;
+	}
+
+	/* The period ends with the tick of the first expiry (the wheel is at the last tick) */
+	ticks = Timer_getFirstExpiry();
+	maxTicks = (uint16)(0x10000UL / g_tickCounts);
+	if(ticks > maxTicks)
+	{
+		ticks = maxTicks;
+	}
+
+	if(ticks > 1)
+	{
+		g_periodTicks = ticks;
+		OCR1A = (uint16)(((uint32)ticks * g_tickCounts) - 1);
+	}
+}
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_stopTickless
+ *
+ * [Description]: This Function ends a Timer1 period stretched by Timer_startTickless at the
+ * 				  next tick, it is called after the wake up: the software timers catch up with
+ * 				  the ticks passed, so the timers started next count from the right time.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_stopTickless(void)
+{
+	uint16 counter;
+	uint16 elapsed;
+	uint16 end;
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	/* Woken up by the end of the period itself: its ISR gives the ticks to the wheel */
+	if((g_periodTicks != 1) && BIT_IS_CLEAR(TIFR,OCF1A))
+	{
+		counter = TCNT1;
+		elapsed = counter / g_tickCounts;	/* Whole ticks of the period passed */
+
+		/* The period ends at the next tick, or at the tick after it when the counter would
+		 * pass the compare value before it is written */
+		end = elapsed + 1;
+		if((((uint32)end * g_tickCounts) - counter) < TIMER_TICKLESS_MIN_COUNTS)
+		{
+			end++;
+		}
+		if(end < g_periodTicks)
+		{
+			g_periodTicks = end;
+			OCR1A = (uint16)(((uint32)end * g_tickCounts) - 1);
+		}
+
+		/* No timer expires before the end of the stretched period */
+		while(g_periodTicksDone < elapsed)
+		{
+			Timer_advanceWheel();
+			g_periodTicksDone++;
+		}
+	}
+	PORT_EXIT_CRITICAL(sreg);
+}
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getTicks
+ *
+ * [Description]: This Function returns the ticks of Timer1 (compare mode, the tick of the
+ * 				  software timers) since Timer_init, the ticks skipped by the tickless idle
+ * 				  included. The 32-bit value wraps around, the difference of two values
+ * 				  (unsigned) is right across the wrap.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: Ticks of the monotonic clock
+ *
+ ********************************************************************************************/
+uint32 Timer_getTicks(void)
+{
+	uint32 ticks;
+	uint32 counts = 0;
+	uint16 tickCounts;
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	ticks = g_clockTicks;
+	tickCounts = g_tickCounts;
+	if(tickCounts != 0)
+	{
+		counts = Timer_getPeriodCounts();
+	}
+	PORT_EXIT_CRITICAL(sreg);
+
+	/* Whole ticks passed in the running period (a stretched one counts several ticks) */
+	if(tickCounts != 0)
+	{
+		ticks += counts / tickCounts;
+	}
+	return ticks;
+}
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getMillis
+ *
+ * [Description]: This Function returns the milliseconds of the monotonic clock of
+ * 				  Timer_getTicks, the counter of Timer1 gives the milliseconds passed in the
+ * 				  running tick. The 32-bit value wraps around after 49.7 days, the difference
+ * 				  of two values (unsigned) is right across the wrap.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: Milliseconds of the monotonic clock
+ *
+ ********************************************************************************************/
+uint32 Timer_getMillis(void)
+{
+	uint32 millis;
+	uint32 cycles;
+	uint8 sreg;
+
+	PORT_ENTER_CRITICAL(sreg);
+	millis = g_clockMillis;
+	cycles = g_clockCycles;
+	if(g_tickCounts != 0)
+	{
+		cycles += Timer_getPeriodCounts() * g_countCycles;
+	}
+	PORT_EXIT_CRITICAL(sreg);
+
+	return millis + (cycles / TIMER_CYCLES_PER_MS);
+}
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getTickStamp
+ *
+ * [Description]: This Function returns a time stamp of the monotonic clock of Timer_getTicks
+ * 				  fast enough for the ISRs (no division): the ticks at the start of the running
+ * 				  Timer1 period and the counts of the counter since this start (more than one
+ * 				  tick in a stretched period). It is called with the interrupts disabled.
+ *
+ * [Arguments]:
+ *
+ * [in]: void
+ *
+ * [out]: *a_counts_Ptr: Counts of Timer1 since the start of the running period
+ *
+ * [Returns]: Ticks of the monotonic clock at the start of the running period
+ *
+ ********************************************************************************************/
+uint32 Timer_getTickStamp(uint16 *a_counts_Ptr)
+{
+	uint32 ticks = g_clockTicks;
+
+	*a_counts_Ptr = TCNT1;
+	if(BIT_IS_SET(TIFR,OCF1A))
+	{
+		/* The period ended (read the counter again, it may restart after the first read), its
+		 * ISR waits for the end of the critical section */
+		ticks += g_periodTicks;
+		*a_counts_Ptr = TCNT1;
+	}
+	return ticks;
+}
@@ -18,6 +18,27 @@
 
 #include "std_types.h"
 
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/*
+ * Slots of the software timer wheel (power of 2). A software timer is started and cancelled in
+ * O(1), every tick walks the timers of one slot only (a longer timer waits some turns of the
+ * wheel in its slot).
+ */
+#define TIMER_WHEEL_SIZE			16
+
+/*
+ * Tickless idle: a Timer1 period (compare mode, the tick of the software timers) is stretched
+ * up to the first software timer expiry while the CPU sleeps, up to the range of the 16-bit
+ * counter. The wake up by another interrupt ends it at the next tick, if the counter is this
+ * close to the end of the tick the period ends at the tick after it.
+ */
+#define TIMER_TICKLESS_MIN_COUNTS	4
+
+/* Subscribers of one hardware timer (Timer_subscribe), all called at every interrupt */
+#define TIMER_MAX_SUBSCRIBERS		4
+
 /*******************************************************************************
  *                         Types Declaration                                   *
  *******************************************************************************/
@@ -41,6 +62,23 @@ typedef struct{
 	Timer_Prescaler timer_Prescaler;
 }Timer_ConfigType;
 
+/*
+ * Software timer, the application owns it (static storage: zero initialized, not running).
+ * The fields are written by the Timer driver only.
+ */
+typedef struct Timer_SoftTimer{
+	struct Timer_SoftTimer *next_Ptr;			/* Timers of the same wheel slot */
+	struct Timer_SoftTimer *prev_Ptr;
+	struct Timer_SoftTimer *nextExpired_Ptr;	/* Timers waiting for their call back */
+	struct Timer_SoftTimer *prevExpired_Ptr;
+	void (*callBack_Ptr)(void);
+	uint16 period;		/* Ticks between two expiries, 0: one-shot timer */
+	uint16 rounds;		/* Turns of the wheel before the expiry */
+	uint8 slot;			/* Wheel slot of the expiry */
+	uint8 armed;		/* TRUE while the timer is in the wheel */
+	uint8 expired;		/* TRUE while the call back waits for Timer_dispatchSoftTimers */
+}Timer_SoftTimerType;
+
 
 
 /*******************************************************************************
@@ -74,11 +112,12 @@ void Timer_init(const Timer_ConfigType *Config_Ptr);
 /********************************************************************************************
  * [Function Name]: Timer_setCallBack
  *
- * [Description]: Function to set the Call Back function address.
+ * [Description]: Function to set the Call Back function address, it replaces all the
+ * 				  subscribers of the timer by this function called at every interrupt.
  *
  * [Arguments]:
  *
- * [in]: *a_ptr: Pointer to Function
+ * [in]: *a_ptr: Pointer to Function (NULL_PTR: no call back)
  * 		  a_timerID: Enum to Timer ID
  *
  * [out]: void
@@ -91,6 +130,30 @@ void Timer_setCallBack(void(*a_ptr)(void), TIMER_ID a_timerID);
 
 
 
+/********************************************************************************************
+ * [Function Name]: Timer_subscribe
+ *
+ * [Description]: This Function adds a call back to the subscribers of a hardware timer, so
+ * 				  several modules share the timer: the call back is called from the ISR at
+ * 				  every interrupt, in the subscription order. With the tickless idle of Timer1
+ * 				  the calls of the skipped ticks are merged at the end of the stretched period
+ * 				  (deadlines and slower rates must use the software timers).
+ *
+ * [Arguments]:
+ *
+ * [in]: a_timerID: Enum to Timer ID
+ * 		  *a_ptr: Pointer to the call back function
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE, or FALSE when the timer has TIMER_MAX_SUBSCRIBERS subscribers already
+ *
+ ********************************************************************************************/
+uint8 Timer_subscribe(TIMER_ID a_timerID, void(*a_ptr)(void));
+
+
+
+
 /********************************************************************************************
  * [Function Name]: Timer_stop
  *
@@ -127,4 +190,243 @@ void Timer_stop(const TIMER_ID a_timerID);
 void Timer_DeInit(const TIMER_ID a_timerID);
 
 
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_startSoftTimer
+ *
+ * [Description]: This Function starts (or restarts) a software timer of the timer wheel in
+ * 				  O(1). The call back is called by Timer_dispatchSoftTimers, out of the ISR,
+ * 				  after a_ticks ticks then every a_period ticks for a periodic timer.
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ * 		  a_ticks: Ticks before the first expiry (0 is taken as 1)
+ * 		  a_period: Ticks between the next expiries, 0 for a one-shot timer
+ * 		  *a_ptr: Pointer to the call back function (NULL_PTR: no call back, the timer is only
+ * 		  		  polled with Timer_isSoftTimerActive)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_startSoftTimer(Timer_SoftTimerType *Timer_Ptr, uint16 a_ticks, uint16 a_period,
+		void(*a_ptr)(void));
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_cancelSoftTimer
+ *
+ * [Description]: This Function stops a software timer in O(1), its waiting call back (expiry
+ * 				  not dispatched yet) is dropped too.
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_cancelSoftTimer(Timer_SoftTimerType *Timer_Ptr);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_isSoftTimerActive
+ *
+ * [Description]: This Function checks if a software timer is running or if its call back
+ * 				  is waiting to be dispatched.
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE or FALSE
+ *
+ ********************************************************************************************/
+uint8 Timer_isSoftTimerActive(const Timer_SoftTimerType *Timer_Ptr);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getSoftTimerRemaining
+ *
+ * [Description]: This Function returns the ticks left before the next expiry of a software
+ * 				  timer (0 when it is not running).
+ *
+ * [Arguments]:
+ *
+ * [in]: *Timer_Ptr: Pointer to the software timer
+ *
+ * [out]: void
+ *
+ * [Returns]: Remaining ticks
+ *
+ ********************************************************************************************/
+uint16 Timer_getSoftTimerRemaining(const Timer_SoftTimerType *Timer_Ptr);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_tickSoftTimers
+ *
+ * [Description]: This Function advances the timer wheel by one tick, it is called by the
+ * 				  application from the call back of its periodic hardware timer (ISR). The
+ * 				  expired timers are queued for Timer_dispatchSoftTimers, the periodic ones
+ * 				  are started again without drift. At the end of a Timer1 period stretched by
+ * 				  Timer_startTickless, the wheel advances by the ticks of the period.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if call backs are waiting for Timer_dispatchSoftTimers, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 Timer_tickSoftTimers(void);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_dispatchSoftTimers
+ *
+ * [Description]: This Function calls the call backs of the expired software timers in their
+ * 				  expiry order, it is called by the application from its main loop (out of
+ * 				  the ISR). The expiries of a periodic timer not dispatched yet are merged.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_dispatchSoftTimers(void);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_startTickless
+ *
+ * [Description]: This Function stretches the running one tick period of Timer1 up to the first
+ * 				  expiry of the software timers (at most the range of the counter), the ticks
+ * 				  between are skipped. It is called with the interrupts disabled just before
+ * 				  the CPU sleeps, Timer1 must be the tick of the software timers in compare
+ * 				  mode.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_startTickless(void);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_stopTickless
+ *
+ * [Description]: This Function ends a Timer1 period stretched by Timer_startTickless at the
+ * 				  next tick, it is called after the wake up: the software timers catch up with
+ * 				  the ticks passed, so the timers started next count from the right time.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void Timer_stopTickless(void);
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getTicks
+ *
+ * [Description]: This Function returns the ticks of Timer1 (compare mode, the tick of the
+ * 				  software timers) since Timer_init, the ticks skipped by the tickless idle
+ * 				  included. The 32-bit value wraps around, the difference of two values
+ * 				  (unsigned) is right across the wrap.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: Ticks of the monotonic clock
+ *
+ ********************************************************************************************/
+uint32 Timer_getTicks(void);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getMillis
+ *
+ * [Description]: This Function returns the milliseconds of the monotonic clock of
+ * 				  Timer_getTicks, the counter of Timer1 gives the milliseconds passed in the
+ * 				  running tick. The 32-bit value wraps around after 49.7 days, the difference
+ * 				  of two values (unsigned) is right across the wrap.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: Milliseconds of the monotonic clock
+ *
+ ********************************************************************************************/
+uint32 Timer_getMillis(void);
+
+
+
+
+/********************************************************************************************
+ * [Function Name]: Timer_getTickStamp
+ *
+ * [Description]: This Function returns a time stamp of the monotonic clock of Timer_getTicks
+ * 				  fast enough for the ISRs (no division): the ticks at the start of the running
+ * 				  Timer1 period and the counts of the counter since this start (more than one
+ * 				  tick in a stretched period). It is called with the interrupts disabled.
+ *
+ * [Arguments]:
+ *
+ * [in]: void
+ *
+ * [out]: *a_counts_Ptr: Counts of Timer1 since the start of the running period
+ *
+ * [Returns]: Ticks of the monotonic clock at the start of the running period
+ *
+ ********************************************************************************************/
+uint32 Timer_getTickStamp(uint16 *a_counts_Ptr);
+
+
 #endif /* TIMER_H_ */
@@ -11,8 +11,472 @@
  *******************************************************************************/
 
 #include "uart.h"
-#include "avr/io.h" /* To use the UART Registers */
+#include "frame.h" /* To use the frame format and the CRC-8 */
+#include "port.h" /* To use the UART Registers and ISRs */
 #include "common_macros.h" /* To use the macros like SET_BIT */
+#if (UART_TRACE_ENABLE == TRUE)
+#include "timer.h" /* To use the time stamp of the trace records */
+#endif
+
+/*******************************************************************************
+ *                           Private Macros                                    *
+ *******************************************************************************/
+
+/*
+ * Put a new byte in UDR after clearing the TXC flag (by writing one to it), so UART_flush
+ * can know when the last byte is shifted out.
+ * FE, DOR and PE must be written zero, U2X and MPCM keep their values.
+ */
+#define UART_WRITE_UDR(DATA)	do{ \
+									PORT_WRITE_REG(UCSRA, (UCSRA & ((1<<U2X) | (1<<MPCM))) | (1<<TXC)); \
+									g_txUsed = TRUE; \
+									PORT_WRITE_REG(UDR, DATA); \
+									UART_TRACE_RECORD(UART_TRACE_TX, DATA); \
+								}while(0)
+
+#if (UART_TRACE_ENABLE == TRUE)
+#define UART_TRACE_RECORD(DIRECTION,DATA)	UART_traceRecord((DIRECTION), (DATA))
+#else
+#define UART_TRACE_RECORD(DIRECTION,DATA)
+#endif
+
+/* Number of trace records sent in one trace data frame */
+#define UART_TRACE_RECORDS_PER_FRAME	(FRAME_MAX_PAYLOAD_LENGTH / 4)
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/* One flag bit for each location of the TX buffer: the byte is an address byte (9th bit) */
+#define UART_TX_ADDRESS_FLAGS_SIZE		((UART_TX_BUFFER_SIZE + 7) / 8)
+#define UART_TX_IS_ADDRESS(INDEX)		BIT_IS_SET(g_txAddressFlags[(INDEX) >> 3], (INDEX) & 7)
+#endif
+
+/*******************************************************************************
+ *                           Private Types                                     *
+ *******************************************************************************/
+typedef enum{
+	UART_FRAME_IDLE,			/* No frame is required, bytes go to the RX buffer */
+	UART_FRAME_WAIT_START,
+	UART_FRAME_WAIT_TYPE,
+	UART_FRAME_WAIT_LENGTH,
+	UART_FRAME_WAIT_PAYLOAD,
+	UART_FRAME_WAIT_CRC,
+	UART_FRAME_RECEIVED			/* Valid frame in the caller buffer, bytes go to the RX buffer */
+}UART_FrameStateType;
+
+/*******************************************************************************
+ *                           Private Variables                                 *
+ *******************************************************************************/
+
+/* The baud rate in use */
+static uint32 g_baudRate = UART_DEFAULT_BAUD_RATE;
+
+/* Set when the first byte is written in UDR, TXC is meaningless before it */
+static volatile uint8 g_txUsed = FALSE;
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/* Set by the TXC ISR (it clears the TXC flag UART_flush can't wait on), cleared by the UDRE
+ * ISR with every byte written in UDR */
+static volatile uint8 g_txDone = TRUE;
+#endif
+
+/* Time in ms, advanced by UART_tick */
+static volatile uint16 g_time = 0;
+
+/* Frame receive (UART_receiveFrameInto) state, written by the RX ISR while receiving */
+static volatile UART_FrameStateType g_frameState = UART_FRAME_IDLE;
+static uint8 *g_frameBuffer_Ptr = NULL_PTR;
+static UART_FrameCallBackType g_frameCallBack_Ptr = NULL_PTR;
+static uint8 g_frameMaxLength = 0;
+static volatile uint8 g_frameType = 0;
+static volatile uint8 g_frameLength = 0;
+static uint8 g_frameIndex = 0;
+static uint8 g_frameCrc = 0;
+static uint16 g_frameByteTime = 0;	/* Time of the last byte of the frame in progress */
+
+/* Line errors in a row (framing, overrun, frame CRC), cleared by a valid frame and by a new
+ * baud rate, and the application call back of each line error */
+static volatile uint8 g_lineErrors = 0;
+static void (*g_lineErrorCallBack_Ptr)(void) = NULL_PTR;
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/* Bus address of the received bytes (UART_setAddress) */
+static volatile uint8 g_address = 0;
+#endif
+
+#if (UART_TRACE_ENABLE == TRUE)
+/* Link trace ring buffer, the oldest record is overwritten when it is full */
+static UART_TraceRecordType g_traceBuffer[UART_TRACE_SIZE];
+static uint8 g_traceHead = 0;
+static uint8 g_traceCount = 0;
+static uint32 g_traceTicks = 0;					/* Tick of the last record */
+static volatile uint8 g_tracePaused = FALSE;	/* Set while dumping the trace */
+#endif
+
+/*******************************************************************************
+ *                      Private Functions                                      *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Count one more line error in a row (up to 255) and call the application call back, called
+ * from the RX ISR (or from the application in the polling mode).
+ */
+static void UART_lineError(void)
+{
+	if(g_lineErrors != 0xFF)
+	{
+		g_lineErrors++;
+	}
+	if(g_lineErrorCallBack_Ptr != NULL_PTR)
+	{
+		(*g_lineErrorCallBack_Ptr)();
+	}
+}
+
+/*
+ * Description :
+ * Frame receive state machine, called for each received byte from the RX ISR (or from the
+ * application while the RX interrupt is disabled / in the polling mode).
+ * The payload is written directly in the caller buffer.
+ */
+static void UART_parseFrameByte(uint8 data)
+{
+	/*
+	 * Resynchronize after a gap in the middle of a frame: the rest of this frame is lost, so
+	 * the next bytes must not be taken as its payload (they are the start of the next frame)
+	 */
+	if((g_frameState != UART_FRAME_WAIT_START) && (g_frameState != UART_FRAME_RECEIVED)
+			&& UART_TIME_ELAPSED(g_frameByteTime, UART_FRAME_GAP_TIMEOUT_MS))
+	{
+		g_frameState = UART_FRAME_WAIT_START;
+	}
+	g_frameByteTime = UART_getTime();
+
+	switch(g_frameState)
+	{
+	case UART_FRAME_WAIT_START:
+		if(data == FRAME_START_BYTE)
+		{
+			g_frameCrc = FRAME_CRC8_INITIAL_VALUE;
+			g_frameState = UART_FRAME_WAIT_TYPE;
+		}
+		break;
+	case UART_FRAME_WAIT_TYPE:
+		g_frameType = data;
+		FRAME_CRC8_UPDATE(g_frameCrc, data);
+		g_frameState = UART_FRAME_WAIT_LENGTH;
+		break;
+	case UART_FRAME_WAIT_LENGTH:
+		if(data > g_frameMaxLength)
+		{
+			/* Too long for the caller buffer, hunt the next frame */
+			g_frameState = UART_FRAME_WAIT_START;
+		}
+		else
+		{
+			g_frameLength = data;
+			g_frameIndex = 0;
+			FRAME_CRC8_UPDATE(g_frameCrc, data);
+			g_frameState = (data == 0) ? UART_FRAME_WAIT_CRC : UART_FRAME_WAIT_PAYLOAD;
+		}
+		break;
+	case UART_FRAME_WAIT_PAYLOAD:
+		g_frameBuffer_Ptr[g_frameIndex] = data;
+		g_frameIndex++;
+		FRAME_CRC8_UPDATE(g_frameCrc, data);
+		if(g_frameIndex == g_frameLength)
+		{
+			g_frameState = UART_FRAME_WAIT_CRC;
+		}
+		break;
+	case UART_FRAME_WAIT_CRC:
+		if(data == g_frameCrc)
+		{
+			g_frameState = UART_FRAME_RECEIVED;
+			g_lineErrors = 0;
+			if(g_frameCallBack_Ptr != NULL_PTR)
+			{
+				(*g_frameCallBack_Ptr)(g_frameType, g_frameLength);
+			}
+		}
+		else
+		{
+			/* Corrupted frame, hunt the next frame */
+			g_frameState = UART_FRAME_WAIT_START;
+			UART_lineError();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+#if (UART_TRACE_ENABLE == TRUE)
+/*
+ * Description :
+ * Write one record in the link trace ring buffer, the oldest record is overwritten when it is
+ * full (interrupts disabled).
+ */
+static void UART_traceStore(uint8 data, uint8 info, uint16 counter)
+{
+	UART_TraceRecordType *record_Ptr = &g_traceBuffer[g_traceHead];
+
+	record_Ptr->data = data;
+	record_Ptr->info = info;
+	record_Ptr->counter = counter;
+
+	g_traceHead = (g_traceHead + 1) & (UART_TRACE_SIZE - 1);
+	if(g_traceCount < UART_TRACE_SIZE)
+	{
+		g_traceCount++;
+	}
+}
+
+/*
+ * Description :
+ * Record one byte of the link trace with its direction and time, called from the UART ISRs
+ * or, in the polling mode, with the interrupts enabled (the record is a critical section).
+ * A marker record gives first the ticks passed since the last record when the low bits of
+ * the tick can't.
+ */
+static void UART_traceRecord(uint8 direction, uint8 data)
+{
+	uint32 ticks;
+	uint32 passed;
+	uint16 counts;
+	uint8 sreg;
+
+	if(g_tracePaused == TRUE)
+	{
+		return;
+	}
+
+	PORT_ENTER_CRITICAL(sreg);
+	ticks = UART_TRACE_TIME_STAMP(&counts);
+	passed = ticks - g_traceTicks;
+	if(passed >= UART_TRACE_TICK_MASK)
+	{
+		if(passed > 0xFFFFFFUL)
+		{
+			passed = 0xFFFFFFUL;
+		}
+		UART_traceStore((uint8)(passed >> 16),
+				UART_TRACE_MARKER | ((uint8)ticks & UART_TRACE_TICK_MASK), (uint16)passed);
+	}
+	g_traceTicks = ticks;
+	UART_traceStore(data, direction | ((uint8)ticks & UART_TRACE_TICK_MASK), counts);
+	PORT_EXIT_CRITICAL(sreg);
+}
+#endif
+
+/*
+ * Description :
+ * Write the selected U2X/UBRR pair in the UART registers.
+ */
+static void UART_writeBaudSetting(const UART_BaudSettingType *Setting_Ptr)
+{
+	/* Only U2X is written (MPCM keeps its value), the flags are written zero (TXC is cleared
+	 * by writing one) */
+	PORT_WRITE_REG(UCSRA, ((Setting_Ptr->double_speed) << U2X) | (UCSRA & (1<<MPCM)));
+
+	/* First 8 bits from the BAUD_PRESCALE inside UBRRL and last 4 bits in UBRRH*/
+	UBRRH = (Setting_Ptr->ubrr_value)>>8;
+	UBRRL = Setting_Ptr->ubrr_value;
+}
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+/*
+ * Description :
+ * Multi-drop bus: an address byte is received (it starts a new transmission). Leave the MPCM
+ * mode to receive the bytes after our address, or enter it to drop the bytes sent to another
+ * address in hardware. A frame in progress ends here.
+ */
+static void UART_receiveAddress(uint8 address)
+{
+	if(address == g_address)
+	{
+		PORT_WRITE_REG(UCSRA, UCSRA & (1<<U2X));	/* MPCM = 0, TXC is not cleared */
+	}
+	else
+	{
+		PORT_WRITE_REG(UCSRA, (UCSRA & (1<<U2X)) | (1<<MPCM));
+	}
+
+	if((g_frameState != UART_FRAME_IDLE) && (g_frameState != UART_FRAME_RECEIVED))
+	{
+		g_frameState = UART_FRAME_WAIT_START;
+	}
+}
+#endif
+
+#if (UART_INTERRUPT_MODE == TRUE)
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/*
+ * Single-producer/single-consumer ring buffers:
+ * - RX: the RXC ISR is the only writer of g_rxHead and the application is the only
+ *   writer of g_rxTail.
+ * - TX: the application is the only writer of g_txHead and the UDRE ISR is the only
+ *   writer of g_txTail (a bus panel sends from the RX ISR only, see UART_setAddress).
+ * The indexes are 8-bit so reading/writing them is atomic and no locking is needed.
+ * One location is always left empty to differentiate between full and empty buffer.
+ */
+static volatile uint8 g_rxBuffer[UART_RX_BUFFER_SIZE];
+static volatile uint8 g_rxHead = 0;
+static volatile uint8 g_rxTail = 0;
+
+static volatile uint8 g_txBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint8 g_txHead = 0;
+static volatile uint8 g_txTail = 0;
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+static volatile uint8 g_txAddressFlags[UART_TX_ADDRESS_FLAGS_SIZE];
+#endif
+
+/*
+ * Description :
+ * Put one byte in the TX buffer and enable the UDRE interrupt, FALSE if the buffer is full.
+ * isAddress marks the address bytes of the multi-drop bus (ignored on a point-to-point link).
+ */
+static uint8 UART_queueByte(uint8 data, uint8 isAddress)
+{
+	uint8 head = g_txHead;
+	uint8 nextHead = (head + 1) & (UART_TX_BUFFER_SIZE - 1);
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	uint8 sreg;
+#endif
+
+	if(nextHead == g_txTail)
+	{
+		return FALSE; /* TX buffer is full */
+	}
+
+	g_txBuffer[head] = data;
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	if(isAddress)
+	{
+		SET_BIT(g_txAddressFlags[head >> 3], head & 7);
+	}
+	else
+	{
+		CLEAR_BIT(g_txAddressFlags[head >> 3], head & 7);
+	}
+
+	/* Take the bus for every byte: the TXC ISR releases it when the buffer is empty, the
+	 * sender may be slower than the wire in the middle of a frame. The TXC ISR must not see
+	 * the empty buffer between the bus driver and the new head. */
+	PORT_ENTER_CRITICAL(sreg);
+	SET_BIT(UART_BUS_DRIVER_PORT, UART_BUS_DRIVER_PIN);
+	g_txHead = nextHead;
+	PORT_EXIT_CRITICAL(sreg);
+#else
+	(void)isAddress;
+
+	/* Publish the byte to the ISR only after it is stored in the buffer */
+	g_txHead = nextHead;
+#endif
+
+	/* Enable the UDRE interrupt to start (or continue) sending the buffer */
+	SET_BIT(UCSRB,UDRIE);
+	return TRUE;
+}
+
+
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(USART_RXC_vect)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* The 9th bit (RXB8) must be read before UDR */
+	uint8 isAddress = BIT_IS_SET(UCSRB,RXB8);
+#endif
+	/* The error flags (FE, DOR) must be read before UDR too */
+	uint8 status = PORT_READ_REG(UCSRA);
+	/* Read UDR to clear the RXC flag */
+	uint8 data = PORT_READ_REG(UDR);
+	uint8 nextHead;
+
+	UART_TRACE_RECORD(UART_TRACE_RX, data);
+
+	if(status & ((1<<FE) | (1<<DOR)))
+	{
+		UART_lineError();	/* Wrong baud rate or noise, or a byte lost */
+	}
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	if(isAddress)
+	{
+		UART_receiveAddress(data);
+		return; /* The address byte is not data */
+	}
+#endif
+
+	if((g_frameState != UART_FRAME_IDLE) && (g_frameState != UART_FRAME_RECEIVED))
+	{
+		/* A frame is required, the byte goes directly to the caller buffer */
+		UART_parseFrameByte(data);
+	}
+	else
+	{
+		nextHead = (g_rxHead + 1) & (UART_RX_BUFFER_SIZE - 1);
+
+		/* Store the byte if there is a space in the buffer, otherwise the byte is dropped */
+		if(nextHead != g_rxTail)
+		{
+			g_rxBuffer[g_rxHead] = data;
+			g_rxHead = nextHead;
+		}
+	}
+}
+
+ISR(USART_UDRE_vect)
+{
+	if(g_txHead != g_txTail)
+	{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+		/* The 9th bit must be written before UDR */
+		if(UART_TX_IS_ADDRESS(g_txTail))
+		{
+			SET_BIT(UCSRB,TXB8);
+		}
+		else
+		{
+			CLEAR_BIT(UCSRB,TXB8);
+		}
+#endif
+		/* Send the oldest byte in the TX buffer */
+		UART_WRITE_UDR(g_txBuffer[g_txTail]);
+		g_txTail = (g_txTail + 1) & (UART_TX_BUFFER_SIZE - 1);
+#if (UART_MULTIDROP_ENABLE == TRUE)
+		g_txDone = FALSE;
+#endif
+	}
+
+	if(g_txHead == g_txTail)
+	{
+		/* Nothing else to send, disable the UDRE interrupt until a new byte is queued */
+		CLEAR_BIT(UCSRB,UDRIE);
+	}
+}
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+ISR(USART_TXC_vect)
+{
+	/* The last byte is sent, release the bus for the other nodes */
+	if(g_txHead == g_txTail)
+	{
+		CLEAR_BIT(UART_BUS_DRIVER_PORT, UART_BUS_DRIVER_PIN);
+	}
+	g_txDone = TRUE;
+}
+#endif
+
+#endif /* UART_INTERRUPT_MODE */
 
 
 
@@ -29,7 +493,8 @@
  * 					1. Setup the Frame format like number of data bits, parity bit type
  * 					   and number of stop bits.
  * 					2. Enable the UART.
- * 					3. Setup the UART baud rate.
+ * 					3. Setup the UART baud rate, UART_DEFAULT_BAUD_RATE is used if the
+ * 					   required one is not safe.
  *
  * [Arguments]: const UART_ConfigType * Config_Ptr
  *
@@ -42,21 +507,55 @@
  ********************************************************************************************/
 void UART_init(const UART_ConfigType * Config_Ptr)
 {
-	uint16 ubrr_value = 0;
+	UART_BaudSettingType baudSetting;
+	uint8 ucsrc_value;
 
-	/* U2X = 1 for double transmission speed */
-	UCSRA = (1<<U2X);
+	/* Select the best U2X/UBRR pair for the required baud rate, or the default one if the
+	 * error is not acceptable */
+	g_baudRate = Config_Ptr->baud_rate;
+	if(UART_calculateBaudSetting(g_baudRate, &baudSetting) == FALSE)
+	{
+		g_baudRate = UART_DEFAULT_BAUD_RATE;
+		UART_calculateBaudSetting(g_baudRate, &baudSetting);
+	}
+
+	/* U2X as selected for the baud rate */
+	UART_writeBaudSetting(&baudSetting);
 
 	/************************** UCSRB Description **************************
-	 * RXCIE = 0 Disable USART RX Complete Interrupt Enable
+	 * RXCIE = 1 Enable USART RX Complete Interrupt in the interrupt mode
 	 * TXCIE = 0 Disable USART Tx Complete Interrupt Enable
-	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable
+	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable (it is
+	 * 			 enabled only when there are bytes in the TX buffer)
 	 * RXEN  = 1 Receiver Enable
 	 * RXEN  = 1 Transmitter Enable
 	 * UCSZ2 = 0 For 8-bit data mode
 	 * RXB8 & TXB8 not used for 8-bit data mode
 	 ***********************************************************************/ 
+#if (UART_INTERRUPT_MODE == TRUE)
+	/* Start with empty ring buffers */
+	g_rxHead = 0;
+	g_rxTail = 0;
+	g_txHead = 0;
+	g_txTail = 0;
+
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* The bus is released (receive) until the first address byte is sent */
+	SET_BIT(UART_BUS_DRIVER_DDR, UART_BUS_DRIVER_PIN);
+	CLEAR_BIT(UART_BUS_DRIVER_PORT, UART_BUS_DRIVER_PIN);
+
+	/* Receive the bytes sent to address 0 only until UART_setAddress */
+	g_address = 0;
+	PORT_WRITE_REG(UCSRA, (UCSRA & (1<<U2X)) | (1<<MPCM));
+
+	/* UCSZ2 = 1 adds the 9th (address) bit to the 8 data bits, TXCIE releases the bus */
+	UCSRB = (1<<RXCIE) | (1<<TXCIE) | (1<<RXEN) | (1<<TXEN) | (1<<UCSZ2);
+#else
+	UCSRB = (1<<RXCIE) | (1<<RXEN) | (1<<TXEN);
+#endif
+#else
 	UCSRB = (1<<RXEN) | (1<<TXEN);
+#endif
 
 	/************************** UCSRC Description **************************
 	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
@@ -66,30 +565,206 @@ void UART_init(const UART_ConfigType * Config_Ptr)
 	 * UCSZ1:0 = 11 For 8-bit data mode
 	 * UCPOL   = 0 Used with the Synchronous operation only
 	 ***********************************************************************/ 	
-	UCSRC = (1<<URSEL);
+	ucsrc_value = (1<<URSEL);
 
 	/*
 	 * Adjusting the register for selecting the number of bit that you want
+	 * (UCSZ1:0 take the two bits of the data size directly)
 	 */
-	UCSRC |= ((Config_Ptr->data_size & 0x02)<< UCSZ0);
-	UCSRC |= ((Config_Ptr->data_size & 0x04)<< UCSZ1);
+	ucsrc_value |= ((Config_Ptr->data_size & 0x03) << UCSZ0);
 
 	/*
 	 * Select Parity Mode
 	 */
-	UCSRC |= ((Config_Ptr -> parity_mode) << UPM0);
+	ucsrc_value |= ((Config_Ptr -> parity_mode) << UPM0);
 
 	/*
 	 * Select the Number of Stop Bit
 	 */
-	UCSRC |= ((Config_Ptr -> stop_bit) << USBS);
+	ucsrc_value |= ((Config_Ptr -> stop_bit) << USBS);
+
+	/*
+	 * Write UCSRC once, reading UCSRC (as in |=) returns UBRRH on ATmega16 so
+	 * the register must not be modified bit by bit
+	 */
+	UCSRC = ucsrc_value;
+}
 
-	/* Calculate the UBRR register value */
-	ubrr_value = (uint16)(((F_CPU / (Config_Ptr->baud_rate * 8UL))) - 1);
 
-	/* First 8 bits from the BAUD_PRESCALE inside UBRRL and last 4 bits in UBRRH*/
-	UBRRH = ubrr_value>>8;
-	UBRRL = ubrr_value;
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_calculateBaudSetting
+ *
+ * [Description]: Functional responsible for finding the best U2X/UBRR pair for the required
+ * 				  baud rate with F_CPU clock:
+ * 					1. Calculate the rounded UBRR value in normal and double speed.
+ * 					2. Select the pair with the smallest error (normal speed if equal as
+ * 					   it samples each bit more times).
+ * 					3. Check the error against the maximum accepted error.
+ *
+ * [Arguments]: uint32 baud_rate, UART_BaudSettingType *Setting_Ptr
+ *
+ * [in]: baud_rate: The required baud rate
+ *
+ * [out]: *Setting_Ptr: The selected UBRR/U2X pair and its error
+ *
+ * [Returns]: TRUE if the baud rate is safe to be used, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 UART_calculateBaudSetting(uint32 baud_rate, UART_BaudSettingType *Setting_Ptr)
+{
+	uint8 double_speed;
+	uint32 divisor;			/* Clocks per bit: 16 in normal speed and 8 in double speed */
+	uint32 ubrr_value;
+	uint32 actual_baud_rate;
+	sint32 error;
+	sint32 best_error = 0;
+	uint8 found = FALSE;
+
+	if(baud_rate == 0)
+	{
+		return FALSE;
+	}
+
+	for(double_speed = 0; double_speed <= 1; double_speed++)
+	{
+		divisor = (double_speed ? 8UL : 16UL) * baud_rate;
+
+		/* Round to the nearest UBRR instead of truncating */
+		ubrr_value = (F_CPU + (divisor / 2)) / divisor;
+		if(ubrr_value == 0)
+		{
+			continue; /* Baud rate is too high for this speed mode */
+		}
+		ubrr_value--;
+		if(ubrr_value > UART_MAX_UBRR_VALUE)
+		{
+			continue; /* Baud rate is too low for this speed mode */
+		}
+
+		actual_baud_rate = F_CPU / ((double_speed ? 8UL : 16UL) * (ubrr_value + 1));
+		error = (((sint32)actual_baud_rate - (sint32)baud_rate) * 1000L) / (sint32)baud_rate;
+
+		/* Keep the normal speed when the errors are equal */
+		if((found == FALSE) || (ABS(error) < ABS(best_error)))
+		{
+			found = TRUE;
+			best_error = error;
+			Setting_Ptr->ubrr_value = (uint16)ubrr_value;
+			Setting_Ptr->double_speed = double_speed;
+			Setting_Ptr->error = (sint16)error;
+		}
+	}
+
+	if(found == FALSE)
+	{
+		return FALSE;
+	}
+
+	if(ABS(best_error) > (Setting_Ptr->double_speed ? UART_MAX_ERROR_DOUBLE_SPEED : UART_MAX_ERROR_NORMAL_SPEED))
+	{
+		return FALSE; /* Unsafe baud rate, the receiver may sample the wrong bits */
+	}
+
+	return TRUE;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_setBaudRate
+ *
+ * [Description]: Functional responsible for changing the baud rate after sending all the
+ * 				  queued bytes, unsafe baud rates are refused and the current one is kept.
+ * 				  The line errors count starts again.
+ *
+ * [Arguments]: uint32 baud_rate
+ *
+ * [in]: baud_rate: The required baud rate
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if the baud rate is changed, FALSE if it is refused
+ *
+ ********************************************************************************************/
+uint8 UART_setBaudRate(uint32 baud_rate)
+{
+	UART_BaudSettingType baudSetting;
+
+	if(UART_calculateBaudSetting(baud_rate, &baudSetting) == FALSE)
+	{
+		return FALSE;
+	}
+
+	/* Don't change the rate in the middle of a byte */
+	UART_flush();
+
+	UART_writeBaudSetting(&baudSetting);
+	g_baudRate = baud_rate;
+	g_lineErrors = 0;	/* The errors at the last baud rate are not counted */
+	return TRUE;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_getBaudRate
+ *
+ * [Description]: Functional responsible for returning the baud rate in use.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned long
+ *
+ * [Returns]: The baud rate in use
+ *
+ ********************************************************************************************/
+uint32 UART_getBaudRate(void)
+{
+	return g_baudRate;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_flush
+ *
+ * [Description]: Functional responsible for waiting until all the queued bytes are completely
+ * 				  shifted out of the transmitter.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_flush(void)
+{
+#if (UART_INTERRUPT_MODE == TRUE)
+	/* Wait until the UDRE ISR takes the last byte from the TX buffer */
+	while(g_txHead != g_txTail){}
+#endif
+
+	/* Wait until the shift register is empty, TXC is cleared each time a byte is written
+	 * in UDR and it is set after the last bit is sent (on the bus the TXC ISR clears it, it
+	 * sets g_txDone instead) */
+	if(g_txUsed == TRUE)
+	{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+		while(g_txDone == FALSE){}
+#else
+		while(BIT_IS_CLEAR(UCSRA,TXC)){}
+#endif
+	}
 }
 
 
@@ -111,6 +786,10 @@ void UART_init(const UART_ConfigType * Config_Ptr)
  ********************************************************************************************/
 void UART_sendByte(const uint8 data)
 {
+#if (UART_INTERRUPT_MODE == TRUE)
+	/* Wait only if the TX buffer is full, the UDRE ISR will free a location */
+	while(UART_queueSend(data) == FALSE){}
+#else
 	/*
 	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
 	 * transmitting a new byte so wait until this flag is set to one
@@ -121,7 +800,8 @@ void UART_sendByte(const uint8 data)
 	 * Put the required data in the UDR register and it also clear the UDRE flag as
 	 * the UDR register is not empty now
 	 */
-	UDR = data;
+	UART_WRITE_UDR(data);
+#endif
 }
 
 
@@ -143,14 +823,557 @@ void UART_sendByte(const uint8 data)
  ********************************************************************************************/
 uint8 UART_recieveByte(void)
 {
+	uint8 data;
+
+#if (UART_INTERRUPT_MODE == TRUE)
+	/* Wait until the RXC ISR puts a byte in the RX buffer */
+	while(UART_tryReceive(&data) == FALSE){}
+
+	return data;
+#else
 	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
 	while(BIT_IS_CLEAR(UCSRA,RXC)){}
 
+	/* The error flags must be read before UDR */
+	if(PORT_READ_REG(UCSRA) & ((1<<FE) | (1<<DOR)))
+	{
+		UART_lineError();
+	}
+
 	/*
 	 * Read the received data from the Rx buffer (UDR)
 	 * The RXC flag will be cleared after read the data
 	 */
-    return UDR;
+	data = PORT_READ_REG(UDR);
+	UART_TRACE_RECORD(UART_TRACE_RX, data);
+	return data;
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_tryReceive
+ *
+ * [Description]: Non-blocking receive, takes one byte from the RX ring buffer (or from UDR
+ * 				  in the polling mode) if there is any.
+ *
+ * [Arguments]: uint8 *data_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: *data_Ptr: The received byte (not touched if there is no byte)
+ *
+ * [Returns]: TRUE if a byte is received, FALSE if there is no received byte
+ *
+ ********************************************************************************************/
+uint8 UART_tryReceive(uint8 *data_Ptr)
+{
+#if (UART_INTERRUPT_MODE == TRUE)
+	uint8 tail = g_rxTail;
+
+	if(tail == g_rxHead)
+	{
+		return FALSE; /* RX buffer is empty */
+	}
+
+	*data_Ptr = g_rxBuffer[tail];
+
+	/* Free the location after reading it, so the ISR can't overwrite it before */
+	g_rxTail = (tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+	return TRUE;
+#else
+	if(BIT_IS_CLEAR(UCSRA,RXC))
+	{
+		return FALSE; /* No received byte in UDR */
+	}
+
+	/* The error flags must be read before UDR */
+	if(PORT_READ_REG(UCSRA) & ((1<<FE) | (1<<DOR)))
+	{
+		UART_lineError();
+	}
+
+	*data_Ptr = PORT_READ_REG(UDR);
+	UART_TRACE_RECORD(UART_TRACE_RX, *data_Ptr);
+	return TRUE;
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_recieveByteTimeout
+ *
+ * [Description]: Functional responsible for receiving one byte with a deadline, the function
+ * 				  returns if no byte is received for timeout_ms instead of waiting forever.
+ *
+ * [Arguments]: uint16 timeout_ms, uint8 *data_Ptr
+ *
+ * [in]: timeout_ms: The maximum waiting time in ms (rounded up to UART_TICK_PERIOD_MS)
+ *
+ * [out]: *data_Ptr: The received byte (not touched in case of timeout)
+ *
+ * [Returns]: TRUE if a byte is received, FALSE in case of timeout
+ *
+ ********************************************************************************************/
+uint8 UART_recieveByteTimeout(uint16 timeout_ms, uint8 *data_Ptr)
+{
+	uint16 start = UART_getTime();
+
+	while(UART_tryReceive(data_Ptr) == FALSE)
+	{
+		if(UART_TIME_ELAPSED(start, timeout_ms))
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_tick
+ *
+ * [Description]: Functional responsible for advancing the UART time by UART_TICK_PERIOD_MS,
+ * 				  it must be called every UART_TICK_PERIOD_MS (from the timer ISR) for the
+ * 				  receive timeouts to expire. A tickless idle may skip the ticks while no
+ * 				  frame is in progress (UART_isFrameInProgress): the UART time then counts
+ * 				  the time of the link activity only.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_tick(void)
+{
+	g_time += UART_TICK_PERIOD_MS;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_traceDump
+ *
+ * [Description]: Functional responsible for sending the link trace (UART_TRACE_ENABLE) as
+ * 				  frames then clearing it:
+ * 					1. FRAME_TYPE_TRACE_INFO: tick period in ms, timer counts per tick (2
+ * 					   bytes) and the number of records.
+ * 					2. FRAME_TYPE_TRACE_DATA: up to 4 records each (data, info, counter high
+ * 					   and low bytes) from the oldest one.
+ * 					3. Empty FRAME_TYPE_TRACE_DATA frame at the end.
+ * 				  The dump itself is not traced.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_traceDump(void)
+{
+#if (UART_TRACE_ENABLE == TRUE)
+	uint8 payload[UART_TRACE_RECORDS_PER_FRAME * 4];
+	uint8 length = 0;
+	uint16 countsPerTick = UART_TRACE_TICK_COUNTS;
+	uint8 index;
+	uint8 count;
+
+	/* Stop recording, the records are not changed while sending them */
+	g_tracePaused = TRUE;
+
+	index = (g_traceHead - g_traceCount) & (UART_TRACE_SIZE - 1);	/* The oldest record */
+	count = g_traceCount;
+
+	payload[0] = UART_TICK_PERIOD_MS;
+	payload[1] = countsPerTick >> 8;
+	payload[2] = countsPerTick;
+	payload[3] = count;
+	FRAME_send(FRAME_TYPE_TRACE_INFO, payload, 4);
+
+	while(count != 0)
+	{
+		payload[length++] = g_traceBuffer[index].data;
+		payload[length++] = g_traceBuffer[index].info;
+		payload[length++] = g_traceBuffer[index].counter >> 8;
+		payload[length++] = g_traceBuffer[index].counter;
+		index = (index + 1) & (UART_TRACE_SIZE - 1);
+		count--;
+
+		if((length == sizeof(payload)) || (count == 0))
+		{
+			FRAME_send(FRAME_TYPE_TRACE_DATA, payload, length);
+			length = 0;
+		}
+	}
+	FRAME_send(FRAME_TYPE_TRACE_DATA, payload, 0);	/* End of the trace */
+
+	UART_flush();
+
+	/* Start a new trace */
+	g_traceCount = 0;
+	g_tracePaused = FALSE;
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_tracePause
+ *
+ * [Description]: Functional responsible for stopping the link trace recording until the next
+ * 				  UART_traceDump, so the trace dump of the other ECU doesn't overwrite it.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_tracePause(void)
+{
+#if (UART_TRACE_ENABLE == TRUE)
+	g_tracePaused = TRUE;
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_getTime
+ *
+ * [Description]: Functional responsible for reading the UART time (advanced by UART_tick).
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned short
+ *
+ * [Returns]: The time in ms, it wraps around after 65535
+ *
+ ********************************************************************************************/
+uint16 UART_getTime(void)
+{
+	uint16 time;
+	uint8 sreg;
+
+	/* The 16-bit read takes two instructions, the timer ISR must not update it in between */
+	PORT_ENTER_CRITICAL(sreg);
+	time = g_time;
+	PORT_EXIT_CRITICAL(sreg);
+
+	return time;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_queueSend
+ *
+ * [Description]: Non-blocking send, puts one byte in the TX ring buffer and the UDRE interrupt
+ * 				  sends it in the background (in the polling mode the byte is written in UDR
+ * 				  directly if it is empty).
+ *
+ * [Arguments]: const uint8 data
+ *
+ * [in]: data: unsigned character
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if the byte is queued, FALSE if the TX buffer is full
+ *
+ ********************************************************************************************/
+uint8 UART_queueSend(const uint8 data)
+{
+#if (UART_INTERRUPT_MODE == TRUE)
+	return UART_queueByte(data, FALSE);
+#else
+	if(BIT_IS_CLEAR(UCSRA,UDRE))
+	{
+		return FALSE; /* UDR still has a byte to be sent */
+	}
+
+	UART_WRITE_UDR(data);
+	return TRUE;
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_receiveFrameInto
+ *
+ * [Description]: Functional responsible for receiving the next frame (frame.h format) directly
+ * 				  in the caller buffer:
+ * 					1. The RX ISR hunts the start byte and checks the length and the CRC of
+ * 					   the frame while writing the payload in the buffer (no staging copy).
+ * 					2. Frames with wrong CRC or longer than the buffer are dropped and the ISR
+ * 					   hunts the next start byte.
+ * 					3. When a valid frame is received, the callback is called (from the ISR)
+ * 					   and UART_isFrameReceived returns TRUE.
+ * 				  The bytes that are already in the RX buffer are parsed first. The RX buffer
+ * 				  is not used until the frame is received or cancelled.
+ *
+ * [Arguments]: uint8 *buffer_Ptr, uint8 maxLength, UART_FrameCallBackType a_callBack_Ptr
+ *
+ * [in]: - *buffer_Ptr: The buffer of the payload, it must be kept until the frame is received
+ * 		 - maxLength: Size of the buffer
+ * 		 - a_callBack_Ptr: Completion callback (NULL_PTR to use UART_isFrameReceived only)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_receiveFrameInto(uint8 *buffer_Ptr, uint8 maxLength, UART_FrameCallBackType a_callBack_Ptr)
+{
+	uint8 data;
+
+#if (UART_INTERRUPT_MODE == TRUE)
+	/* The state machine must not be called from the ISR and from here at the same time */
+	CLEAR_BIT(UCSRB,RXCIE);
+#endif
+
+	g_frameBuffer_Ptr = buffer_Ptr;
+	g_frameMaxLength = maxLength;
+	g_frameCallBack_Ptr = a_callBack_Ptr;
+	g_frameState = UART_FRAME_WAIT_START;
+
+	/* The bytes received before this call may hold the required frame */
+	while((g_frameState != UART_FRAME_RECEIVED) && (UART_tryReceive(&data) == TRUE))
+	{
+		UART_parseFrameByte(data);
+	}
+
+#if (UART_INTERRUPT_MODE == TRUE)
+	SET_BIT(UCSRB,RXCIE);
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_isFrameReceived
+ *
+ * [Description]: Functional responsible for checking the completion of UART_receiveFrameInto,
+ * 				  the frame receive ends when this function returns TRUE.
+ *
+ * [Arguments]: uint8 *type_Ptr, uint8 *length_Ptr
+ *
+ * [in]: void
+ *
+ * [out]: - *type_Ptr: The type of the received frame
+ * 		  - *length_Ptr: The payload length of the received frame
+ *
+ * [Returns]: TRUE if a valid frame is received in the buffer, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 UART_isFrameReceived(uint8 *type_Ptr, uint8 *length_Ptr)
+{
+#if (UART_INTERRUPT_MODE == FALSE)
+	uint8 data;
+
+	/* No RX ISR in the polling mode, parse the received byte here */
+	while((g_frameState != UART_FRAME_IDLE) && (g_frameState != UART_FRAME_RECEIVED)
+			&& (UART_tryReceive(&data) == TRUE))
+	{
+		UART_parseFrameByte(data);
+	}
+#endif
+
+	if(g_frameState != UART_FRAME_RECEIVED)
+	{
+		return FALSE;
+	}
+
+	*type_Ptr = g_frameType;
+	*length_Ptr = g_frameLength;
+	g_frameState = UART_FRAME_IDLE;
+	return TRUE;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_cancelFrameReceive
+ *
+ * [Description]: Functional responsible for stopping UART_receiveFrameInto, the next bytes
+ * 				  go to the RX buffer again.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_cancelFrameReceive(void)
+{
+	g_frameState = UART_FRAME_IDLE;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_isFrameInProgress
+ *
+ * [Description]: Functional responsible for checking if a frame of UART_receiveFrameInto is
+ * 				  being received (from its start byte to its CRC), the gap between its bytes
+ * 				  is measured by the UART time.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: TRUE if a frame is in progress, FALSE otherwise
+ *
+ ********************************************************************************************/
+uint8 UART_isFrameInProgress(void)
+{
+	UART_FrameStateType state = g_frameState;
+
+	return ((state != UART_FRAME_IDLE) && (state != UART_FRAME_WAIT_START)
+			&& (state != UART_FRAME_RECEIVED)) ? TRUE : FALSE;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_getLineErrors
+ *
+ * [Description]: Functional responsible for returning the number of line errors in a row:
+ * 				  received bytes with a framing or overrun error and frames with a wrong CRC
+ * 				  (up to 255). A valid frame and a new baud rate clear it.
+ *
+ * [Arguments]: None
+ *
+ * [in]: void
+ *
+ * [out]: unsigned character
+ *
+ * [Returns]: The number of line errors since the last valid frame
+ *
+ ********************************************************************************************/
+uint8 UART_getLineErrors(void)
+{
+	return g_lineErrors;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_setLineErrorCallBack
+ *
+ * [Description]: Functional responsible for setting the call back of the line errors, it is
+ * 				  called from the RX ISR for each line error (see UART_getLineErrors).
+ *
+ * [Arguments]: void(*a_ptr)(void)
+ *
+ * [in]: a_ptr: Pointer to the call back function (NULL_PTR for none)
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_setLineErrorCallBack(void(*a_ptr)(void))
+{
+	g_lineErrorCallBack_Ptr = a_ptr;
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_setAddress
+ *
+ * [Description]: Multi-drop bus only (UART_MULTIDROP_ENABLE): receive only the bytes sent after
+ * 				  the address byte a_address, the bytes sent to the other addresses are dropped
+ * 				  by the hardware (MPCM) until the next address byte.
+ * 				  A panel that answers from the frame callback (RX ISR) must send from there
+ * 				  only, the TX buffer has one producer.
+ *
+ * [Arguments]: uint8 a_address
+ *
+ * [in]: a_address: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_setAddress(uint8 a_address)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	uint8 sreg;
+
+	/* The RX ISR must not compare the next address byte with a half updated state */
+	PORT_ENTER_CRITICAL(sreg);
+	g_address = a_address;
+	PORT_WRITE_REG(UCSRA, (UCSRA & (1<<U2X)) | (1<<MPCM));	/* Drop the bytes until the next address byte */
+	PORT_EXIT_CRITICAL(sreg);
+#else
+	(void)a_address;
+#endif
+}
+
+
+
+/********************************************************************************************
+ *
+ * [Function Name]: UART_sendAddress
+ *
+ * [Description]: Multi-drop bus only (UART_MULTIDROP_ENABLE): queue one address byte (9th bit
+ * 				  set) to start a new transmission on the bus, the bytes queued after it are
+ * 				  received by the node(s) of this address only. It enables the bus driver.
+ *
+ * [Arguments]: uint8 a_address
+ *
+ * [in]: a_address: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void UART_sendAddress(uint8 a_address)
+{
+#if (UART_MULTIDROP_ENABLE == TRUE)
+	/* Wait only if the TX buffer is full, the UDRE ISR will free a location */
+	while(UART_queueByte(a_address, TRUE) == FALSE){}
+#else
+	(void)a_address;
+#endif
 }
 
 
@@ -0,0 +1,613 @@
+ /******************************************************************************
+ *
+ * [Module]: Host Tools
+ *
+ * [File Name]: e2e_benchmark.c
+ *
+ * [Description]: End-to-end benchmark of the two ECUs on the host.
+ * 				  It runs the host builds of the HMI ECU (hmi_host) and of the Control ECU
+ * 				  (control_host) on two pseudo-terminal pairs and forwards the bytes between
+ * 				  them, as the wire does. The HMI is driven by a keypad script of unlock and
+ * 				  change password cycles, the Control ECU stores the password in a file-backed
+ * 				  EEPROM, and both share one simulated clock (sim_clock.h).
+ * 				  Every command frame is matched with its reply by the sequence number, the
+ * 				  report gives the transactions per second, the p50/p99 latency (first command
+ * 				  byte to last reply byte, retransmissions included) and the bytes on the wire
+ * 				  per transaction type, then the active duty cycle of each ECU (simulated
+ * 				  time awake between its sleeps, sim_clock.h).
+ *
+ * 				  Build and run (from Code/Host):
+ * 				  make e2e_benchmark hmi_host control_host
+ * 				  ./e2e_benchmark [cycles] [clock_speedup]
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "std_types.h"
+#include "frame.h"
+#include "sim_clock.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PASSWORD_LENGTH				5
+
+/* Same values as hmi_ecu.h/control_ecu.h */
+#define DOOR_OPEN_OPTION			43
+#define CHANGE_PASSWORD_OPTION		45
+#define NEW_PASSWORD_OPTION			0x40
+#define DOOR_STATUS_OPTION			0x41
+#define COMMAND_SEQUENCE_INDEX		0
+#define COMMAND_OPTION_INDEX		1
+#define REPLY_SEQUENCE_INDEX		0
+#define REPLY_LENGTH				2
+
+#define DEFAULT_CYCLES				1000
+#define DEFAULT_SPEEDUP				10
+#define IDLE_TIMEOUT_MS				10000	/* No byte on the link for this time: stuck */
+#define FORWARD_BUFFER_SIZE			256
+#define WIRE_BAUD_RATE				9600	/* For the wire time estimate */
+#define BITS_PER_BYTE_ON_WIRE		10		/* Start + 8 data + stop */
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef enum{
+	HMI_TO_CTRL, CTRL_TO_HMI
+}Link_Direction;
+
+typedef enum{
+	BENCH_UNLOCK, BENCH_CHANGE_PASSWORD, BENCH_NEW_PASSWORD, BENCH_DOOR_STATUS, BENCH_OTHER,
+	BENCH_NUM_OF_CLASSES
+}Bench_Class;
+
+typedef enum{
+	WAIT_START, WAIT_TYPE, WAIT_LENGTH, WAIT_PAYLOAD, WAIT_CRC
+}Parser_State;
+
+/* Frame parser of one direction of the link */
+typedef struct{
+	Parser_State state;
+	uint8 type;
+	uint8 length;
+	uint8 index;
+	uint8 crc;
+	uint8 payload[FRAME_MAX_PAYLOAD_LENGTH];
+	uint64 start_ns;
+}Link_Parser;
+
+/* Command waiting for its reply */
+typedef struct{
+	uint8 active;			/* FALSE: completed, the late copies still belong to it */
+	uint8 sequence;
+	Bench_Class class;
+	uint64 start_ns;
+	uint32 bytes;
+	uint32 retries;
+}Bench_Transaction;
+
+typedef struct{
+	uint64 *latency_ns;
+	uint32 count;
+	uint32 capacity;
+	uint64 bytes;
+	uint32 retries;
+	uint32 lost;
+}Bench_Stats;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static const char *g_classNames[BENCH_NUM_OF_CLASSES] = {
+	"unlock", "change password", "new password", "door status", "other"
+};
+
+static Link_Parser g_parsers[2];
+static Bench_Transaction g_transaction;
+static Bench_Stats g_stats[BENCH_NUM_OF_CLASSES];
+static uint64 g_staleBytes = 0;		/* Late replies of already completed commands */
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static uint64 realTimeNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64)now.tv_sec * 1000000000ULL) + (uint64)now.tv_nsec;
+}
+
+static void die(const char *what)
+{
+	perror(what);
+	exit(EXIT_FAILURE);
+}
+
+/* Bitwise CRC-8, same polynomial as frame.c (the host tools do not link frame.c) */
+static uint8 crc8Update(uint8 crc, uint8 data)
+{
+	uint8 bit;
+
+	crc ^= data;
+	for(bit = 0; bit < 8; bit++)
+	{
+		crc = (crc & 0x80) ? (uint8)((crc << 1) ^ FRAME_CRC8_POLYNOMIAL) : (uint8)(crc << 1);
+	}
+	return crc;
+}
+
+static Bench_Class optionToClass(uint8 option)
+{
+	switch(option)
+	{
+	case DOOR_OPEN_OPTION:
+		return BENCH_UNLOCK;
+	case CHANGE_PASSWORD_OPTION:
+		return BENCH_CHANGE_PASSWORD;
+	case NEW_PASSWORD_OPTION:
+		return BENCH_NEW_PASSWORD;
+	case DOOR_STATUS_OPTION:
+		return BENCH_DOOR_STATUS;
+	default:
+		return BENCH_OTHER;
+	}
+}
+
+static void recordTransaction(uint64 end_ns)
+{
+	Bench_Stats *stats_Ptr = &g_stats[g_transaction.class];
+
+	if(stats_Ptr->count == stats_Ptr->capacity)
+	{
+		stats_Ptr->capacity = (stats_Ptr->capacity == 0) ? 1024 : (stats_Ptr->capacity * 2);
+		stats_Ptr->latency_ns = realloc(stats_Ptr->latency_ns, stats_Ptr->capacity * sizeof(uint64));
+		if(stats_Ptr->latency_ns == NULL)
+		{
+			die("realloc");
+		}
+	}
+	stats_Ptr->latency_ns[stats_Ptr->count] = end_ns - g_transaction.start_ns;
+	stats_Ptr->count++;
+	stats_Ptr->bytes += g_transaction.bytes;
+	stats_Ptr->retries += g_transaction.retries;
+	g_transaction.active = FALSE;
+}
+
+/* Called for every valid frame seen on the link */
+static void onFrame(Link_Direction direction, const Link_Parser *parser_Ptr, uint64 end_ns)
+{
+	uint32 bytes = parser_Ptr->length + FRAME_OVERHEAD_LENGTH;
+
+	if((direction == HMI_TO_CTRL) && (parser_Ptr->type == FRAME_TYPE_COMMAND)
+			&& (parser_Ptr->length > COMMAND_OPTION_INDEX))
+	{
+		if(g_transaction.sequence == parser_Ptr->payload[COMMAND_SEQUENCE_INDEX])
+		{
+			/* Retransmission, the transaction keeps its first start time */
+			if(g_transaction.active == TRUE)
+			{
+				g_transaction.bytes += bytes;
+				g_transaction.retries++;
+			}
+			else
+			{
+				/* Sent before the reply was received, the reply is sent again from the cache */
+				g_stats[g_transaction.class].bytes += bytes;
+				g_stats[g_transaction.class].retries++;
+			}
+			return;
+		}
+		if(g_transaction.active == TRUE)
+		{
+			g_stats[g_transaction.class].lost++;	/* The HMI gave up (LINK_ERROR) */
+		}
+		g_transaction.active = TRUE;
+		g_transaction.sequence = parser_Ptr->payload[COMMAND_SEQUENCE_INDEX];
+		g_transaction.class = optionToClass(parser_Ptr->payload[COMMAND_OPTION_INDEX]);
+		g_transaction.start_ns = parser_Ptr->start_ns;
+		g_transaction.bytes = bytes;
+		g_transaction.retries = 0;
+	}
+	else if((direction == CTRL_TO_HMI) && (parser_Ptr->type == FRAME_TYPE_REPLY)
+			&& (parser_Ptr->length == REPLY_LENGTH))
+	{
+		if((g_transaction.active == TRUE)
+				&& (g_transaction.sequence == parser_Ptr->payload[REPLY_SEQUENCE_INDEX]))
+		{
+			g_transaction.bytes += bytes;
+			recordTransaction(end_ns);
+		}
+		else if(g_transaction.sequence == parser_Ptr->payload[REPLY_SEQUENCE_INDEX])
+		{
+			g_stats[g_transaction.class].bytes += bytes;	/* Reply of a late retransmission */
+		}
+		else
+		{
+			g_staleBytes += bytes;
+		}
+	}
+}
+
+static void parseByte(Link_Direction direction, uint8 data, uint64 now_ns)
+{
+	Link_Parser *parser_Ptr = &g_parsers[direction];
+
+	switch(parser_Ptr->state)
+	{
+	case WAIT_START:
+		if(data == FRAME_START_BYTE)
+		{
+			parser_Ptr->start_ns = now_ns;
+			parser_Ptr->crc = FRAME_CRC8_INITIAL_VALUE;
+			parser_Ptr->state = WAIT_TYPE;
+		}
+		break;
+	case WAIT_TYPE:
+		parser_Ptr->type = data;
+		parser_Ptr->crc = crc8Update(parser_Ptr->crc, data);
+		parser_Ptr->state = WAIT_LENGTH;
+		break;
+	case WAIT_LENGTH:
+		if(data > FRAME_MAX_PAYLOAD_LENGTH)
+		{
+			parser_Ptr->state = WAIT_START;
+			break;
+		}
+		parser_Ptr->length = data;
+		parser_Ptr->index = 0;
+		parser_Ptr->crc = crc8Update(parser_Ptr->crc, data);
+		parser_Ptr->state = (data == 0) ? WAIT_CRC : WAIT_PAYLOAD;
+		break;
+	case WAIT_PAYLOAD:
+		parser_Ptr->payload[parser_Ptr->index] = data;
+		parser_Ptr->index++;
+		parser_Ptr->crc = crc8Update(parser_Ptr->crc, data);
+		if(parser_Ptr->index == parser_Ptr->length)
+		{
+			parser_Ptr->state = WAIT_CRC;
+		}
+		break;
+	case WAIT_CRC:
+		if(data == parser_Ptr->crc)
+		{
+			onFrame(direction, parser_Ptr, now_ns);
+		}
+		parser_Ptr->state = WAIT_START;
+		break;
+	}
+}
+
+/* Open a pseudo-terminal pair in raw mode, the slave stays open so the master never reads EOF */
+static int openPty(char *slaveName, size_t size, int *slave_Ptr)
+{
+	struct termios settings;
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if((master < 0) || (grantpt(master) != 0) || (unlockpt(master) != 0)
+			|| (ptsname_r(master, slaveName, size) != 0))
+	{
+		die("posix_openpt");
+	}
+	*slave_Ptr = open(slaveName, O_RDWR | O_NOCTTY);
+	if(*slave_Ptr < 0)
+	{
+		die(slaveName);
+	}
+	tcgetattr(*slave_Ptr, &settings);
+	cfmakeraw(&settings);
+	tcsetattr(*slave_Ptr, TCSANOW, &settings);
+	return master;
+}
+
+static void writeFile(const char *path, const void *data_Ptr, size_t size)
+{
+	FILE *file_Ptr = fopen(path, "wb");
+
+	if((file_Ptr == NULL) || (fwrite(data_Ptr, 1, size, file_Ptr) != size))
+	{
+		die(path);
+	}
+	fclose(file_Ptr);
+}
+
+/* First password, then unlock and change password cycles with two alternating passwords */
+static void writeKeypadScript(const char *path, uint32 cycles)
+{
+	const char *passwords[2] = {"12345", "54321"};
+	FILE *file_Ptr = fopen(path, "w");
+	uint32 cycle;
+
+	if(file_Ptr == NULL)
+	{
+		die(path);
+	}
+	fprintf(file_Ptr, "%s %s\n", passwords[0], passwords[0]);
+	for(cycle = 0; cycle < cycles; cycle++)
+	{
+		fprintf(file_Ptr, "+%s\n", passwords[cycle & 1]);
+		fprintf(file_Ptr, "-%s %s %s\n", passwords[cycle & 1],
+				passwords[(cycle + 1) & 1], passwords[(cycle + 1) & 1]);
+	}
+	fclose(file_Ptr);
+}
+
+static pid_t startEcu(const char *program, const char *device, const char *variable,
+		const char *value, const char *dutyCyclePath)
+{
+	pid_t pid = fork();
+
+	if(pid < 0)
+	{
+		die("fork");
+	}
+	if(pid == 0)
+	{
+		setenv("HOST_UART_DEVICE", device, 1);
+		setenv(variable, value, 1);
+		setenv(SIM_DUTY_FILE_ENV, dutyCyclePath, 1);
+		execl(program, program, (char *)NULL);
+		die(program);
+	}
+	return pid;
+}
+
+/* Forward the available bytes to the other ECU and parse them, FALSE if the link is closed */
+static uint8 forward(int from, int to, Link_Direction direction)
+{
+	uint8 buffer[FORWARD_BUFFER_SIZE];
+	ssize_t count = read(from, buffer, sizeof(buffer));
+	ssize_t written = 0;
+	ssize_t result;
+	uint64 now_ns = realTimeNs();
+	ssize_t i;
+
+	if(count <= 0)
+	{
+		return (count < 0) && ((errno == EAGAIN) || (errno == EINTR));
+	}
+
+	while(written < count)
+	{
+		result = write(to, buffer + written, count - written);
+		if(result < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return FALSE;
+		}
+		written += result;
+	}
+
+	for(i = 0; i < count; i++)
+	{
+		parseByte(direction, buffer[i], now_ns);
+	}
+	return TRUE;
+}
+
+static void printDutyCycle(const char *name, const char *path)
+{
+	SIM_DutyCycleType dutyCycle;
+	FILE *file_Ptr = fopen(path, "rb");
+	float64 total_s;
+
+	if((file_Ptr == NULL) || (fread(&dutyCycle, sizeof(dutyCycle), 1, file_Ptr) != 1))
+	{
+		die(path);
+	}
+	fclose(file_Ptr);
+
+	total_s = (dutyCycle.awake_us + dutyCycle.asleep_us) / 1e6;
+	printf("%-16s %9.3f %12.1f %10.1f\n", name,
+			(total_s > 0) ? ((dutyCycle.awake_us / 1e4) / total_s) : 0.0,
+			(total_s > 0) ? (dutyCycle.wakeUps / total_s) : 0.0, total_s);
+}
+
+static int compareLatency(const void *a_Ptr, const void *b_Ptr)
+{
+	uint64 a = *(const uint64 *)a_Ptr;
+	uint64 b = *(const uint64 *)b_Ptr;
+
+	return (a > b) - (a < b);
+}
+
+static float64 percentile_us(const Bench_Stats *stats_Ptr, float64 fraction)
+{
+	uint32 index = (uint32)(fraction * stats_Ptr->count + 0.999999);
+
+	if(stats_Ptr->count == 0)
+	{
+		return 0;
+	}
+	if(index > 0)
+	{
+		index--;
+	}
+	return stats_Ptr->latency_ns[index] / 1000.0;
+}
+
+static void printRow(const char *name, Bench_Stats *stats_Ptr, float64 wall_s)
+{
+	float64 bytes = (stats_Ptr->count != 0) ? ((float64)stats_Ptr->bytes / stats_Ptr->count) : 0;
+
+	qsort(stats_Ptr->latency_ns, stats_Ptr->count, sizeof(uint64), compareLatency);
+	printf("%-16s %7lu %9.1f %9.1f %9.1f %8.2f %10.2f %7lu %5lu\n", name,
+			(unsigned long)stats_Ptr->count, stats_Ptr->count / wall_s,
+			percentile_us(stats_Ptr, 0.50), percentile_us(stats_Ptr, 0.99), bytes,
+			(bytes * BITS_PER_BYTE_ON_WIRE * 1000.0) / WIRE_BAUD_RATE,
+			(unsigned long)stats_Ptr->retries, (unsigned long)stats_Ptr->lost);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32 cycles = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_CYCLES;
+	uint32 speedup = (argc > 2) ? strtoul(argv[2], NULL, 10) : DEFAULT_SPEEDUP;
+	char directory[] = "/tmp/e2e_benchmark.XXXXXX";
+	char clockPath[64], eepromPath[64], keypadPath[64], hmiDutyPath[64], controlDutyPath[64];
+	char hmiProgram[PATH_MAX + 16], controlProgram[PATH_MAX + 16], programDirectory[PATH_MAX];
+	char hmiDevice[64], controlDevice[64];
+	int hmiMaster, controlMaster, hmiSlave, controlSlave;
+	SIM_SharedClockType sharedClock;
+	SIM_DutyCycleType dutyCycle;
+	struct pollfd fds[2];
+	pid_t hmiPid, controlPid;
+	uint64 start_ns, lastByte_ns, now_ns;
+	uint8 running = TRUE;
+	Bench_Stats all;
+	float64 wall_s;
+	uint8 class;
+	int status;
+
+	if((cycles == 0) || (speedup == 0))
+	{
+		fprintf(stderr, "usage: %s [cycles] [clock_speedup]\n", argv[0]);
+		return 1;
+	}
+
+	strncpy(programDirectory, argv[0], sizeof(programDirectory) - 1);
+	programDirectory[sizeof(programDirectory) - 1] = '\0';
+	snprintf(hmiProgram, sizeof(hmiProgram), "%s/hmi_host", dirname(programDirectory));
+	snprintf(controlProgram, sizeof(controlProgram), "%s/control_host", programDirectory);
+
+	if(mkdtemp(directory) == NULL)
+	{
+		die("mkdtemp");
+	}
+	snprintf(clockPath, sizeof(clockPath), "%s/clock", directory);
+	snprintf(eepromPath, sizeof(eepromPath), "%s/eeprom", directory);
+	snprintf(keypadPath, sizeof(keypadPath), "%s/keypad", directory);
+	snprintf(hmiDutyPath, sizeof(hmiDutyPath), "%s/duty_hmi", directory);
+	snprintf(controlDutyPath, sizeof(controlDutyPath), "%s/duty_control", directory);
+
+	memset(&sharedClock, 0, sizeof(sharedClock));
+	sharedClock.start_ns = realTimeNs();
+	sharedClock.speedup = speedup;
+	writeFile(clockPath, &sharedClock, sizeof(sharedClock));
+	writeKeypadScript(keypadPath, cycles);
+	memset(&dutyCycle, 0, sizeof(dutyCycle));
+	writeFile(hmiDutyPath, &dutyCycle, sizeof(dutyCycle));
+	writeFile(controlDutyPath, &dutyCycle, sizeof(dutyCycle));
+	setenv(SIM_CLOCK_FILE_ENV, clockPath, 1);
+
+	hmiMaster = openPty(hmiDevice, sizeof(hmiDevice), &hmiSlave);
+	controlMaster = openPty(controlDevice, sizeof(controlDevice), &controlSlave);
+
+	/* The Control ECU first, it waits for the baud rate request of the HMI after reset */
+	controlPid = startEcu(controlProgram, controlDevice, "HOST_EEPROM_FILE", eepromPath,
+			controlDutyPath);
+	hmiPid = startEcu(hmiProgram, hmiDevice, "HOST_KEYPAD_FILE", keypadPath, hmiDutyPath);
+
+	fds[HMI_TO_CTRL].fd = hmiMaster;
+	fds[HMI_TO_CTRL].events = POLLIN;
+	fds[CTRL_TO_HMI].fd = controlMaster;
+	fds[CTRL_TO_HMI].events = POLLIN;
+
+	start_ns = realTimeNs();
+	lastByte_ns = start_ns;
+	while(running == TRUE)
+	{
+		if(poll(fds, 2, 100) > 0)
+		{
+			if(fds[HMI_TO_CTRL].revents & POLLIN)
+			{
+				running &= forward(hmiMaster, controlMaster, HMI_TO_CTRL);
+			}
+			if(fds[CTRL_TO_HMI].revents & POLLIN)
+			{
+				running &= forward(controlMaster, hmiMaster, CTRL_TO_HMI);
+			}
+			lastByte_ns = realTimeNs();
+		}
+
+		/* The HMI exits at the end of the keypad script */
+		if(waitpid(hmiPid, &status, WNOHANG) == hmiPid)
+		{
+			running = FALSE;
+		}
+
+		now_ns = realTimeNs();
+		if((now_ns - lastByte_ns) > (IDLE_TIMEOUT_MS * 1000000ULL))
+		{
+			fprintf(stderr, "No byte on the link for %d ms, stopping\n", IDLE_TIMEOUT_MS);
+			kill(hmiPid, SIGTERM);
+			waitpid(hmiPid, &status, 0);
+			running = FALSE;
+		}
+	}
+	wall_s = (realTimeNs() - start_ns) / 1e9;
+
+	kill(controlPid, SIGTERM);
+	waitpid(controlPid, &status, 0);
+	unlink(clockPath);
+	unlink(eepromPath);
+	unlink(keypadPath);
+
+	/* All the transactions together */
+	memset(&all, 0, sizeof(all));
+	for(class = 0; class < BENCH_NUM_OF_CLASSES; class++)
+	{
+		all.count += g_stats[class].count;
+		all.bytes += g_stats[class].bytes;
+		all.retries += g_stats[class].retries;
+		all.lost += g_stats[class].lost;
+	}
+	all.latency_ns = malloc((all.count + 1) * sizeof(uint64));
+	if(all.latency_ns == NULL)
+	{
+		die("malloc");
+	}
+	all.count = 0;
+	for(class = 0; class < BENCH_NUM_OF_CLASSES; class++)
+	{
+		memcpy(all.latency_ns + all.count, g_stats[class].latency_ns,
+				g_stats[class].count * sizeof(uint64));
+		all.count += g_stats[class].count;
+	}
+
+	printf("End-to-end link over pty pairs: %lu keypad cycles, simulated clock x%lu, %.3f s\n\n",
+			(unsigned long)cycles, (unsigned long)speedup, wall_s);
+	printf("%-16s %7s %9s %9s %9s %8s %10s %7s %5s\n", "transaction", "count", "tx/s",
+			"p50[us]", "p99[us]", "bytes/tx", "wire[ms]", "retries", "lost");
+	for(class = 0; class < BENCH_NUM_OF_CLASSES; class++)
+	{
+		if(g_stats[class].count != 0)
+		{
+			printRow(g_classNames[class], &g_stats[class], wall_s);
+		}
+	}
+	printRow("all", &all, wall_s);
+	printf("\nwire[ms]: time of the bytes of one transaction at %d baud, stale reply bytes: %llu\n",
+			WIRE_BAUD_RATE, (unsigned long long)g_staleBytes);
+
+	printf("\n%-16s %9s %12s %10s\n", "ECU", "awake[%]", "wake-ups/s", "time[s]");
+	printDutyCycle("HMI", hmiDutyPath);
+	printDutyCycle("Control", controlDutyPath);
+	printf("\nawake[%%]: simulated time from a wake up to the next sleep, from the first sleep\n");
+	unlink(hmiDutyPath);
+	unlink(controlDutyPath);
+	rmdir(directory);
+
+	close(hmiSlave);
+	close(controlSlave);
+	return 0;
+}
@@ -0,0 +1,118 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: keypad_host.c
+ *
+ * [Description]: Host implementation of the Keypad driver (keypad.h). The keys are read from
+ * 				  a script file (HOST_KEYPAD_FILE) or from the standard input: the digits are
+ * 				  returned as the numbers 0 to 9 (as the keypad driver does), the other
+ * 				  characters as they are, and the white spaces are skipped. The end of the
+ * 				  script ends the program. Every key of the script is a press event then a
+ * 				  release event, there is no scan (KEYPAD_tick only counts the time). A key
+ * 				  takes KEYPAD_KEY_PERIOD_MS of simulated time, the pace of the user's fingers.
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include "keypad.h"
+#include "sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define KEYPAD_SCRIPT_ENV			"HOST_KEYPAD_FILE"
+#define KEYPAD_KEY_PERIOD_MS		150		/* Simulated time from one key press to the next */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static FILE *g_script_Ptr = NULL;
+static uint8 g_releasePending = FALSE;
+static uint8 g_lastKey = 0;
+static volatile uint16 g_time = 0;
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/* Next key of the script */
+static uint8 KEYPAD_readScript(void)
+{
+	int key;
+
+	do
+	{
+		key = fgetc(g_script_Ptr);
+		if(key == EOF)
+		{
+			exit(EXIT_SUCCESS); /* No more keys, the user left */
+		}
+	}while(isspace(key));
+
+	/* The ECU sleeps until the key (it is not busy waiting for the user) */
+	SIM_setAsleep(TRUE);
+	SIM_delayUs(KEYPAD_KEY_PERIOD_MS * 1000ULL);
+	SIM_setAsleep(FALSE);
+
+	if((key >= '0') && (key <= '9'))
+	{
+		return (uint8)(key - '0');
+	}
+	return (uint8)key;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void KEYPAD_init(void)
+{
+	const char *path = getenv(KEYPAD_SCRIPT_ENV);
+
+	g_script_Ptr = (path != NULL) ? fopen(path, "r") : stdin;
+	if(g_script_Ptr == NULL)
+	{
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+}
+
+uint8 KEYPAD_tick(void)
+{
+	g_time++;
+	return FALSE;	/* The keys of the script are read when they are asked */
+}
+
+uint16 KEYPAD_getTime(void)
+{
+	return g_time;
+}
+
+uint8 KEYPAD_getEvent(KEYPAD_KeyEventType *Event_Ptr)
+{
+	if(g_releasePending == TRUE)
+	{
+		Event_Ptr->event = KEYPAD_KEY_RELEASED;
+		g_releasePending = FALSE;
+	}
+	else
+	{
+		g_lastKey = KEYPAD_readScript();
+		Event_Ptr->event = KEYPAD_KEY_PRESSED;
+		g_releasePending = TRUE;
+	}
+	Event_Ptr->key = g_lastKey;
+	Event_Ptr->time = g_time;
+	return TRUE;
+}
+
+uint8 KEYPAD_getPressedKey(void)
+{
+	g_releasePending = FALSE;
+	return KEYPAD_readScript();
+}
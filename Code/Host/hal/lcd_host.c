@@ -0,0 +1,105 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: lcd_host.c
+ *
+ * [Description]: Host implementation of the LCD driver (lcd.h). The screen is printed on
+ * 				  the standard error when HOST_LCD_ECHO is set, otherwise it is dropped (the
+ * 				  benchmark does not measure the LCD).
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include "lcd.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define LCD_ECHO_ENV				"HOST_LCD_ECHO"
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint8 g_echo = FALSE;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+void LCD_init(void)
+{
+	g_echo = (getenv(LCD_ECHO_ENV) != NULL) ? TRUE : FALSE;
+}
+
+void LCD_sendCommand(uint8 command)
+{
+	(void)command;
+}
+
+void LCD_displayCharacter(uint8 data)
+{
+	if(g_echo == TRUE)
+	{
+		fputc(data, stderr);
+	}
+}
+
+void LCD_displayString(const char *Str)
+{
+	if(g_echo == TRUE)
+	{
+		fputs(Str, stderr);
+	}
+}
+
+void LCD_displayString_P(PGM_P Str)
+{
+	LCD_displayString(Str);	/* One address space on the host */
+}
+
+void LCD_moveCursor(uint8 row,uint8 col)
+{
+	if(g_echo == TRUE)
+	{
+		fputc(' ', stderr);
+	}
+	(void)row;
+	(void)col;
+}
+
+void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
+{
+	LCD_moveCursor(row, col);
+	LCD_displayString(Str);
+}
+
+void LCD_displayStringRowColumn_P(uint8 row,uint8 col,PGM_P Str)
+{
+	LCD_moveCursor(row, col);
+	LCD_displayString_P(Str);
+}
+
+void LCD_intgerToString(int data)
+{
+	if(g_echo == TRUE)
+	{
+		fprintf(stderr, "%d", data);
+	}
+}
+
+void LCD_clearScreen(void)
+{
+	if(g_echo == TRUE)
+	{
+		fputc('\n', stderr);
+	}
+}
+
+void LCD_waitQueue(void)
+{
+	/* Nothing is queued, the screen is written at once */
+}
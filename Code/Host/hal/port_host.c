@@ -0,0 +1,724 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: port_host.c
+ *
+ * [Description]: Source file for the Linux backend of the port layer: register file,
+ * 				  interrupts and simulated peripherals of the ATmega16 (see port_host.h)
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#define _GNU_SOURCE	/* ppoll */
+
+#include "port_host.h"
+#include "sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PORT_UART_DEVICE_ENV		"HOST_UART_DEVICE"
+#define PORT_EEPROM_FILE_ENV		"HOST_EEPROM_FILE"
+
+#define PORT_THREAD_WAIT_NS			100000	/* Real time between two runs of the peripherals */
+#define PORT_IDLE_CALLS				64		/* Critical sections of a wait loop before it sleeps */
+#define PORT_UART_READ_SIZE			64
+#define PORT_UART_WRITE_WAIT_MS		1		/* Real time to wait for room in the device */
+#define PORT_MAX_UDRE_CALLS			64		/* Calls of the UDRE ISR in one run */
+#define PORT_NUM_OF_TIMERS			3
+
+/* 24C16 EEPROM: 8 blocks of 256 bytes (A8 to A10 are in the device address), 16-byte pages */
+#define PORT_EEPROM_SIZE			2048
+#define PORT_EEPROM_PAGE_SIZE		16
+#define PORT_EEPROM_ERASED_VALUE	0xFF
+#define PORT_EEPROM_DEVICE_MASK		0xF0
+#define PORT_EEPROM_DEVICE_ADDRESS	0xA0
+
+/* TWI status codes (TWSR without the prescaler bits) */
+#define PORT_TWI_START				0x08
+#define PORT_TWI_REP_START			0x10
+#define PORT_TWI_MT_SLA_W_ACK		0x18
+#define PORT_TWI_MT_SLA_W_NACK		0x20
+#define PORT_TWI_MT_DATA_ACK		0x28
+#define PORT_TWI_MT_SLA_R_ACK		0x40
+#define PORT_TWI_MT_SLA_R_NACK		0x48
+#define PORT_TWI_MR_DATA_ACK		0x50
+#define PORT_TWI_MR_DATA_NACK		0x58
+#define PORT_TWI_NO_STATE			0xF8
+#define PORT_TWI_STATUS_MASK		0xF8
+
+#define PORT_BIT(BIT)				(1 << (BIT))
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef enum{
+	PORT_TWI_IDLE, PORT_TWI_SLAVE_ADDRESS, PORT_TWI_WORD_ADDRESS, PORT_TWI_WRITE, PORT_TWI_READ,
+	PORT_TWI_NOT_ADDRESSED
+}PORT_TwiStateType;
+
+/* Timer settings read from its registers */
+typedef struct{
+	uint16 divisor;					/* Prescaler, 0 if the timer is stopped */
+	uint8 compareMode;
+	uint32 counts;					/* Timer counts of one period */
+	uint8 interruptEnabled;
+	uint8 flag;						/* TIFR bit */
+	void (*vector_Ptr)(void);
+}PORT_TimerSettingType;
+
+typedef struct{
+	PORT_TimerSettingType setting;	/* Settings of the running period */
+	uint8 running;
+	uint64 period_us;
+	uint64 nextTick_us;
+}PORT_TimerType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+volatile uint8 PORT_g_io[PORT_HOST_IO_SIZE];
+volatile uint16 PORT_g_tcnt1;
+volatile uint16 PORT_g_ocr1a;
+volatile uint16 PORT_g_ocr1b;
+volatile uint16 PORT_g_icr1;
+
+/* The I-bit: held by the peripherals thread while it runs the ISRs. The mutex is not fair,
+ * the application gives it up to a waiting interrupt (a main loop polling UART_getTime takes
+ * it all the time) */
+static pthread_mutex_t g_interruptLock = PTHREAD_MUTEX_INITIALIZER;
+static volatile uint8 g_interruptWaiting = FALSE;
+
+/*
+ * Wait for interrupt: a wait loop of the application (it reads the time in a critical
+ * section) sleeps until the next run of the peripherals, instead of taking the CPU from the
+ * other ECU. A queued UDRE/TXC interrupt wakes the peripherals thread up (g_kickFd).
+ */
+static pthread_mutex_t g_runLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_runDone = PTHREAD_COND_INITIALIZER;
+static volatile uint32 g_runs = 0;
+static volatile uint32 g_interrupts = 0;	/* ISRs run, the sleeps wait for the next one */
+static int g_kickFd = -1;
+static __thread uint32 t_lastRun = 0;
+static __thread uint8 t_idleCalls = 0;
+static __thread uint8 t_lockHeld = FALSE;
+static __thread uint8 t_inInterrupt = FALSE;
+
+/* USART, the RX ISR (peripherals thread) and the polling mode (application) take the bytes */
+static pthread_mutex_t g_usartLock = PTHREAD_MUTEX_INITIALIZER;
+static int g_uartFd = -1;
+static uint8 g_rxBuffer[PORT_UART_READ_SIZE];
+static uint8 g_rxHead = 0;
+static uint8 g_rxTail = 0;
+static uint8 g_rxData = 0;
+
+/* TWI and EEPROM */
+static PORT_TwiStateType g_twiState = PORT_TWI_IDLE;
+static uint8 g_twiBlock = 0;
+static uint16 g_twiAddress = 0;
+static uint8 g_eeprom[PORT_EEPROM_SIZE];
+static uint8 g_eepromLoaded = FALSE;
+static int g_eepromFd = -1;
+
+/* Timers */
+static PORT_TimerType g_timers[PORT_NUM_OF_TIMERS];
+static const uint16 g_timer01Divisor[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+static const uint16 g_timer2Divisor[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+/* Interrupt vectors, defined by the drivers built in the program (ISR) */
+extern void USART_RXC_vect(void) __attribute__((weak));
+extern void USART_UDRE_vect(void) __attribute__((weak));
+extern void USART_TXC_vect(void) __attribute__((weak));
+extern void TIMER0_OVF_vect(void) __attribute__((weak));
+extern void TIMER0_COMP_vect(void) __attribute__((weak));
+extern void TIMER1_OVF_vect(void) __attribute__((weak));
+extern void TIMER1_COMPA_vect(void) __attribute__((weak));
+extern void TIMER2_OVF_vect(void) __attribute__((weak));
+extern void TIMER2_COMP_vect(void) __attribute__((weak));
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/* Open the terminal device of the USART (usart lock held) */
+static void PORT_usartOpen(void)
+{
+	const char *device = getenv(PORT_UART_DEVICE_ENV);
+	struct termios settings;
+
+	if(device == NULL)
+	{
+		fprintf(stderr, "%s is not set\n", PORT_UART_DEVICE_ENV);
+		exit(EXIT_FAILURE);
+	}
+
+	g_uartFd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if(g_uartFd < 0)
+	{
+		perror(device);
+		exit(EXIT_FAILURE);
+	}
+
+	/* Raw bytes, no echo and no line editing, the frames are binary */
+	if(tcgetattr(g_uartFd, &settings) == 0)
+	{
+		cfmakeraw(&settings);
+		tcsetattr(g_uartFd, TCSANOW, &settings);
+	}
+}
+
+/* Put the next received byte in UDR if it is empty (usart lock held) */
+static void PORT_usartLoadByte(void)
+{
+	ssize_t count;
+
+	if((g_uartFd < 0) || (UCSRA & PORT_BIT(RXC)))
+	{
+		return;
+	}
+
+	if(g_rxHead == g_rxTail)
+	{
+		count = read(g_uartFd, g_rxBuffer, PORT_UART_READ_SIZE);
+		if(count <= 0)
+		{
+			if((count == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+			{
+				exit(EXIT_SUCCESS); /* The other side of the link is closed */
+			}
+			return;
+		}
+		g_rxHead = (uint8)count;
+		g_rxTail = 0;
+	}
+
+	g_rxData = g_rxBuffer[g_rxTail];
+	g_rxTail++;
+	UCSRA |= PORT_BIT(RXC);
+}
+
+/* The byte is sent at once: UDR is empty again and the transmission is complete */
+static void PORT_usartSend(uint8 data)
+{
+	struct pollfd out;
+
+	pthread_mutex_lock(&g_usartLock);
+	if(g_uartFd < 0)
+	{
+		PORT_usartOpen();
+	}
+	out.fd = g_uartFd;
+	out.events = POLLOUT;
+
+	while(write(g_uartFd, &data, 1) != 1)
+	{
+		if((errno != EAGAIN) && (errno != EINTR))
+		{
+			exit(EXIT_SUCCESS); /* The other side of the link is closed */
+		}
+		poll(&out, 1, PORT_UART_WRITE_WAIT_MS);
+	}
+	UCSRA |= PORT_BIT(TXC);
+	pthread_mutex_unlock(&g_usartLock);
+}
+
+/* RXC, UDRE and TXC interrupts (interrupt lock held), TRUE if an ISR ran */
+static uint8 PORT_runUsart(void)
+{
+	uint8 interrupted = FALSE;
+	uint8 calls;
+
+	pthread_mutex_lock(&g_usartLock);
+	if((UCSRB & (PORT_BIT(RXEN) | PORT_BIT(TXEN))) && (g_uartFd < 0))
+	{
+		PORT_usartOpen();
+	}
+	if(UCSRB & PORT_BIT(RXEN))
+	{
+		PORT_usartLoadByte();
+	}
+	pthread_mutex_unlock(&g_usartLock);
+
+	/* The ISR reads UDR, the next byte is loaded at once */
+	while((UCSRA & PORT_BIT(RXC)) && (UCSRB & PORT_BIT(RXCIE)) && USART_RXC_vect)
+	{
+		USART_RXC_vect();
+		interrupted = TRUE;
+	}
+
+	/* UDR is always empty, the ISR runs until it disables UDRIE (bounded as on the target
+	 * the main loop would run one instruction between two calls) */
+	for(calls = 0; (calls < PORT_MAX_UDRE_CALLS) && (UCSRB & PORT_BIT(UDRIE)) && USART_UDRE_vect; calls++)
+	{
+		USART_UDRE_vect();
+		interrupted = TRUE;
+	}
+
+	if((UCSRA & PORT_BIT(TXC)) && (UCSRB & PORT_BIT(TXCIE)) && USART_TXC_vect)
+	{
+		/* TXC is cleared by the hardware when its ISR is executed */
+		pthread_mutex_lock(&g_usartLock);
+		UCSRA &= ~PORT_BIT(TXC);
+		pthread_mutex_unlock(&g_usartLock);
+		USART_TXC_vect();
+		interrupted = TRUE;
+	}
+	return interrupted;
+}
+
+/* Load the EEPROM from the file once, a missing or short file reads as erased */
+static void PORT_eepromLoad(void)
+{
+	const char *path = getenv(PORT_EEPROM_FILE_ENV);
+	uint16 i;
+
+	for(i = 0; i < PORT_EEPROM_SIZE; i++)
+	{
+		g_eeprom[i] = PORT_EEPROM_ERASED_VALUE;
+	}
+
+	if(path != NULL)
+	{
+		g_eepromFd = open(path, O_RDWR | O_CREAT, 0644);
+		if(g_eepromFd < 0)
+		{
+			perror(path);
+			exit(EXIT_FAILURE);
+		}
+		if(pread(g_eepromFd, g_eeprom, PORT_EEPROM_SIZE, 0) < 0)
+		{
+			perror(path);
+		}
+	}
+	g_eepromLoaded = TRUE;
+}
+
+/* The byte after the start and the device address, the 24C16 rolls over in the page */
+static uint8 PORT_twiTransfer(uint8 ack)
+{
+	uint8 data = TWDR;
+
+	switch(g_twiState)
+	{
+	case PORT_TWI_SLAVE_ADDRESS:
+		if((data & PORT_EEPROM_DEVICE_MASK) != PORT_EEPROM_DEVICE_ADDRESS)
+		{
+			g_twiState = PORT_TWI_NOT_ADDRESSED;
+			return (data & 1) ? PORT_TWI_MT_SLA_R_NACK : PORT_TWI_MT_SLA_W_NACK;
+		}
+		g_twiBlock = (data >> 1) & 0x07;
+		if(data & 1)
+		{
+			g_twiState = PORT_TWI_READ;
+			return PORT_TWI_MT_SLA_R_ACK;
+		}
+		g_twiState = PORT_TWI_WORD_ADDRESS;
+		return PORT_TWI_MT_SLA_W_ACK;
+
+	case PORT_TWI_WORD_ADDRESS:
+		g_twiAddress = ((uint16)g_twiBlock << 8) | data;
+		g_twiState = PORT_TWI_WRITE;
+		return PORT_TWI_MT_DATA_ACK;
+
+	case PORT_TWI_WRITE:
+		g_eeprom[g_twiAddress] = data;
+		if((g_eepromFd >= 0) && (pwrite(g_eepromFd, &data, 1, g_twiAddress) != 1))
+		{
+			perror(PORT_EEPROM_FILE_ENV);
+		}
+		g_twiAddress = (g_twiAddress & ~(PORT_EEPROM_PAGE_SIZE - 1))
+				| ((g_twiAddress + 1) & (PORT_EEPROM_PAGE_SIZE - 1));
+		return PORT_TWI_MT_DATA_ACK;
+
+	case PORT_TWI_READ:
+		TWDR = g_eeprom[g_twiAddress];
+		g_twiAddress = (g_twiAddress + 1) & (PORT_EEPROM_SIZE - 1);
+		return ack ? PORT_TWI_MR_DATA_ACK : PORT_TWI_MR_DATA_NACK;
+
+	default:
+		return PORT_TWI_NO_STATE;
+	}
+}
+
+/* Writing TWINT starts the TWI operation, it is done at once (TWINT is set again) */
+static void PORT_twiOperation(uint8 value)
+{
+	uint8 status;
+
+	if(!(value & PORT_BIT(TWINT)) || !(value & PORT_BIT(TWEN)))
+	{
+		TWCR = value;
+		return;
+	}
+
+	if(g_eepromLoaded == FALSE)
+	{
+		PORT_eepromLoad();
+	}
+
+	if(value & PORT_BIT(TWSTA))
+	{
+		status = (g_twiState == PORT_TWI_IDLE) ? PORT_TWI_START : PORT_TWI_REP_START;
+		g_twiState = PORT_TWI_SLAVE_ADDRESS;
+	}
+	else if(value & PORT_BIT(TWSTO))
+	{
+		/* The stop condition doesn't set TWINT, TWSTO is cleared when it is sent */
+		g_twiState = PORT_TWI_IDLE;
+		TWSR = (TWSR & ~PORT_TWI_STATUS_MASK) | PORT_TWI_NO_STATE;
+		TWCR = value & ~(PORT_BIT(TWINT) | PORT_BIT(TWSTO));
+		return;
+	}
+	else
+	{
+		status = PORT_twiTransfer(value & PORT_BIT(TWEA));
+	}
+
+	TWSR = (TWSR & ~PORT_TWI_STATUS_MASK) | status;
+	TWCR = value;
+}
+
+/* Read the settings of a timer from its registers */
+static void PORT_getTimerSetting(uint8 id, PORT_TimerSettingType *Setting_Ptr)
+{
+	switch(id)
+	{
+	case 0:
+		Setting_Ptr->divisor = g_timer01Divisor[TCCR0 & 0x07];
+		Setting_Ptr->compareMode = (TCCR0 & PORT_BIT(WGM01)) ? TRUE : FALSE;
+		Setting_Ptr->counts = Setting_Ptr->compareMode ? ((uint32)OCR0 + 1) : (256UL - TCNT0);
+		Setting_Ptr->interruptEnabled = Setting_Ptr->compareMode ?
+				(TIMSK & PORT_BIT(OCIE0)) : (TIMSK & PORT_BIT(TOIE0));
+		Setting_Ptr->flag = Setting_Ptr->compareMode ? PORT_BIT(OCF0) : PORT_BIT(TOV0);
+		Setting_Ptr->vector_Ptr = Setting_Ptr->compareMode ? TIMER0_COMP_vect : TIMER0_OVF_vect;
+		break;
+	case 1:
+		Setting_Ptr->divisor = g_timer01Divisor[TCCR1B & 0x07];
+		Setting_Ptr->compareMode = (TCCR1B & PORT_BIT(WGM12)) ? TRUE : FALSE;
+		Setting_Ptr->counts = Setting_Ptr->compareMode ? ((uint32)OCR1A + 1) : (65536UL - TCNT1);
+		Setting_Ptr->interruptEnabled = Setting_Ptr->compareMode ?
+				(TIMSK & PORT_BIT(OCIE1A)) : (TIMSK & PORT_BIT(TOIE1));
+		Setting_Ptr->flag = Setting_Ptr->compareMode ? PORT_BIT(OCF1A) : PORT_BIT(TOV1);
+		Setting_Ptr->vector_Ptr = Setting_Ptr->compareMode ? TIMER1_COMPA_vect : TIMER1_OVF_vect;
+		break;
+	default:
+		Setting_Ptr->divisor = g_timer2Divisor[TCCR2 & 0x07];
+		Setting_Ptr->compareMode = (TCCR2 & PORT_BIT(WGM21)) ? TRUE : FALSE;
+		Setting_Ptr->counts = Setting_Ptr->compareMode ? ((uint32)OCR2 + 1) : (256UL - TCNT2);
+		Setting_Ptr->interruptEnabled = Setting_Ptr->compareMode ?
+				(TIMSK & PORT_BIT(OCIE2)) : (TIMSK & PORT_BIT(TOIE2));
+		Setting_Ptr->flag = Setting_Ptr->compareMode ? PORT_BIT(OCF2) : PORT_BIT(TOV2);
+		Setting_Ptr->vector_Ptr = Setting_Ptr->compareMode ? TIMER2_COMP_vect : TIMER2_OVF_vect;
+		break;
+	}
+}
+
+/* Counter of a timer in compare mode (in the normal mode it is the reload value) */
+static void PORT_setTimerCounter(uint8 id, uint16 counter)
+{
+	switch(id)
+	{
+	case 0:
+		TCNT0 = (uint8)counter;
+		break;
+	case 1:
+		TCNT1 = counter;
+		break;
+	default:
+		TCNT2 = (uint8)counter;
+		break;
+	}
+}
+
+/* Deliver the timer interrupts due until now_us (interrupt lock held), TRUE if an ISR ran */
+static uint8 PORT_runTimers(uint64 now_us)
+{
+	PORT_TimerSettingType setting;
+	PORT_TimerType *timer_Ptr;
+	uint8 interrupted = FALSE;
+	uint8 active = FALSE;
+	uint8 id;
+	uint64 start_us;
+
+	for(id = 0; id < PORT_NUM_OF_TIMERS; id++)
+	{
+		timer_Ptr = &g_timers[id];
+		PORT_getTimerSetting(id, &setting);
+
+		if(setting.divisor == 0)
+		{
+			timer_Ptr->running = FALSE;	/* No clock source */
+			continue;
+		}
+
+		/* A new period starts when the timer is started or set again, a new compare value
+		 * ends the running period (the counter goes on) */
+		if((timer_Ptr->running == FALSE) || (setting.divisor != timer_Ptr->setting.divisor)
+				|| (setting.compareMode != timer_Ptr->setting.compareMode)
+				|| (setting.counts != timer_Ptr->setting.counts))
+		{
+			start_us = ((timer_Ptr->running == TRUE) && (setting.compareMode == TRUE)
+					&& (setting.divisor == timer_Ptr->setting.divisor)
+					&& (setting.compareMode == timer_Ptr->setting.compareMode)) ?
+					(timer_Ptr->nextTick_us - timer_Ptr->period_us) : now_us;
+			timer_Ptr->setting = setting;
+			timer_Ptr->running = TRUE;
+			timer_Ptr->period_us = ((uint64)setting.counts * setting.divisor * 1000000ULL) / F_CPU;
+			if(timer_Ptr->period_us == 0)
+			{
+				timer_Ptr->period_us = 1;
+			}
+			/* A compare value the counter already passed ends the period at once (the
+			 * target would count up to the top and wrap around first) */
+			timer_Ptr->nextTick_us = start_us + timer_Ptr->period_us;
+		}
+		active = TRUE;
+
+		/* Deliver all the ticks due, a delay may have skipped many periods */
+		while(timer_Ptr->nextTick_us <= now_us)
+		{
+			if(setting.interruptEnabled && setting.vector_Ptr)
+			{
+				(*setting.vector_Ptr)();
+				interrupted = TRUE;
+			}
+			else
+			{
+				TIFR |= setting.flag;
+			}
+			timer_Ptr->nextTick_us += timer_Ptr->period_us;
+		}
+
+		if(setting.compareMode == TRUE)
+		{
+			/* Counts of the running period, read by the application (up to 1 run late) */
+			PORT_setTimerCounter(id, (uint16)(((now_us + timer_Ptr->period_us - timer_Ptr->nextTick_us)
+					* (F_CPU / 1000000UL)) / setting.divisor));
+		}
+	}
+
+	SIM_setTimerActive(active);
+	return interrupted;
+}
+
+/* The peripherals thread, everything it runs is in interrupt context */
+static void *PORT_thread(void *arg_Ptr)
+{
+	struct timespec wait = {0, PORT_THREAD_WAIT_NS};
+	struct pollfd in[2];
+	uint64 kicks;
+	uint64 now_us;
+
+	(void)arg_Ptr;
+	t_inInterrupt = TRUE;
+
+	while(1)
+	{
+		/* Until a byte is received, an interrupt is queued or the next run */
+		in[0].fd = g_uartFd;
+		in[0].events = POLLIN;
+		in[1].fd = g_kickFd;
+		in[1].events = POLLIN;
+		if((ppoll(in, 2, &wait, NULL) > 0) && (in[1].revents & POLLIN))
+		{
+			if(read(g_kickFd, &kicks, sizeof(kicks)) < 0)
+			{
+				perror("eventfd");
+			}
+		}
+
+		now_us = SIM_getTimeUs();
+		g_interruptWaiting = TRUE;
+		pthread_mutex_lock(&g_interruptLock);
+		g_interruptWaiting = FALSE;
+		if(SREG & PORT_BIT(SREG_I))
+		{
+			/* Both run, the USART ISRs don't hide the ticks due */
+			if(PORT_runUsart() | PORT_runTimers(now_us))
+			{
+				g_interrupts++;
+			}
+		}
+		pthread_mutex_unlock(&g_interruptLock);
+
+		/* The delays of the application wait for the ticks of the skipped time */
+		SIM_setTicksDelivered(now_us);
+
+		pthread_mutex_lock(&g_runLock);
+		g_runs++;
+		pthread_cond_broadcast(&g_runDone);
+		pthread_mutex_unlock(&g_runLock);
+	}
+	return NULL;
+}
+
+/* Reset values of the registers and start of the peripherals thread, before main */
+__attribute__((constructor)) static void PORT_init(void)
+{
+	pthread_t thread;
+
+	UCSRA = PORT_BIT(UDRE);
+	TWSR = PORT_TWI_NO_STATE;
+
+	g_kickFd = eventfd(0, EFD_NONBLOCK);
+	if(g_kickFd < 0)
+	{
+		perror("eventfd");
+		exit(EXIT_FAILURE);
+	}
+
+	if(pthread_create(&thread, NULL, PORT_thread, NULL) != 0)
+	{
+		perror("pthread_create");
+		exit(EXIT_FAILURE);
+	}
+	pthread_detach(thread);
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+uint8 PORT_hostRead(volatile uint8 *reg_Ptr)
+{
+	uint8 data;
+
+	if(reg_Ptr != &UDR)
+	{
+		return *reg_Ptr;
+	}
+
+	/* Reading UDR clears RXC, the next byte comes in */
+	pthread_mutex_lock(&g_usartLock);
+	data = g_rxData;
+	UCSRA &= ~PORT_BIT(RXC);
+	PORT_usartLoadByte();
+	pthread_mutex_unlock(&g_usartLock);
+	return data;
+}
+
+void PORT_hostWrite(volatile uint8 *reg_Ptr, uint8 value)
+{
+	uint8 flags;
+
+	if(reg_Ptr == &UDR)
+	{
+		PORT_usartSend(value);
+	}
+	else if(reg_Ptr == &UCSRA)
+	{
+		/* RXC and UDRE are read-only, TXC is cleared by writing one */
+		pthread_mutex_lock(&g_usartLock);
+		flags = UCSRA & (PORT_BIT(RXC) | PORT_BIT(UDRE));
+		if(!(value & PORT_BIT(TXC)))
+		{
+			flags |= UCSRA & PORT_BIT(TXC);
+		}
+		UCSRA = flags | (value & (PORT_BIT(U2X) | PORT_BIT(MPCM)));
+		pthread_mutex_unlock(&g_usartLock);
+	}
+	else if(reg_Ptr == &TWCR)
+	{
+		PORT_twiOperation(value);
+	}
+	else
+	{
+		*reg_Ptr = value;
+	}
+}
+
+uint8 PORT_hostDisableInterrupts(void)
+{
+	uint8 sreg;
+
+	if(t_inInterrupt == TRUE)
+	{
+		return SREG & ~PORT_BIT(SREG_I);	/* The I-bit is cleared in an ISR */
+	}
+
+	if(t_lockHeld == FALSE)
+	{
+		while(g_interruptWaiting == TRUE)
+		{
+			sched_yield();
+		}
+		pthread_mutex_lock(&g_interruptLock);
+		t_lockHeld = TRUE;
+	}
+	sreg = SREG;
+	SREG = sreg & ~PORT_BIT(SREG_I);
+	return sreg;
+}
+
+void PORT_hostRestoreInterrupts(uint8 sreg)
+{
+	if(t_inInterrupt == TRUE)
+	{
+		return;	/* The I-bit is set again at the end of the ISR */
+	}
+
+	uint64 kick = 1;
+
+	SREG = sreg;
+	if(t_lockHeld == TRUE)
+	{
+		t_lockHeld = FALSE;
+		pthread_mutex_unlock(&g_interruptLock);
+	}
+
+	/* The application queued a byte to send (UDRE) or waits for the end of the transmission */
+	if((UCSRB & PORT_BIT(UDRIE)) || ((UCSRB & PORT_BIT(TXCIE)) && (UCSRA & PORT_BIT(TXC))))
+	{
+		if(write(g_kickFd, &kick, sizeof(kick)) < 0)
+		{
+			perror("eventfd");
+		}
+	}
+
+	/* Wait for interrupt */
+	if(g_runs != t_lastRun)
+	{
+		t_lastRun = g_runs;
+		t_idleCalls = 0;
+	}
+	else if(++t_idleCalls >= PORT_IDLE_CALLS)
+	{
+		pthread_mutex_lock(&g_runLock);
+		while(g_runs == t_lastRun)
+		{
+			pthread_cond_wait(&g_runDone, &g_runLock);
+		}
+		pthread_mutex_unlock(&g_runLock);
+		t_lastRun = g_runs;
+		t_idleCalls = 0;
+	}
+}
+
+void PORT_hostSleep(void)
+{
+	uint32 interrupts = g_interrupts;	/* The I-bit is cleared, no ISR runs meanwhile */
+
+	SIM_setAsleep(TRUE);
+	PORT_hostRestoreInterrupts(SREG | PORT_BIT(SREG_I));
+
+	pthread_mutex_lock(&g_runLock);
+	while(g_interrupts == interrupts)
+	{
+		pthread_cond_wait(&g_runDone, &g_runLock);
+	}
+	pthread_mutex_unlock(&g_runLock);
+	SIM_setAsleep(FALSE);
+}
@@ -0,0 +1,181 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: sim_clock.c
+ *
+ * [Description]: Source file for the simulated clock of the host build
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include "sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_DELAY_POLL_US			20		/* Real time between two checks of the timer */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static SIM_SharedClockType g_localClock;
+static SIM_SharedClockType *g_clock_Ptr = &g_localClock;
+static pthread_once_t g_clockOnce = PTHREAD_ONCE_INIT;
+
+static volatile uint8 g_timerActive = FALSE;
+static volatile uint64 g_ticksDelivered_us = 0;
+
+/* Duty cycle of this process, kept in HOST_DUTY_FILE when it is set */
+static SIM_DutyCycleType g_localDutyCycle;
+static SIM_DutyCycleType *g_dutyCycle_Ptr = &g_localDutyCycle;
+static pthread_once_t g_dutyCycleOnce = PTHREAD_ONCE_INIT;
+static uint64 g_stateStart_us = 0;	/* Time of the last sleep or wake up, 0 before the first */
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+static uint64 SIM_realTimeNs(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64)now.tv_sec * 1000000000ULL) + (uint64)now.tv_nsec;
+}
+
+/*
+ * Map the shared clock file when HOST_CLOCK_FILE is set, otherwise start a clock local to
+ * this process
+ */
+static void SIM_clockInit(void)
+{
+	const char *path = getenv(SIM_CLOCK_FILE_ENV);
+	const char *speedup = getenv(SIM_SPEEDUP_ENV);
+	void *map_Ptr;
+	int fd;
+
+	if(path != NULL)
+	{
+		fd = open(path, O_RDWR);
+		if(fd < 0)
+		{
+			perror(path);
+			exit(EXIT_FAILURE);
+		}
+		map_Ptr = mmap(NULL, sizeof(SIM_SharedClockType), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if(map_Ptr == MAP_FAILED)
+		{
+			perror(path);
+			exit(EXIT_FAILURE);
+		}
+		g_clock_Ptr = (SIM_SharedClockType *)map_Ptr;
+		return;
+	}
+
+	g_localClock.start_ns = SIM_realTimeNs();
+	g_localClock.speedup = (speedup != NULL) ? (uint32)atoi(speedup) : SIM_DEFAULT_SPEEDUP;
+	if(g_localClock.speedup == 0)
+	{
+		g_localClock.speedup = 1;
+	}
+	g_localClock.skipped_us = 0;
+}
+
+/* Map the file of the duty cycle when HOST_DUTY_FILE is set */
+static void SIM_dutyCycleInit(void)
+{
+	const char *path = getenv(SIM_DUTY_FILE_ENV);
+	void *map_Ptr;
+	int fd;
+
+	if(path == NULL)
+	{
+		return;
+	}
+
+	fd = open(path, O_RDWR);
+	if(fd < 0)
+	{
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+	map_Ptr = mmap(NULL, sizeof(SIM_DutyCycleType), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map_Ptr == MAP_FAILED)
+	{
+		perror(path);
+		exit(EXIT_FAILURE);
+	}
+	g_dutyCycle_Ptr = (SIM_DutyCycleType *)map_Ptr;
+}
+
+uint64 SIM_getTimeUs(void)
+{
+	pthread_once(&g_clockOnce, SIM_clockInit);
+
+	return (((SIM_realTimeNs() - g_clock_Ptr->start_ns) / 1000ULL) * g_clock_Ptr->speedup)
+			+ __atomic_load_n(&g_clock_Ptr->skipped_us, __ATOMIC_SEQ_CST);
+}
+
+void SIM_delayUs(uint64 delay_us)
+{
+	uint64 target_us;
+
+	if(delay_us == 0)
+	{
+		return;	/* Sub-microsecond bus timing, also called in interrupt context */
+	}
+
+	pthread_once(&g_clockOnce, SIM_clockInit);
+
+	__atomic_add_fetch(&g_clock_Ptr->skipped_us, delay_us, __ATOMIC_SEQ_CST);
+	target_us = SIM_getTimeUs();
+
+	/* The ticks of the skipped time must be seen by the code after the delay */
+	while((g_timerActive == TRUE)
+			&& (__atomic_load_n(&g_ticksDelivered_us, __ATOMIC_ACQUIRE) < target_us))
+	{
+		usleep(SIM_DELAY_POLL_US);
+	}
+}
+
+void SIM_setTimerActive(uint8 active)
+{
+	g_timerActive = active;
+}
+
+void SIM_setTicksDelivered(uint64 time_us)
+{
+	__atomic_store_n(&g_ticksDelivered_us, time_us, __ATOMIC_RELEASE);
+}
+
+void SIM_setAsleep(uint8 asleep)
+{
+	uint64 now_us = SIM_getTimeUs();
+
+	pthread_once(&g_dutyCycleOnce, SIM_dutyCycleInit);
+
+	if(g_stateStart_us != 0)
+	{
+		if(asleep == TRUE)
+		{
+			g_dutyCycle_Ptr->awake_us += now_us - g_stateStart_us;
+		}
+		else
+		{
+			g_dutyCycle_Ptr->asleep_us += now_us - g_stateStart_us;
+			g_dutyCycle_Ptr->wakeUps++;
+		}
+	}
+	g_stateStart_us = now_us;
+}
@@ -0,0 +1,18 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: delay.h
+ *
+ * [Description]: Host replacement of the old avr-libc <avr/delay.h>
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_DELAY_H_
+#define HOST_AVR_DELAY_H_
+
+#include <util/delay.h>
+
+#endif /* HOST_AVR_DELAY_H_ */
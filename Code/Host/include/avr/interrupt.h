@@ -0,0 +1,19 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: interrupt.h
+ *
+ * [Description]: Host replacement of <avr/interrupt.h>, the interrupts of the simulated
+ * 				  ATmega16 (port_host.h)
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include "port_host.h"
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,19 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: io.h
+ *
+ * [Description]: Host replacement of <avr/io.h>, the registers of the simulated ATmega16
+ * 				  (port_host.h)
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include "port_host.h"
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,26 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: pgmspace.h
+ *
+ * [Description]: Host replacement of <avr/pgmspace.h>: one address space, the flash data is
+ * 				  plain constant data read through the pointers
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_AVR_PGMSPACE_H_
+#define HOST_AVR_PGMSPACE_H_
+
+#include "std_types.h"
+
+#define PROGMEM
+#define PGM_P							const char *
+#define PSTR(STR)						(STR)
+#define pgm_read_byte(ADDRESS)			(*(const uint8 *)(ADDRESS))
+#define pgm_read_word(ADDRESS)			(*(const uint16 *)(ADDRESS))
+#define pgm_read_ptr(ADDRESS)			(*(const void * const *)(ADDRESS))
+
+#endif /* HOST_AVR_PGMSPACE_H_ */
@@ -0,0 +1,338 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: port_host.h
+ *
+ * [Description]: Linux backend of the port layer (port.h): a simulated ATmega16 for the
+ * 				  drivers of the ECUs. The registers are a register file at their ATmega16
+ * 				  addresses, the interrupts are called by a thread of port_host.c that plays
+ * 				  the peripherals:
+ * 				  - USART: over a terminal device (HOST_UART_DEVICE), the bytes are sent at
+ * 				    once (no baud rate) and the 9th bit is not carried.
+ * 				  - TWI: a 24C16 EEPROM (2 KB) at the addresses 0xA0-0xAF, kept in
+ * 				    HOST_EEPROM_FILE when set.
+ * 				  - Timers 0, 1 and 2: normal and compare modes on the simulated clock.
+ * 				  - Sleep: the CPU waits for the next interrupt, the simulated time asleep
+ * 				    is counted for the duty cycle (sim_clock.h).
+ * 				  The I-bit of SREG is a lock, a critical section holds off the thread.
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef PORT_HOST_H_
+#define PORT_HOST_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PORT_HOST_IO_SIZE			0x60	/* Data addresses of the 64 I/O registers */
+
+/* Registers of the register file, at their data address (I/O address + 0x20) */
+#define PORT_SFR_IO8(IO_ADDRESS)	(PORT_g_io[(IO_ADDRESS) + 0x20])
+
+#define TWBR		PORT_SFR_IO8(0x00)
+#define TWSR		PORT_SFR_IO8(0x01)
+#define TWAR		PORT_SFR_IO8(0x02)
+#define TWDR		PORT_SFR_IO8(0x03)
+#define UBRRL		PORT_SFR_IO8(0x09)
+#define UCSRB		PORT_SFR_IO8(0x0A)
+#define UCSRA		PORT_SFR_IO8(0x0B)
+#define UDR			PORT_SFR_IO8(0x0C)
+#define PIND		PORT_SFR_IO8(0x10)
+#define DDRD		PORT_SFR_IO8(0x11)
+#define PORTD		PORT_SFR_IO8(0x12)
+#define PINC		PORT_SFR_IO8(0x13)
+#define DDRC		PORT_SFR_IO8(0x14)
+#define PORTC		PORT_SFR_IO8(0x15)
+#define PINB		PORT_SFR_IO8(0x16)
+#define DDRB		PORT_SFR_IO8(0x17)
+#define PORTB		PORT_SFR_IO8(0x18)
+#define PINA		PORT_SFR_IO8(0x19)
+#define DDRA		PORT_SFR_IO8(0x1A)
+#define PORTA		PORT_SFR_IO8(0x1B)
+#define UBRRH		PORT_SFR_IO8(0x20)
+#define UCSRC		PORT_SFR_IO8(0x20)	/* Same address as UBRRH, selected by URSEL */
+#define OCR2		PORT_SFR_IO8(0x23)
+#define TCNT2		PORT_SFR_IO8(0x24)
+#define TCCR2		PORT_SFR_IO8(0x25)
+#define TCCR1B		PORT_SFR_IO8(0x2E)
+#define TCCR1A		PORT_SFR_IO8(0x2F)
+#define TCNT0		PORT_SFR_IO8(0x32)
+#define TCCR0		PORT_SFR_IO8(0x33)
+#define TWCR		PORT_SFR_IO8(0x36)
+#define TIFR		PORT_SFR_IO8(0x38)
+#define TIMSK		PORT_SFR_IO8(0x39)
+#define OCR0		PORT_SFR_IO8(0x3C)
+#define SREG		PORT_SFR_IO8(0x3F)
+
+/* The 16-bit registers of Timer1 are kept out of the byte register file */
+#define TCNT1		PORT_g_tcnt1
+#define OCR1A		PORT_g_ocr1a
+#define OCR1B		PORT_g_ocr1b
+#define ICR1		PORT_g_icr1
+
+/* SREG */
+#define SREG_I		7
+
+/* UCSRA */
+#define RXC			7
+#define TXC			6
+#define UDRE		5
+#define FE			4
+#define DOR			3
+#define PE			2
+#define U2X			1
+#define MPCM		0
+
+/* UCSRB */
+#define RXCIE		7
+#define TXCIE		6
+#define UDRIE		5
+#define RXEN		4
+#define TXEN		3
+#define UCSZ2		2
+#define RXB8		1
+#define TXB8		0
+
+/* UCSRC */
+#define URSEL		7
+#define UMSEL		6
+#define UPM1		5
+#define UPM0		4
+#define USBS		3
+#define UCSZ1		2
+#define UCSZ0		1
+#define UCPOL		0
+
+/* TWCR */
+#define TWINT		7
+#define TWEA		6
+#define TWSTA		5
+#define TWSTO		4
+#define TWWC		3
+#define TWEN		2
+#define TWIE		0
+
+/* TWSR */
+#define TWPS1		1
+#define TWPS0		0
+
+/* TIMSK */
+#define OCIE2		7
+#define TOIE2		6
+#define TICIE1		5
+#define OCIE1A		4
+#define OCIE1B		3
+#define TOIE1		2
+#define OCIE0		1
+#define TOIE0		0
+
+/* TIFR */
+#define OCF2		7
+#define TOV2		6
+#define ICF1		5
+#define OCF1A		4
+#define OCF1B		3
+#define TOV1		2
+#define OCF0		1
+#define TOV0		0
+
+/* TCCR0 */
+#define FOC0		7
+#define WGM00		6
+#define COM01		5
+#define COM00		4
+#define WGM01		3
+#define CS02		2
+#define CS01		1
+#define CS00		0
+
+/* TCCR1A */
+#define COM1A1		7
+#define COM1A0		6
+#define COM1B1		5
+#define COM1B0		4
+#define FOC1A		3
+#define FOC1B		2
+#define WGM11		1
+#define WGM10		0
+
+/* TCCR1B */
+#define ICNC1		7
+#define ICES1		6
+#define WGM13		4
+#define WGM12		3
+#define CS12		2
+#define CS11		1
+#define CS10		0
+
+/* TCCR2 */
+#define FOC2		7
+#define WGM20		6
+#define COM21		5
+#define COM20		4
+#define WGM21		3
+#define CS22		2
+#define CS21		1
+#define CS20		0
+
+/* Pins */
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+/* Port layer (port.h) */
+#define PORT_READ_REG(REG)				PORT_hostRead(&(REG))
+#define PORT_WRITE_REG(REG,VALUE)		PORT_hostWrite(&(REG), (uint8)(VALUE))
+#define PORT_ENTER_CRITICAL(STATE)		((STATE) = PORT_hostDisableInterrupts())
+#define PORT_EXIT_CRITICAL(STATE)		PORT_hostRestoreInterrupts(STATE)
+#define PORT_SLEEP(MODE)				PORT_hostSleep()
+
+/* <avr/sleep.h>, all the modes wait for the next interrupt */
+#define SLEEP_MODE_IDLE					0
+#define SLEEP_MODE_ADC					1
+#define SLEEP_MODE_PWR_DOWN				2
+#define SLEEP_MODE_PWR_SAVE				3
+
+/* <avr/interrupt.h>, the vectors are functions called by the peripherals thread */
+#define ISR(VECTOR)						void VECTOR(void)
+#define cli()							((void)PORT_hostDisableInterrupts())
+#define sei()							PORT_hostRestoreInterrupts(SREG | (1<<SREG_I))
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+extern volatile uint8 PORT_g_io[PORT_HOST_IO_SIZE];
+extern volatile uint16 PORT_g_tcnt1;
+extern volatile uint16 PORT_g_ocr1a;
+extern volatile uint16 PORT_g_ocr1b;
+extern volatile uint16 PORT_g_icr1;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/********************************************************************************************
+ *
+ * [Function Name]: PORT_hostRead
+ *
+ * [Description]: Read a register with a side effect (UDR: the received byte is taken).
+ *
+ * [Arguments]: volatile uint8 *reg_Ptr
+ *
+ * [in]: reg_Ptr: Pointer to the register in the register file
+ *
+ * [out]: Unsigned Character
+ *
+ * [Returns]: The register value
+ *
+ ********************************************************************************************/
+uint8 PORT_hostRead(volatile uint8 *reg_Ptr);
+
+/********************************************************************************************
+ *
+ * [Function Name]: PORT_hostWrite
+ *
+ * [Description]: Write a register with a side effect (UDR: the byte is sent, UCSRA: the
+ * 				  flags are read-only or cleared by writing one, TWCR: the TWI operation is
+ * 				  done at once).
+ *
+ * [Arguments]: volatile uint8 *reg_Ptr, uint8 value
+ *
+ * [in]: - reg_Ptr: Pointer to the register in the register file
+ * 		 - value: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void PORT_hostWrite(volatile uint8 *reg_Ptr, uint8 value);
+
+/********************************************************************************************
+ *
+ * [Function Name]: PORT_hostDisableInterrupts
+ *
+ * [Description]: Clear the I-bit and hold off the interrupts (the peripherals thread) until
+ * 				  PORT_hostRestoreInterrupts, nothing to do inside an interrupt.
+ *
+ * [Arguments]: void
+ *
+ * [in]: void
+ *
+ * [out]: Unsigned Character
+ *
+ * [Returns]: SREG before the call
+ *
+ ********************************************************************************************/
+uint8 PORT_hostDisableInterrupts(void);
+
+/********************************************************************************************
+ *
+ * [Function Name]: PORT_hostRestoreInterrupts
+ *
+ * [Description]: Write SREG (the I-bit) and let the interrupts run again.
+ *
+ * [Arguments]: uint8 sreg
+ *
+ * [in]: sreg: SREG value of PORT_hostDisableInterrupts
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void PORT_hostRestoreInterrupts(uint8 sreg);
+
+/********************************************************************************************
+ *
+ * [Function Name]: PORT_hostSleep
+ *
+ * [Description]: Enable the interrupts and wait until the peripherals thread runs an ISR, the
+ * 				  interrupts that came after PORT_hostDisableInterrupts wake it at once.
+ *
+ * [Arguments]: void
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void PORT_hostSleep(void);
+
+#endif /* PORT_HOST_H_ */
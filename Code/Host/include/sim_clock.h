@@ -0,0 +1,145 @@
+ /******************************************************************************
+ *
+ * [Module]: Host HAL
+ *
+ * [File Name]: sim_clock.h
+ *
+ * [Description]: Simulated clock of the host build of the ECUs. It runs HOST_CLOCK_SPEEDUP
+ * 				  times faster than the real time, and the busy-wait delays (_delay_ms) jump
+ * 				  it forward instead of sleeping, so the seconds long LCD messages and
+ * 				  debouncing delays of the firmware cost nothing on the host.
+ * 				  When HOST_CLOCK_FILE is set, the clock is kept in that file and shared by
+ * 				  all the processes that map it (both ECUs see the same world time).
+ * 				  When HOST_DUTY_FILE is set, the simulated time the ECU spends asleep and
+ * 				  awake is counted in that file (active duty cycle of the sleep modes).
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef SIM_CLOCK_H_
+#define SIM_CLOCK_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_DEFAULT_SPEEDUP			10
+#define SIM_CLOCK_FILE_ENV			"HOST_CLOCK_FILE"
+#define SIM_SPEEDUP_ENV				"HOST_CLOCK_SPEEDUP"
+#define SIM_DUTY_FILE_ENV			"HOST_DUTY_FILE"
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+
+/* Layout of the shared clock file */
+typedef struct{
+	uint64 start_ns;		/* CLOCK_MONOTONIC time of the simulated time 0 */
+	uint32 speedup;			/* Simulated microseconds per real microsecond */
+	uint32 reserved;
+	uint64 skipped_us;		/* Sum of all the delays of all the processes */
+}SIM_SharedClockType;
+
+/* Layout of the duty cycle file of one ECU, counted from its first sleep */
+typedef struct{
+	uint64 awake_us;		/* Simulated time between a wake up and the next sleep */
+	uint64 asleep_us;		/* Simulated time from a sleep to the next wake up */
+	uint64 wakeUps;
+}SIM_DutyCycleType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/********************************************************************************************
+ *
+ * [Function Name]: SIM_getTimeUs
+ *
+ * [Description]: Return the simulated time in microseconds.
+ *
+ * [Arguments]: void
+ *
+ * [in]: void
+ *
+ * [out]: void
+ *
+ * [Returns]: uint64
+ *
+ ********************************************************************************************/
+uint64 SIM_getTimeUs(void);
+
+/********************************************************************************************
+ *
+ * [Function Name]: SIM_delayUs
+ *
+ * [Description]: Jump the simulated clock forward, then wait until the timer of this process
+ * 				  delivered all the ticks due until the new time (as a busy-wait delay does
+ * 				  not block the timer interrupt).
+ *
+ * [Arguments]: uint64 delay_us
+ *
+ * [in]: delay_us: Unsigned Long Long
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void SIM_delayUs(uint64 delay_us);
+
+/********************************************************************************************
+ *
+ * [Function Name]: SIM_setTimerActive
+ *
+ * [Description]: Inform the clock that the timer thread of this process is running (TRUE)
+ * 				  or stopped (FALSE), the delays only wait for a running timer.
+ *
+ * [Arguments]: uint8 active
+ *
+ * [in]: active: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void SIM_setTimerActive(uint8 active);
+
+/********************************************************************************************
+ *
+ * [Function Name]: SIM_setTicksDelivered
+ *
+ * [Description]: Called by the timer thread after delivering all the ticks due until time_us.
+ *
+ * [Arguments]: uint64 time_us
+ *
+ * [in]: time_us: Unsigned Long Long
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void SIM_setTicksDelivered(uint64 time_us);
+
+/********************************************************************************************
+ *
+ * [Function Name]: SIM_setAsleep
+ *
+ * [Description]: Called by the port layer when the CPU goes to sleep (TRUE) and when it wakes
+ * 				  up (FALSE), the simulated time of each state is added to the duty cycle.
+ *
+ * [Arguments]: uint8 asleep
+ *
+ * [in]: asleep: Unsigned Character
+ *
+ * [out]: void
+ *
+ * [Returns]: void
+ *
+ ********************************************************************************************/
+void SIM_setAsleep(uint8 asleep);
+
+#endif /* SIM_CLOCK_H_ */
@@ -0,0 +1,23 @@
+ /******************************************************************************
+ *
+ * [Module]: Host Tools
+ *
+ * [File Name]: delay.h
+ *
+ * [Description]: Host replacement of the avr-libc busy-wait delays, so the shared
+ * 				  firmware modules can be compiled in the host tools. The delays jump the
+ * 				  simulated clock (sim_clock.h) instead of sleeping
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#ifndef HOST_UTIL_DELAY_H_
+#define HOST_UTIL_DELAY_H_
+
+#include "sim_clock.h"
+
+#define _delay_ms(MS)		SIM_delayUs((uint64)(MS) * 1000ULL)
+#define _delay_us(US)		SIM_delayUs((uint64)(US))
+
+#endif /* HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,216 @@
+ /******************************************************************************
+ *
+ * [Module]: Host Tools
+ *
+ * [File Name]: keypad_benchmark.c
+ *
+ * [Description]: Host-side benchmark of the keypad scan: full-matrix scans per second of
+ * 				  - the legacy blocking scan of KEYPAD_getPressedKey (one pass over the
+ * 				    columns with the GPIO functions: direction of the port and of the column
+ * 				    pin, port value, then every row pin read),
+ * 				  - the column-per-tick scan before the scan tables (GPIO macros, direction
+ * 				    and value of the port for every column, every key debounced),
+ * 				  - the firmware KEYPAD_tick (keypad.c as it is: one DDR store per column,
+ * 				    one port read, only the columns with keys not at rest debounced).
+ * 				  A full-matrix scan is KEYPAD_NUM_COLS ticks. The keypad port is the
+ * 				  register file of the simulated ATmega16, PINB is set by the benchmark
+ * 				  (no key, or the first row held in all the columns).
+ * 				  The host CPU is not an AVR: the ratios are meaningful, not the rates.
+ *
+ * 				  Build and run (from Code/Host):
+ * 				  make keypad_benchmark
+ * 				  ./keypad_benchmark [scans]
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "std_types.h"
+#include "gpio.h"
+#include "keypad.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define DEFAULT_SCANS				2000000
+#define NO_KEY_PIN_VALUE			0xFF	/* Rows pulled up */
+#define ROW_HELD_PIN_VALUE			0xFE	/* First row low in every column */
+
+/* Debouncing state of the legacy tick scan (same as keypad.c) */
+#define LEGACY_STATE_PRESSED		0x80
+#define LEGACY_STATE_INTEGRATOR_MASK	0x7F
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint8 g_legacyColumn = 0;
+static uint8 g_legacyKeyState[KEYPAD_NUM_KEYS];
+static volatile uint8 g_legacyEvents = 0;
+static volatile uint8 g_legacyKey = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/* One pass of the legacy blocking scan (the body of the KEYPAD_getPressedKey loop) */
+static void Legacy_blockingScan(void)
+{
+	uint8 col, row;
+	uint8 keypad_port_value;
+
+	for(col = 0; col < KEYPAD_NUM_COLS; col++)
+	{
+		GPIO_setupPortDirection(KEYPAD_PORT_ID, PORT_INPUT);
+		GPIO_setupPinDirection(KEYPAD_PORT_ID, KEYPAD_FIRST_COLUMN_PIN_ID + col, PIN_OUTPUT);
+		keypad_port_value = ~(1 << (KEYPAD_FIRST_COLUMN_PIN_ID + col));
+		GPIO_writePort(KEYPAD_PORT_ID, keypad_port_value);
+
+		for(row = 0; row < KEYPAD_NUM_ROWS; row++)
+		{
+			if(GPIO_readPin(KEYPAD_PORT_ID, row + KEYPAD_FIRST_ROW_PIN_ID) == KEYPAD_BUTTON_PRESSED)
+			{
+				g_legacyKey = (row * KEYPAD_NUM_COLS) + col + 1;
+			}
+		}
+	}
+}
+
+/* Debouncing of the tick scan before the scan tables */
+static void Legacy_debounce(uint8 key_number, uint8 isPressed)
+{
+	uint8 state = g_legacyKeyState[key_number];
+	uint8 integrator = state & LEGACY_STATE_INTEGRATOR_MASK;
+
+	if(isPressed == TRUE)
+	{
+		if(integrator < KEYPAD_DEBOUNCE_SAMPLES)
+		{
+			integrator++;
+		}
+		if((integrator == KEYPAD_DEBOUNCE_SAMPLES) && !(state & LEGACY_STATE_PRESSED))
+		{
+			state |= LEGACY_STATE_PRESSED;
+			g_legacyEvents++;
+		}
+	}
+	else
+	{
+		if(integrator > 0)
+		{
+			integrator--;
+		}
+		if((integrator == 0) && (state & LEGACY_STATE_PRESSED))
+		{
+			state &= ~LEGACY_STATE_PRESSED;
+			g_legacyEvents++;
+		}
+	}
+
+	g_legacyKeyState[key_number] = (state & LEGACY_STATE_PRESSED) | integrator;
+}
+
+/* One tick of the column-per-tick scan before the scan tables */
+static void Legacy_tick(void)
+{
+	uint8 row;
+	uint8 key_number = g_legacyColumn;
+	uint8 keypad_port_value;
+
+	for(row = 0; row < KEYPAD_NUM_ROWS; row++)
+	{
+		Legacy_debounce(key_number,
+				(GPIO_READ_PIN(KEYPAD_PORT_ID, row + KEYPAD_FIRST_ROW_PIN_ID) == KEYPAD_BUTTON_PRESSED) ? TRUE : FALSE);
+		key_number += KEYPAD_NUM_COLS;
+	}
+
+	g_legacyColumn++;
+	if(g_legacyColumn == KEYPAD_NUM_COLS)
+	{
+		g_legacyColumn = 0;
+	}
+	GPIO_SETUP_PORT_DIRECTION(KEYPAD_PORT_ID, PORT_INPUT);
+	GPIO_SETUP_PIN_DIRECTION(KEYPAD_PORT_ID, KEYPAD_FIRST_COLUMN_PIN_ID + g_legacyColumn, PIN_OUTPUT);
+	keypad_port_value = ~(1 << (KEYPAD_FIRST_COLUMN_PIN_ID + g_legacyColumn));
+	GPIO_WRITE_PORT(KEYPAD_PORT_ID, keypad_port_value);
+}
+
+static void Legacy_tickScan(void)
+{
+	uint8 col;
+
+	for(col = 0; col < KEYPAD_NUM_COLS; col++)
+	{
+		Legacy_tick();
+	}
+}
+
+static void Firmware_tickScan(void)
+{
+	uint8 col;
+
+	for(col = 0; col < KEYPAD_NUM_COLS; col++)
+	{
+		KEYPAD_tick();
+	}
+}
+
+/* Host time of one full-matrix scan in ns */
+static float64 measureScan_ns(void (*scan_Ptr)(void), uint8 pinValue, uint32 scans)
+{
+	struct timespec start, end;
+	KEYPAD_KeyEventType keyEvent;
+	uint32 i;
+
+	PINB = pinValue;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < scans; i++)
+	{
+		(*scan_Ptr)();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	while(KEYPAD_getEvent(&keyEvent) == TRUE)
+	{
+		/* Empty the queue for the next measure */
+	}
+
+	return (((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec)) / scans;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32 scans = (argc > 1) ? strtoul(argv[1], NULL, 10) : DEFAULT_SCANS;
+	void (*scans_Ptr[3])(void) = {Legacy_blockingScan, Legacy_tickScan, Firmware_tickScan};
+	const char *names[3] = {"legacy blocking scan", "tick scan (before)", "KEYPAD_tick (tables)"};
+	float64 idle_ns[3], held_ns[3];
+	uint8 i;
+
+	if(scans == 0)
+	{
+		fprintf(stderr, "usage: %s [scans]\n", argv[0]);
+		return 1;
+	}
+
+	KEYPAD_init();
+
+	printf("Keypad %ux%u, %lu full-matrix scans (%u ticks each) per measure\n\n",
+			KEYPAD_NUM_ROWS, KEYPAD_NUM_COLS, (unsigned long)scans, KEYPAD_NUM_COLS);
+	printf("%-24s | %-25s | %-25s\n", "", "no key", "first row held");
+	printf("%-24s | %10s %14s | %10s %14s\n", "scan", "ns/scan", "scans/s", "ns/scan", "scans/s");
+
+	for(i = 0; i < 3; i++)
+	{
+		idle_ns[i] = measureScan_ns(scans_Ptr[i], NO_KEY_PIN_VALUE, scans);
+		held_ns[i] = measureScan_ns(scans_Ptr[i], ROW_HELD_PIN_VALUE, scans);
+		printf("%-24s | %10.1f %14.0f | %10.1f %14.0f\n", names[i], idle_ns[i], 1e9 / idle_ns[i],
+				held_ns[i], 1e9 / held_ns[i]);
+	}
+
+	printf("\nKEYPAD_tick speedup over the tick scan before: %.2fx (no key), %.2fx (row held)\n",
+			idle_ns[1] / idle_ns[2], held_ns[1] / held_ns[2]);
+	return 0;
+}
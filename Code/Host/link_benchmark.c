@@ -0,0 +1,390 @@
+ /******************************************************************************
+ *
+ * [Module]: Host Tools
+ *
+ * [File Name]: link_benchmark.c
+ *
+ * [Description]: Host-side benchmark for the HMI <-> Control UART link.
+ * 				  It compares the legacy per-byte READY_TO_SEND/READY_TO_RECEIVE
+ * 				  handshake with the framed protocol (frame.c) by counting the bytes on
+ * 				  the wire, the direction turnarounds and the resulting end-to-end latency
+ * 				  for every transaction.
+ * 				  The framed side runs the real FRAME_send/FRAME_receive code against a
+ * 				  recorded wire (the ISR frame parser is replaced by a polled one), so the
+ * 				  numbers follow the firmware.
+ *
+ * 				  Expected results (default 9600 baud, 50 us turnaround):
+ * 				  - unlock: 17 bytes against 15, the 4 bytes of frame overhead and the sequence
+ * 				    number cost more than the handshake bytes of a short command. With one
+ * 				    turnaround instead of 11 it is still slower at 9600 baud (0.91x), even at
+ * 				    200 us turnaround (1.00x), and faster at the negotiated 115200 baud (1.21x).
+ * 				  - new password: 22 bytes against 26 and no 1 s delay of the HMI (88x).
+ *
+ * 				  Build and run (from Code/Host):
+ * 				  make link_benchmark	(or gcc -O2 -Iinclude -I../HMI_ECU -o link_benchmark link_benchmark.c
+ * 				  ../HMI_ECU/frame.c hal/sim_clock.c -lpthread)
+ * 				  ./link_benchmark [baud_rate] [turnaround_us]
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "std_types.h"
+#include "uart.h"
+#include "frame.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PASSWORD_LENGTH				5
+
+/* Bytes used by the legacy protocol (same values as hmi_ecu.h/control_ecu.h before framing) */
+#define LEGACY_READY_TO_SEND		0x10
+#define LEGACY_READY_TO_RECEIVE		0x20
+#define LEGACY_HMI_SEND_DELAY_MS	1000	/* _delay_ms(1000) after each new password */
+
+#define DOOR_OPEN_OPTION			43
+#define NEW_PASSWORD_OPTION			0x40
+#define OPEN_DOOR					0x25
+#define PASSWORD_MATCHED			1
+
+#define WIRE_MAX_BYTES				256
+#define DEFAULT_BAUD_RATE			9600
+#define DEFAULT_TURNAROUND_US		50		/* ISR + software reaction time of the other side */
+#define BITS_PER_BYTE_ON_WIRE		10		/* Start + 8 data + stop */
+#define CODEC_ITERATIONS			200000
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef enum{
+	HMI_TO_CTRL, CTRL_TO_HMI
+}Wire_Direction;
+
+typedef struct{
+	uint8 data[WIRE_MAX_BYTES];
+	Wire_Direction direction[WIRE_MAX_BYTES];
+	uint16 length;
+	uint16 readIndex;
+	uint32 fixedDelay_ms;
+}Wire_Type;
+
+typedef struct{
+	uint16 bytes;
+	uint16 turnarounds;
+	float64 latency_ms;
+}Wire_Result;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static Wire_Type g_wire;
+static Wire_Direction g_txDirection = HMI_TO_CTRL;
+
+/*******************************************************************************
+ *                 UART driver replacement (records the wire)                  *
+ *******************************************************************************/
+void UART_sendByte(const uint8 data)
+{
+	if(g_wire.length < WIRE_MAX_BYTES)
+	{
+		g_wire.data[g_wire.length] = data;
+		g_wire.direction[g_wire.length] = g_txDirection;
+		g_wire.length++;
+	}
+}
+
+uint8 UART_recieveByte(void)
+{
+	if(g_wire.readIndex >= g_wire.length)
+	{
+		fprintf(stderr, "wire underrun\n");
+		exit(1);
+	}
+	return g_wire.data[g_wire.readIndex++];
+}
+
+uint8 UART_tryReceive(uint8 *data_Ptr)
+{
+	if(g_wire.readIndex >= g_wire.length)
+	{
+		return FALSE;
+	}
+	*data_Ptr = g_wire.data[g_wire.readIndex++];
+	return TRUE;
+}
+
+/* The benchmark link runs at a fixed baud rate, the negotiation is not measured */
+uint8 UART_calculateBaudSetting(uint32 baud_rate, UART_BaudSettingType *Setting_Ptr)
+{
+	(void)Setting_Ptr;
+	return (baud_rate == UART_DEFAULT_BAUD_RATE);
+}
+
+uint8 UART_setBaudRate(uint32 baud_rate)
+{
+	return (baud_rate == UART_DEFAULT_BAUD_RATE);
+}
+
+uint32 UART_getBaudRate(void)
+{
+	return UART_DEFAULT_BAUD_RATE;
+}
+
+void UART_flush(void)
+{
+}
+
+/* The recorded wire has no line errors */
+uint8 UART_getLineErrors(void)
+{
+	return 0;
+}
+
+/* The recorded wire never times out */
+uint16 UART_getTime(void)
+{
+	return 0;
+}
+
+/* Frame receive: the wire is already recorded, so the frame is parsed when it is polled */
+static uint8 *g_frameBuffer_Ptr;
+static uint8 g_frameMaxLength;
+
+void UART_receiveFrameInto(uint8 *buffer_Ptr, uint8 maxLength, UART_FrameCallBackType a_callBack_Ptr)
+{
+	(void)a_callBack_Ptr;
+	g_frameBuffer_Ptr = buffer_Ptr;
+	g_frameMaxLength = maxLength;
+}
+
+uint8 UART_isFrameReceived(uint8 *type_Ptr, uint8 *length_Ptr)
+{
+	uint8 data, length, crc = 0;
+	uint8 i;
+
+	do
+	{
+		data = UART_recieveByte();
+	}while(data != FRAME_START_BYTE);
+
+	*type_Ptr = UART_recieveByte();
+	length = UART_recieveByte();
+	FRAME_CRC8_UPDATE(crc, *type_Ptr);
+	FRAME_CRC8_UPDATE(crc, length);
+	for(i = 0; i < length; i++)
+	{
+		data = UART_recieveByte();
+		FRAME_CRC8_UPDATE(crc, data);
+		if(i < g_frameMaxLength)
+		{
+			g_frameBuffer_Ptr[i] = data;
+		}
+	}
+	*length_Ptr = length;
+	return (UART_recieveByte() == crc) && (length <= g_frameMaxLength);
+}
+
+void UART_cancelFrameReceive(void)
+{
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+static void Wire_reset(void)
+{
+	g_wire.length = 0;
+	g_wire.readIndex = 0;
+	g_wire.fixedDelay_ms = 0;
+}
+
+static void Wire_put(Wire_Direction direction, uint8 data)
+{
+	g_txDirection = direction;
+	UART_sendByte(data);
+}
+
+/*
+ * Description :
+ * Bytes are serialized on one link, every byte costs its time on the wire and every
+ * change of direction costs the reaction time of the other ECU.
+ */
+static Wire_Result Wire_evaluate(uint32 baudRate, uint32 turnaround_us)
+{
+	Wire_Result result = {0, 0, 0.0};
+	float64 byteTime_us = (BITS_PER_BYTE_ON_WIRE * 1000000.0) / baudRate;
+	float64 latency_us = 0.0;
+	uint16 i;
+
+	for(i = 0; i < g_wire.length; i++)
+	{
+		if((i > 0) && (g_wire.direction[i] != g_wire.direction[i - 1]))
+		{
+			result.turnarounds++;
+			latency_us += turnaround_us;
+		}
+		latency_us += byteTime_us;
+	}
+	result.bytes = g_wire.length;
+	result.latency_ms = (latency_us / 1000.0) + g_wire.fixedDelay_ms;
+	return result;
+}
+
+/*-------------------------- Legacy handshake protocol ---------------------------*/
+
+/* HMI_sendPasswordByUART/CTRL_receivePasswordByUART: one READY_TO_RECEIVE per digit */
+static void Legacy_sendPassword(const uint8 *password_Ptr)
+{
+	uint8 i;
+
+	Wire_put(HMI_TO_CTRL, LEGACY_READY_TO_SEND);
+	Wire_put(CTRL_TO_HMI, LEGACY_READY_TO_RECEIVE);
+	for(i = 0; i < PASSWORD_LENGTH; i++)
+	{
+		Wire_put(CTRL_TO_HMI, LEGACY_READY_TO_RECEIVE);
+		Wire_put(HMI_TO_CTRL, password_Ptr[i]);
+	}
+}
+
+static void Legacy_unlock(const uint8 *password_Ptr)
+{
+	Legacy_sendPassword(password_Ptr);
+	Wire_put(HMI_TO_CTRL, DOOR_OPEN_OPTION);
+	Wire_put(CTRL_TO_HMI, LEGACY_READY_TO_RECEIVE);
+	Wire_put(CTRL_TO_HMI, OPEN_DOOR);
+}
+
+static void Legacy_newPassword(const uint8 *password_Ptr)
+{
+	Legacy_sendPassword(password_Ptr);
+	g_wire.fixedDelay_ms += LEGACY_HMI_SEND_DELAY_MS;
+	Legacy_sendPassword(password_Ptr);
+	g_wire.fixedDelay_ms += LEGACY_HMI_SEND_DELAY_MS;
+	Wire_put(CTRL_TO_HMI, LEGACY_READY_TO_SEND);
+	Wire_put(CTRL_TO_HMI, PASSWORD_MATCHED);
+}
+
+/*------------------------------- Framed protocol --------------------------------*/
+
+/* Same payloads as HMI_sendCommand/CTRL_sendReply: sequence + option + password(s) */
+static void Framed_transaction(uint8 option, const uint8 *password_Ptr, uint8 withConfirmation,
+		uint8 reply)
+{
+	uint8 payload[2 + 2 * PASSWORD_LENGTH];
+	uint8 replyPayload[2];
+	uint8 length = 2 + PASSWORD_LENGTH;
+	uint8 i;
+
+	payload[0] = 1;
+	payload[1] = option;
+	for(i = 0; i < PASSWORD_LENGTH; i++)
+	{
+		payload[2 + i] = password_Ptr[i];
+		payload[2 + PASSWORD_LENGTH + i] = password_Ptr[i];
+	}
+	if(withConfirmation)
+	{
+		length += PASSWORD_LENGTH;
+	}
+	replyPayload[0] = payload[0];
+	replyPayload[1] = reply;
+
+	g_txDirection = HMI_TO_CTRL;
+	FRAME_send(FRAME_TYPE_COMMAND, payload, length);
+	g_txDirection = CTRL_TO_HMI;
+	FRAME_send(FRAME_TYPE_REPLY, replyPayload, 2);
+}
+
+/* Decode the recorded frames with the firmware receiver to make sure the wire is valid */
+static void Framed_check(void)
+{
+	FRAME_Type frame;
+
+	g_wire.readIndex = 0;
+	if((FRAME_receive(&frame) != FRAME_OK) || (frame.type != FRAME_TYPE_COMMAND)
+			|| (FRAME_receive(&frame) != FRAME_OK) || (frame.type != FRAME_TYPE_REPLY))
+	{
+		fprintf(stderr, "framed transaction does not decode\n");
+		exit(1);
+	}
+}
+
+/* Host CPU time of encoding and decoding one framed unlock transaction */
+static float64 Framed_codecTime_ns(const uint8 *password_Ptr)
+{
+	struct timespec start, end;
+	uint32 i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < CODEC_ITERATIONS; i++)
+	{
+		Wire_reset();
+		Framed_transaction(DOOR_OPEN_OPTION, password_Ptr, FALSE, OPEN_DOOR);
+		Framed_check();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec)) / CODEC_ITERATIONS;
+}
+
+static void printRow(const char *name, Wire_Result legacy, Wire_Result framed)
+{
+	printf("%-16s | %6u %6u %12.3f | %6u %6u %12.3f | %6.2fx\n", name,
+			legacy.bytes, legacy.turnarounds, legacy.latency_ms,
+			framed.bytes, framed.turnarounds, framed.latency_ms,
+			legacy.latency_ms / framed.latency_ms);
+}
+
+int main(int argc, char *argv[])
+{
+	const uint8 password[PASSWORD_LENGTH] = {1, 2, 3, 4, 5};
+	uint32 baudRate = DEFAULT_BAUD_RATE;
+	uint32 turnaround_us = DEFAULT_TURNAROUND_US;
+	Wire_Result legacy, framed;
+
+	if(argc > 1)
+	{
+		baudRate = strtoul(argv[1], NULL, 10);
+	}
+	if(argc > 2)
+	{
+		turnaround_us = strtoul(argv[2], NULL, 10);
+	}
+	if(baudRate == 0)
+	{
+		fprintf(stderr, "usage: %s [baud_rate] [turnaround_us]\n", argv[0]);
+		return 1;
+	}
+
+	printf("Link: %lu baud, %lu us turnaround\n\n", (unsigned long)baudRate,
+			(unsigned long)turnaround_us);
+	printf("%-16s | %-26s | %-26s |\n", "", "legacy handshake", "framed");
+	printf("%-16s | %6s %6s %12s | %6s %6s %12s | %7s\n", "transaction",
+			"bytes", "turns", "latency[ms]", "bytes", "turns", "latency[ms]", "speedup");
+
+	Wire_reset();
+	Legacy_unlock(password);
+	legacy = Wire_evaluate(baudRate, turnaround_us);
+	Wire_reset();
+	Framed_transaction(DOOR_OPEN_OPTION, password, FALSE, OPEN_DOOR);
+	Framed_check();
+	framed = Wire_evaluate(baudRate, turnaround_us);
+	printRow("unlock", legacy, framed);
+
+	Wire_reset();
+	Legacy_newPassword(password);
+	legacy = Wire_evaluate(baudRate, turnaround_us);
+	Wire_reset();
+	Framed_transaction(NEW_PASSWORD_OPTION, password, TRUE, PASSWORD_MATCHED);
+	Framed_check();
+	framed = Wire_evaluate(baudRate, turnaround_us);
+	printRow("new password", legacy, framed);
+
+	printf("\nFramed unlock encode+decode on host: %.1f ns\n", Framed_codecTime_ns(password));
+	return 0;
+}
@@ -0,0 +1,206 @@
+ /******************************************************************************
+ *
+ * [Module]: Host Tools
+ *
+ * [File Name]: screen_benchmark.c
+ *
+ * [Description]: Host-side benchmark of the LCD framebuffer (HMI screen.c): LCD bus writes
+ * 				  (instructions + characters) of the HMI screen changes, redrawn with a clear
+ * 				  of the LCD (as before the framebuffer) and flushed from the framebuffer.
+ * 				  The LCD driver is replaced by counters of its calls.
+ *
+ * 				  Build and run (from Code/Host):
+ * 				  make screen_benchmark
+ * 				  ./screen_benchmark
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "std_types.h"
+#include "lcd.h"
+#include "screen.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SCREEN_LINES				2
+#define PASSWORD_ROW				3
+#define PASSWORD_COLUMN				12
+#define PASSWORD_DIGITS				5
+
+/* Typical execution times of the HD44780 (fosc = 270KHz) */
+#define LCD_WRITE_TIME_US			37
+#define LCD_CLEAR_TIME_US			1520
+
+/* Screen of the HMI: two lines from the first column, optional password cursor */
+typedef struct
+{
+	const char *name;
+	const char *line[SCREEN_LINES];
+	uint8 passwordCursor;
+} HMI_ScreenType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint32 g_lcdWrites = 0;
+static uint32 g_lcdTime_us = 0;
+
+/* Screen changes of an unlock, a wrong password and a password change */
+static const HMI_ScreenType g_screens[] = {
+	{"main options",	{"+: Open door", "-: Change password"},		FALSE},
+	{"enter password",	{"Enter Password:", "= : To submit"},		TRUE},
+	{"door opening",	{"Opening The Door...", NULL},				FALSE},
+	{"door holding",	{"Holding The Door", NULL},					FALSE},
+	{"door closing",	{"Closing The Door...", NULL},				FALSE},
+	{"main options",	{"+: Open door", "-: Change password"},		FALSE},
+	{"enter password",	{"Enter Password:", "= : To submit"},		TRUE},
+	{"wrong password",	{"Wrong Password", NULL},					FALSE},
+	{"main options",	{"+: Open door", "-: Change password"},		FALSE},
+	{"enter old",		{"Enter old Password:", "= : To submit"},	TRUE},
+	{"enter new",		{"Enter New Password:", "= : To submit"},	TRUE},
+	{"re-enter",		{"Re-enter Password:", "= : To submit"},	TRUE},
+	{"password saved",	{"Password Saved", NULL},					FALSE},
+	{"main options",	{"+: Open door", "-: Change password"},		FALSE},
+};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/* LCD driver: every instruction and character is one bus write, timed as executed by the LCD */
+void LCD_init(void)
+{
+}
+
+void LCD_sendCommand(uint8 command)
+{
+	g_lcdWrites++;
+	g_lcdTime_us += (command == LCD_CLEAR_COMMAND) ? LCD_CLEAR_TIME_US : LCD_WRITE_TIME_US;
+}
+
+void LCD_displayCharacter(uint8 data)
+{
+	(void)data;
+	g_lcdWrites++;
+	g_lcdTime_us += LCD_WRITE_TIME_US;
+}
+
+void LCD_displayString(const char *Str)
+{
+	g_lcdWrites += strlen(Str);
+	g_lcdTime_us += strlen(Str) * LCD_WRITE_TIME_US;
+}
+
+void LCD_moveCursor(uint8 row,uint8 col)
+{
+	(void)row;
+	(void)col;
+	g_lcdWrites++;
+	g_lcdTime_us += LCD_WRITE_TIME_US;
+}
+
+void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
+{
+	LCD_moveCursor(row,col);
+	LCD_displayString(Str);
+}
+
+void LCD_clearScreen(void)
+{
+	LCD_sendCommand(LCD_CLEAR_COMMAND);
+}
+
+/* Redraw of the screen as before the framebuffer */
+static void redrawScreen(const HMI_ScreenType *screen_Ptr)
+{
+	uint8 line;
+
+	LCD_clearScreen();
+	for(line = 0; line < SCREEN_LINES; line++)
+	{
+		if(screen_Ptr->line[line] != NULL)
+		{
+			LCD_displayStringRowColumn(line, 0, screen_Ptr->line[line]);
+		}
+	}
+	if(screen_Ptr->passwordCursor == TRUE)
+	{
+		LCD_moveCursor(PASSWORD_ROW, PASSWORD_COLUMN);
+	}
+}
+
+/* Same screen drawn in the framebuffer and flushed */
+static void flushScreen(const HMI_ScreenType *screen_Ptr)
+{
+	uint8 line;
+
+	SCREEN_clear();
+	for(line = 0; line < SCREEN_LINES; line++)
+	{
+		if(screen_Ptr->line[line] != NULL)
+		{
+			SCREEN_displayStringRowColumn(line, 0, screen_Ptr->line[line]);
+		}
+	}
+	if(screen_Ptr->passwordCursor == TRUE)
+	{
+		SCREEN_moveCursor(PASSWORD_ROW, PASSWORD_COLUMN);
+	}
+	SCREEN_flush();
+}
+
+/* LCD writes and time of one screen change */
+static void measure(void (*draw_Ptr)(const HMI_ScreenType *), const HMI_ScreenType *screen_Ptr,
+		uint32 *writes_Ptr, uint32 *time_us_Ptr)
+{
+	g_lcdWrites = 0;
+	g_lcdTime_us = 0;
+	(*draw_Ptr)(screen_Ptr);
+	*writes_Ptr = g_lcdWrites;
+	*time_us_Ptr = g_lcdTime_us;
+}
+
+int main(void)
+{
+	uint32 redrawWrites, redrawTime_us, flushWrites, flushTime_us;
+	uint32 redrawTotal = 0, redrawTotal_us = 0, flushTotal = 0, flushTotal_us = 0;
+	uint8 i;
+
+	SCREEN_init();
+
+	printf("LCD bus writes and LCD time of the HMI screen changes (%ux%u LCD)\n\n",
+			LCD_ROWS, LCD_COLUMNS);
+	printf("%-16s | %-17s | %-17s\n", "", "clear + redraw", "framebuffer flush");
+	printf("%-16s | %6s %10s | %6s %10s\n", "screen", "writes", "time[us]", "writes", "time[us]");
+	for(i = 0; i < sizeof(g_screens) / sizeof(g_screens[0]); i++)
+	{
+		measure(redrawScreen, &g_screens[i], &redrawWrites, &redrawTime_us);
+		measure(flushScreen, &g_screens[i], &flushWrites, &flushTime_us);
+		redrawTotal += redrawWrites;
+		redrawTotal_us += redrawTime_us;
+		flushTotal += flushWrites;
+		flushTotal_us += flushTime_us;
+		printf("%-16s | %6lu %10lu | %6lu %10lu\n", g_screens[i].name,
+				(unsigned long)redrawWrites, (unsigned long)redrawTime_us,
+				(unsigned long)flushWrites, (unsigned long)flushTime_us);
+	}
+	printf("%-16s | %6lu %10lu | %6lu %10lu\n", "all", (unsigned long)redrawTotal,
+			(unsigned long)redrawTotal_us, (unsigned long)flushTotal, (unsigned long)flushTotal_us);
+
+	/* Password digits: one '*' after the other */
+	flushScreen(&g_screens[1]);
+	g_lcdWrites = 0;
+	for(i = 0; i < PASSWORD_DIGITS; i++)
+	{
+		SCREEN_displayCharacter('*');
+		SCREEN_flush();
+	}
+	printf("\n%u password digits: %lu writes from the framebuffer (%u before)\n",
+			PASSWORD_DIGITS, (unsigned long)g_lcdWrites, PASSWORD_DIGITS);
+	return 0;
+}
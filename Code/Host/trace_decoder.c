@@ -0,0 +1,361 @@
+ /******************************************************************************
+ *
+ * [Module]: Host Tools
+ *
+ * [File Name]: trace_decoder.c
+ *
+ * [Description]: Host-side decoder of the UART link trace (UART_TRACE_ENABLE in uart.h).
+ * 				  It reads a capture of the ECU TX line that holds one or more trace dumps
+ * 				  (UART_traceDump), rebuilds the frames of both directions from the traced
+ * 				  bytes and prints the latency breakdown of every transaction:
+ * 				  - request: first to last byte of the request frame (payload on the wire)
+ * 				  - wait: last request byte to first reply byte, on the Control ECU trace it
+ * 				    is the command processing (EEPROM verify), on the HMI ECU trace it is
+ * 				    the whole wait for the Control ECU
+ * 				  - reply: first to last byte of the reply frame
+ *
+ * 				  Build and run (from Code/Host):
+ * 				  make trace_decoder	(or gcc -O2 -I../HMI_ECU -o trace_decoder trace_decoder.c)
+ * 				  ./trace_decoder capture.bin		(or - for stdin)
+ *
+ * [Author]: Mahmoud Khaled
+ *
+ *******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "std_types.h"
+#include "frame.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define TRACE_MAX_RECORDS			256
+#define TRACE_MAX_FRAMES			64
+#define TRACE_RECORD_SIZE			4
+#define TRACE_TX_BIT				0x80
+#define TRACE_MARKER_BIT			0x40
+#define TRACE_TICK_MASK				0x3F
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef struct{
+	uint8 data;
+	uint8 tx;
+	float64 time_us;
+}Trace_Record;
+
+/* Frame rebuilt from the traced bytes of one direction */
+typedef struct{
+	uint8 tx;
+	uint8 type;
+	uint8 length;
+	uint8 crcOk;
+	float64 start_us;
+	float64 end_us;
+	float64 maxGap_us;		/* Longest gap between two bytes of the frame */
+}Trace_Frame;
+
+typedef enum{
+	WAIT_START, WAIT_TYPE, WAIT_LENGTH, WAIT_PAYLOAD, WAIT_CRC
+}Parser_State;
+
+typedef struct{
+	Parser_State state;
+	Trace_Frame frame;
+	uint8 index;
+	uint8 crc;
+	float64 last_us;
+}Trace_Parser;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static Trace_Record g_records[TRACE_MAX_RECORDS];
+static uint16 g_numOfRecords;
+static Trace_Frame g_frames[TRACE_MAX_FRAMES];
+static uint16 g_numOfFrames;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/* Bitwise CRC-8 (polynomial 0x07), independent from the table used by the firmware */
+static uint8 crc8Update(uint8 crc, uint8 data)
+{
+	uint8 bit;
+
+	crc ^= data;
+	for(bit = 0; bit < 8; bit++)
+	{
+		crc = (crc & 0x80) ? (uint8)((crc << 1) ^ FRAME_CRC8_POLYNOMIAL) : (uint8)(crc << 1);
+	}
+	return crc;
+}
+
+static const char *typeName(uint8 type)
+{
+	switch(type)
+	{
+	case FRAME_TYPE_COMMAND:		return "COMMAND";
+	case FRAME_TYPE_REPLY:			return "REPLY";
+	case FRAME_TYPE_BAUD_REQUEST:	return "BAUD_REQ";
+	case FRAME_TYPE_BAUD_ACCEPT:	return "BAUD_ACC";
+	case FRAME_TYPE_BAUD_CONFIRM:	return "BAUD_CFM";
+	case FRAME_TYPE_TRACE_INFO:		return "TRACE_INF";
+	case FRAME_TYPE_TRACE_DATA:		return "TRACE_DAT";
+	default:						return "?";
+	}
+}
+
+/*
+ * Description :
+ * Frame parser of the traced bytes, the same rules as the firmware parser (uart.c) except the
+ * frames with wrong CRC are kept to be reported.
+ */
+static void Parser_byte(Trace_Parser *parser_Ptr, const Trace_Record *record_Ptr)
+{
+	Trace_Frame *frame_Ptr = &parser_Ptr->frame;
+	float64 gap = record_Ptr->time_us - parser_Ptr->last_us;
+
+	parser_Ptr->last_us = record_Ptr->time_us;
+	if((parser_Ptr->state != WAIT_START) && (gap > frame_Ptr->maxGap_us))
+	{
+		frame_Ptr->maxGap_us = gap;
+	}
+
+	switch(parser_Ptr->state)
+	{
+	case WAIT_START:
+		if(record_Ptr->data == FRAME_START_BYTE)
+		{
+			memset(frame_Ptr, 0, sizeof(*frame_Ptr));
+			frame_Ptr->tx = record_Ptr->tx;
+			frame_Ptr->start_us = record_Ptr->time_us;
+			parser_Ptr->crc = FRAME_CRC8_INITIAL_VALUE;
+			parser_Ptr->state = WAIT_TYPE;
+		}
+		break;
+	case WAIT_TYPE:
+		frame_Ptr->type = record_Ptr->data;
+		parser_Ptr->crc = crc8Update(parser_Ptr->crc, record_Ptr->data);
+		parser_Ptr->state = WAIT_LENGTH;
+		break;
+	case WAIT_LENGTH:
+		if(record_Ptr->data > FRAME_MAX_PAYLOAD_LENGTH)
+		{
+			parser_Ptr->state = WAIT_START;
+			break;
+		}
+		frame_Ptr->length = record_Ptr->data;
+		parser_Ptr->index = 0;
+		parser_Ptr->crc = crc8Update(parser_Ptr->crc, record_Ptr->data);
+		parser_Ptr->state = (record_Ptr->data == 0) ? WAIT_CRC : WAIT_PAYLOAD;
+		break;
+	case WAIT_PAYLOAD:
+		parser_Ptr->index++;
+		parser_Ptr->crc = crc8Update(parser_Ptr->crc, record_Ptr->data);
+		if(parser_Ptr->index == frame_Ptr->length)
+		{
+			parser_Ptr->state = WAIT_CRC;
+		}
+		break;
+	case WAIT_CRC:
+		frame_Ptr->crcOk = (record_Ptr->data == parser_Ptr->crc);
+		frame_Ptr->end_us = record_Ptr->time_us;
+		if(g_numOfFrames < TRACE_MAX_FRAMES)
+		{
+			g_frames[g_numOfFrames++] = *frame_Ptr;
+		}
+		parser_Ptr->state = WAIT_START;
+		break;
+	}
+}
+
+/* Frames complete in the order of their last byte, the transactions need the start order */
+static void sortFrames(void)
+{
+	uint16 i, j;
+	Trace_Frame frame;
+
+	for(i = 1; i < g_numOfFrames; i++)
+	{
+		frame = g_frames[i];
+		for(j = i; (j > 0) && (g_frames[j - 1].start_us > frame.start_us); j--)
+		{
+			g_frames[j] = g_frames[j - 1];
+		}
+		g_frames[j] = frame;
+	}
+}
+
+static void analyzeTrace(uint16 dumpNumber)
+{
+	Trace_Parser parsers[2];
+	uint16 i, transactions = 0, replied = 0;
+	float64 sumRequest = 0.0, sumWait = 0.0, sumReply = 0.0;
+	const Trace_Frame *request_Ptr, *reply_Ptr;
+
+	memset(parsers, 0, sizeof(parsers));
+	g_numOfFrames = 0;
+	for(i = 0; i < g_numOfRecords; i++)
+	{
+		Parser_byte(&parsers[g_records[i].tx], &g_records[i]);
+	}
+	sortFrames();
+
+	printf("\nDump %u: %u bytes, %u frames\n", dumpNumber, g_numOfRecords, g_numOfFrames);
+	printf("%3s %-5s %-9s %5s %11s %10s %9s %-9s %11s %10s\n", "#", "dir", "request", "bytes",
+			"request[ms]", "gap[ms]", "wait[ms]", "reply", "reply[ms]", "total[ms]");
+
+	for(i = 0; i < g_numOfFrames; i++)
+	{
+		request_Ptr = &g_frames[i];
+		reply_Ptr = NULL;
+		if(((i + 1) < g_numOfFrames) && (g_frames[i + 1].tx != request_Ptr->tx))
+		{
+			reply_Ptr = &g_frames[++i];
+		}
+
+		printf("%3u %-5s %-9s %5u %11.3f %10.3f", transactions + 1,
+				request_Ptr->tx ? "TX" : "RX", typeName(request_Ptr->type),
+				request_Ptr->length + FRAME_OVERHEAD_LENGTH,
+				(request_Ptr->end_us - request_Ptr->start_us) / 1000.0,
+				request_Ptr->maxGap_us / 1000.0);
+		if(reply_Ptr != NULL)
+		{
+			printf(" %9.3f %-9s %11.3f %10.3f",
+					(reply_Ptr->start_us - request_Ptr->end_us) / 1000.0,
+					typeName(reply_Ptr->type),
+					(reply_Ptr->end_us - reply_Ptr->start_us) / 1000.0,
+					(reply_Ptr->end_us - request_Ptr->start_us) / 1000.0);
+			sumRequest += request_Ptr->end_us - request_Ptr->start_us;
+			sumWait += reply_Ptr->start_us - request_Ptr->end_us;
+			sumReply += reply_Ptr->end_us - reply_Ptr->start_us;
+			replied++;
+		}
+		else
+		{
+			printf(" %9s %-9s", "-", "(none)");
+		}
+		transactions++;
+		if((request_Ptr->crcOk == FALSE) || ((reply_Ptr != NULL) && (reply_Ptr->crcOk == FALSE)))
+		{
+			printf("  CRC error");
+		}
+		printf("\n");
+	}
+
+	if(replied != 0)
+	{
+		printf("average of %u replied: request %.3f ms, wait %.3f ms, reply %.3f ms\n", replied,
+				sumRequest / 1000.0 / replied, sumWait / 1000.0 / replied,
+				sumReply / 1000.0 / replied);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *file;
+	Trace_Parser capture;
+	Trace_Record byte;
+	uint8 payload[FRAME_MAX_PAYLOAD_LENGTH];
+	float64 tick_us = 0.0, counts = 1.0;
+	uint32 ticks = 0;
+	uint8 lastTick = 0;
+	uint16 dumps = 0;
+	uint8 i;
+	int c;
+
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage: %s capture.bin|-\n", argv[0]);
+		return 1;
+	}
+	file = (strcmp(argv[1], "-") == 0) ? stdin : fopen(argv[1], "rb");
+	if(file == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+
+	/* The capture itself is parsed with the same frame parser, the payload is kept here */
+	memset(&capture, 0, sizeof(capture));
+	memset(&byte, 0, sizeof(byte));
+	while((c = fgetc(file)) != EOF)
+	{
+		byte.data = (uint8)c;
+		if((capture.state == WAIT_PAYLOAD) && (capture.index < FRAME_MAX_PAYLOAD_LENGTH))
+		{
+			payload[capture.index] = byte.data;
+		}
+		g_numOfFrames = 0;
+		Parser_byte(&capture, &byte);
+		if((g_numOfFrames == 0) || (g_frames[0].crcOk == FALSE))
+		{
+			continue;
+		}
+
+		if((g_frames[0].type == FRAME_TYPE_TRACE_INFO) && (g_frames[0].length == 4))
+		{
+			tick_us = payload[0] * 1000.0;
+			counts = (payload[1] << 8) | payload[2];
+			g_numOfRecords = 0;
+			ticks = 0;
+			lastTick = 0;
+		}
+		else if((g_frames[0].type == FRAME_TYPE_TRACE_DATA) && (g_frames[0].length == 0))
+		{
+			analyzeTrace(++dumps);
+			g_numOfRecords = 0;
+		}
+		else if(g_frames[0].type == FRAME_TYPE_TRACE_DATA)
+		{
+			for(i = 0; (i + TRACE_RECORD_SIZE) <= g_frames[0].length; i += TRACE_RECORD_SIZE)
+			{
+				uint8 tick = payload[i + 1] & TRACE_TICK_MASK;
+				uint16 counter = (payload[i + 2] << 8) | payload[i + 3];
+
+				if(g_numOfRecords == TRACE_MAX_RECORDS)
+				{
+					break;
+				}
+				/* A marker gives the ticks passed since the last record (bits 16-23 in its data
+				 * byte), before the first record they are not needed */
+				if(payload[i + 1] & TRACE_MARKER_BIT)
+				{
+					if(g_numOfRecords != 0)
+					{
+						ticks += ((uint32)payload[i] << 16) | counter;
+					}
+					lastTick = tick;
+					continue;
+				}
+				/* Without a marker the record is less than 64 ticks after the last one */
+				if(g_numOfRecords != 0)
+				{
+					ticks += (uint8)(tick - lastTick) & TRACE_TICK_MASK;
+				}
+				lastTick = tick;
+
+				g_records[g_numOfRecords].data = payload[i];
+				g_records[g_numOfRecords].tx = (payload[i + 1] & TRACE_TX_BIT) ? 1 : 0;
+				g_records[g_numOfRecords].time_us = (ticks * tick_us) + ((counter * tick_us) / counts);
+				g_numOfRecords++;
+			}
+		}
+	}
+
+	if(file != stdin)
+	{
+		fclose(file);
+	}
+	if(dumps == 0)
+	{
+		fprintf(stderr, "no trace dump in the capture\n");
+		return 1;
+	}
+	return 0;
+}